@@ -18,15 +18,28 @@
 #ifndef ALICEO2_CDB_CONDITIONSMQCLIENT_H_
 #define ALICEO2_CDB_CONDITIONSMQCLIENT_H_
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <FairMQDevice.h>
 
+#include "CCDB/ObjectCache.h"
+
 namespace o2 {
 namespace CDB {
 
+class Backend;
+
 class ConditionsMQClient : public FairMQDevice {
 public:
+  using BlobPtr = ObjectCache<std::string>::ObjectPtr;
+
   ConditionsMQClient();
   ~ConditionsMQClient() override;
 
@@ -35,12 +48,40 @@ protected:
   void Run() override;
 
 private:
+  /// A pending GET of the fetching thread, the promise is empty for prefetch requests
+  struct FetchRequest {
+    std::string key;
+    std::shared_ptr<std::promise<BlobPtr>> promise;
+  };
+
+  /// Returns the serialized condition for the key, from the local cache if the server still resolves the key to
+  /// the cached condition, fetching it from the server otherwise
+  BlobPtr getCondition(const std::string& key);
+
+  /// Queues the request to the fetching thread, requests with a promise are served first
+  void queueRequest(FetchRequest request);
+
+  /// Serves the queued requests, it is the only user of the data-get channel
+  void fetchLoop();
+
+  /// Blocking request/reply for a single condition, validating the cached copy with the server
+  BlobPtr requestCondition(const std::string& key);
+
   int mRunId;
   std::string mParameterName;
   std::string mOperationType;
   std::string mDataSource;
   std::string mObjectPath;
+  std::vector<std::string> mPrefetchKeys; ///< keys of conditions to be fetched upfront
+
+  std::unique_ptr<Backend> mBackend;
+  ObjectCache<std::string> mCache;                  ///< serialized conditions received, per condition id
+  std::map<std::string, std::string> mConditionIds; ///< id of the condition last received for each key
 
+  std::deque<FetchRequest> mRequests;
+  std::mutex mRequestsMutex;
+  std::condition_variable mRequestsCondition;
+  bool mStopFetching = false;
 };
 }
 }
@@ -18,11 +18,15 @@
 #ifndef ALICEO2_CDB_CONDITIONSMQSERVER_H_
 #define ALICEO2_CDB_CONDITIONSMQSERVER_H_
 
+#include <memory>
 #include <string>
 
 #include "CCDB/Manager.h"
+#include "CCDB/ObjectCache.h"
 #include "ParameterMQServer.h"
 
+class TMessage;
+
 namespace o2 {
 namespace CDB {
 
@@ -39,13 +43,20 @@ public:
 private:
   Manager* mCdbManager;
 
-  void getFromOCDB(std::string key);
+  /// already serialized conditions per id (path, run range and version) of the stored object, sent to all
+  /// clients requesting them without re-serialization
+  ObjectCache<TMessage> mBlobCache;
+
+  /// Replies with the condition stored for the key, preceded by its id if @a withId is set: the condition
+  /// itself is then left out if the client has cached it already as @a cachedId
+  void getFromOCDB(std::string key, bool withId, const std::string& cachedId);
 
   /// Parses a serialized message for a data source entry
   void ParseDataSource(std::string& dataSource, const std::string& data);
 
-  /// Deserializes a message and stores the value to an std::string using Protocol Buffers
-  void Deserialize(const std::string& messageString, std::string& key);
+  /// Deserializes a message and stores the key to an std::string using Protocol Buffers, returns whether the
+  /// client asks for the id of the condition, with the id of the one it has cached in @a cachedId
+  bool Deserialize(const std::string& messageString, std::string& key, std::string& cachedId);
 };
 }
 }
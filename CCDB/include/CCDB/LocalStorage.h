@@ -17,6 +17,9 @@
 #include "Rtypes.h"   // for Bool_t, Int_t, ClassDef, LocalStorage::Class, etc
 #include "CCDB/Storage.h"  // for Storage
 #include "TString.h"  // for TString
+#include <map>        // for map
+#include <string>     // for string
+#include <vector>     // for vector
 
 class TList;
 
@@ -84,8 +87,33 @@ class LocalStorage : public Storage
 
     void getEntriesForLevel1(const char *level0, const char *Level1, const ConditionId &query, TList *result);
 
+    /// run range and version of a stored object, as encoded in its file name
+    struct IndexEntry {
+      Int_t firstRun;
+      Int_t lastRun;
+      Int_t version;
+      Int_t subVersion;
+    };
+
+    /// cached content of the directory of a single path
+    struct PathIndex {
+      Long_t modTime = -1;  // modification time of the directory when it was scanned
+      Long_t scanTime = -1; // time of the scan
+      size_t numFiles = 0;  // number of files in the directory, objects or not
+      std::vector<IndexEntry> entries;
+    };
+
+    /// get the index of the objects stored for a path, scanning its directory only if it was
+    /// modified since the last scan; returns nullptr if the path directory does not exist
+    const std::vector<IndexEntry> *getPathIndex(const TString &path);
+
+    /// register a newly stored object in the index of its path
+    void addToPathIndex(const ConditionId &id);
+
     TString mBaseDirectory; // path of the DB folder
 
+    std::map<std::string, PathIndex> mPathIndex; //! per path index of stored objects
+
   ClassDefOverride(LocalStorage, 0) // access class to a DataBase in a local storage
 };
 
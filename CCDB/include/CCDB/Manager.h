@@ -140,6 +140,12 @@ class Manager : public TObject
 
     Condition *getCondition(const IdPath &path, const IdRunRange &runRange, Int_t version = -1, Int_t subVersion = -1);
 
+    ConditionId *getId(const ConditionId &query);
+
+    ConditionId *getId(const IdPath &path, Int_t runNumber = -1, Int_t version = -1, Int_t subVersion = -1);
+
+    ConditionId *getId(const IdPath &path, const IdRunRange &runRange, Int_t version = -1, Int_t subVersion = -1);
+
     Condition *getConditionFromSnapshot(const char *path);
 
     const char *getUri(const char *path);
@@ -285,12 +291,6 @@ class Manager : public TObject
 
     StorageParameters *selectSpecificStorage(const TString &path);
 
-    ConditionId *getId(const ConditionId &query);
-
-    ConditionId *getId(const IdPath &path, Int_t runNumber = -1, Int_t version = -1, Int_t subVersion = -1);
-
-    ConditionId *getId(const IdPath &path, const IdRunRange &runRange, Int_t version = -1, Int_t subVersion = -1);
-
     TList mFactories;       //! list of registered storage factories
     TMap mActiveStorages;   //! list of active storages
     TMap mSpecificStorages; //! list of detector-specific storages
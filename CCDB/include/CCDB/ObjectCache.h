@@ -0,0 +1,126 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ObjectCache.h
+/// \brief Definition of the ObjectCache class, a size limited LRU cache for serialized conditions
+
+#ifndef ALICE_O2_OBJECTCACHE_H_
+#define ALICE_O2_OBJECTCACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace o2 {
+namespace CDB {
+
+/// Thread safe cache of serialized objects, keyed by the condition key (path, run range and version),
+/// with least recently used eviction once the number of cached objects exceeds the capacity.
+/// The objects are shared, so that an evicted object stays valid for users still holding it.
+template <typename T>
+class ObjectCache {
+public:
+  using Key = std::string;
+  using ObjectPtr = std::shared_ptr<const T>;
+
+  ObjectCache(size_t capacity = 100) : mCapacity(capacity) {}
+
+  void setCapacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCapacity = capacity;
+    evict();
+  }
+
+  size_t getCapacity() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCapacity;
+  }
+
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIndex.size();
+  }
+
+  /// Returns the cached object for the key, or an empty pointer if not cached
+  ObjectPtr get(const Key& key)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mIndex.find(key);
+    if (iter == mIndex.end()) {
+      mMisses++;
+      return ObjectPtr();
+    }
+    mHits++;
+    // move to front as most recently used
+    mEntries.splice(mEntries.begin(), mEntries, iter->second);
+    return iter->second->second;
+  }
+
+  /// Adds or replaces the object for the key
+  void put(const Key& key, ObjectPtr object)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mIndex.find(key);
+    if (iter != mIndex.end()) {
+      iter->second->second = std::move(object);
+      mEntries.splice(mEntries.begin(), mEntries, iter->second);
+      return;
+    }
+    mEntries.emplace_front(key, std::move(object));
+    mIndex[key] = mEntries.begin();
+    evict();
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mIndex.clear();
+  }
+
+  size_t getHits() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mHits;
+  }
+
+  size_t getMisses() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMisses;
+  }
+
+private:
+  void evict()
+  {
+    while (mIndex.size() > mCapacity) {
+      mIndex.erase(mEntries.back().first);
+      mEntries.pop_back();
+    }
+  }
+
+  using Entry = std::pair<Key, ObjectPtr>;
+
+  size_t mCapacity;
+  size_t mHits = 0;
+  size_t mMisses = 0;
+  std::list<Entry> mEntries; // ordered from most to least recently used
+  std::unordered_map<Key, typename std::list<Entry>::iterator> mIndex;
+  mutable std::mutex mMutex;
+};
+}
+}
+#endif
@@ -29,9 +29,16 @@
 #include "CCDB/BackendRiak.h"
 #include "CCDB/ConditionsMQClient.h"
 #include <FairMQLogger.h>
+#include <FairMQParts.h>
 #include <options/FairMQProgOptions.h>
 
 #include "boost/filesystem.hpp"
+#include <boost/algorithm/string.hpp>
+
+// Google protocol buffers headers
+#include "request.pb.h"
+
+#include <thread>
 
 using namespace o2::CDB;
 using namespace std;
@@ -42,32 +49,149 @@ ConditionsMQClient::~ConditionsMQClient() = default;
 
 void CustomCleanup(void* data, void* hint) { delete static_cast<std::string*>(hint); }
 
+// release the reference on a cached blob held by a message
+void ReleaseCachedBlob(void* data, void* hint) { delete static_cast<ConditionsMQClient::BlobPtr*>(hint); }
+
 void ConditionsMQClient::InitTask()
 {
   mParameterName = GetConfig()->GetValue<string>("parameter-name");
   mOperationType = GetConfig()->GetValue<string>("operation-type");
   mDataSource = GetConfig()->GetValue<string>("data-source");
   mObjectPath = GetConfig()->GetValue<string>("object-path");
+  mCache.setCapacity(GetConfig()->GetValue<int>("cache-size"));
+
+  mPrefetchKeys.clear();
+  auto prefetchKeys = GetConfig()->GetValue<string>("prefetch-keys");
+  if (!prefetchKeys.empty()) {
+    boost::split(mPrefetchKeys, prefetchKeys, boost::is_any_of(","));
+  }
+}
+
+ConditionsMQClient::BlobPtr ConditionsMQClient::getCondition(const std::string& key)
+{
+  // the server is asked in any case, since a newer version might have been stored for the key
+  FetchRequest request{ key, std::make_shared<std::promise<BlobPtr>>() };
+  auto reply = request.promise->get_future();
+  queueRequest(std::move(request));
+  return reply.get();
+}
+
+void ConditionsMQClient::queueRequest(FetchRequest request)
+{
+  {
+    std::lock_guard<std::mutex> lock(mRequestsMutex);
+    if (request.promise) {
+      mRequests.emplace_front(std::move(request)); // someone is waiting for it, serve before prefetches
+    } else {
+      mRequests.emplace_back(std::move(request));
+    }
+  }
+  mRequestsCondition.notify_one();
+}
+
+void ConditionsMQClient::fetchLoop()
+{
+  while (true) {
+    FetchRequest request;
+    {
+      std::unique_lock<std::mutex> lock(mRequestsMutex);
+      mRequestsCondition.wait(lock, [this] { return mStopFetching || !mRequests.empty(); });
+      if (mStopFetching) {
+        break;
+      }
+      request = std::move(mRequests.front());
+      mRequests.pop_front();
+    }
+    try {
+      auto blob = requestCondition(request.key);
+      if (request.promise) {
+        request.promise->set_value(blob);
+      }
+    } catch (const std::exception& e) {
+      // the waiting caller gets the failure, a failed prefetch is just retried when the key is requested
+      if (request.promise) {
+        request.promise->set_exception(std::current_exception());
+      } else {
+        LOG(ERROR) << "Prefetching condition " << request.key << " failed: " << e.what();
+      }
+    }
+  }
+}
+
+ConditionsMQClient::BlobPtr ConditionsMQClient::requestCondition(const std::string& key)
+{
+  // the id of the condition cached for the key goes with the request, the server then sends the condition only
+  // if the key now resolves to another one
+  BlobPtr cached;
+  std::string cachedId;
+  auto knownId = mConditionIds.find(key);
+  if (knownId != mConditionIds.end()) {
+    cached = mCache.get(knownId->second);
+    if (cached) {
+      cachedId = knownId->second;
+    }
+  }
+
+  messaging::RequestMessage requestMessage;
+  requestMessage.set_command("GET");
+  requestMessage.set_datasource(mDataSource);
+  requestMessage.set_key(key);
+  requestMessage.set_cachedid(cachedId);
+  std::string* messageString = new string();
+  requestMessage.SerializeToString(messageString);
+
+  unique_ptr<FairMQMessage> request(fTransportFactory->CreateMessage(
+    const_cast<char*>(messageString->c_str()), messageString->length(), CustomCleanup, messageString));
+  FairMQParts reply;
+
+  if (Send(request, "data-get") <= 0 || Receive(reply, "data-get") <= 0) {
+    return BlobPtr();
+  }
+  if (reply.Size() == 1) {
+    // the Riak broker replies with the condition only, there is no id to validate a cached copy against
+    LOG(DEBUG) << "Received a condition with a size of " << reply.At(0)->GetSize();
+    return std::make_shared<const std::string>(static_cast<char*>(reply.At(0)->GetData()), reply.At(0)->GetSize());
+  }
+
+  std::string id(static_cast<char*>(reply.At(0)->GetData()), reply.At(0)->GetSize());
+  if (id.empty()) {
+    mConditionIds.erase(key);
+    return BlobPtr();
+  }
+  mConditionIds[key] = id;
+  if (id == cachedId) {
+    return cached;
+  }
+  LOG(DEBUG) << "Received condition " << id << " with a size of " << reply.At(1)->GetSize();
+  auto blob = std::make_shared<const std::string>(static_cast<char*>(reply.At(1)->GetData()), reply.At(1)->GetSize());
+  mCache.put(id, blob);
+  return blob;
 }
 
 void ConditionsMQClient::Run()
 {
-  Backend* backend;
+  if (mDataSource == "OCDB") {
+    mBackend = std::make_unique<BackendOCDB>();
+  } else if (mDataSource == "Riak") {
+    mBackend = std::make_unique<BackendRiak>();
+  } else {
+    LOG(ERROR) << R"(")" << mDataSource << R"(" is not a valid Data Source)";
+    return;
+  }
+  Backend* backend = mBackend.get();
+
+  // the conditions declared upfront are fetched asynchronously while the device proceeds
+  mStopFetching = false;
+  for (const auto& key : mPrefetchKeys) {
+    queueRequest(FetchRequest{ key, nullptr });
+  }
+  std::thread fetcher(&ConditionsMQClient::fetchLoop, this);
 
   while (CheckCurrentState(RUNNING)) {
 
     boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
     boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::local_time();
 
-    if (mDataSource == "OCDB") {
-      backend = new BackendOCDB();
-    } else if (mDataSource == "Riak") {
-      backend = new BackendRiak();
-    } else {
-      LOG(ERROR) << R"(")" << mDataSource << R"(" is not a valid Data Source)";
-      return;
-    }
-
     boost::filesystem::path dataPath(mObjectPath);
     boost::filesystem::recursive_directory_iterator endIterator;
 
@@ -84,18 +208,18 @@ void ConditionsMQClient::Run()
           std::string key = str.substr(0, pos);
 
           if (mOperationType == "GET") {
-            std::string* messageString = new string();
-            backend->Serialize(messageString, key, mOperationType, mDataSource);
-
-            unique_ptr<FairMQMessage> request(fTransportFactory->CreateMessage(
-              const_cast<char*>(messageString->c_str()), messageString->length(), CustomCleanup, messageString));
-            unique_ptr<FairMQMessage> reply(fTransportFactory->CreateMessage());
-
-            if (fChannels.at("data-get").at(0).Send(request) > 0) {
-              if (fChannels.at("data-get").at(0).Receive(reply) > 0) {
-                LOG(DEBUG) << "Received a condition with a size of " << reply->GetSize();
-                backend->UnPack(std::move(reply));
-              }
+            BlobPtr blob;
+            try {
+              blob = getCondition(key);
+            } catch (const std::exception& e) {
+              LOG(ERROR) << "Getting condition " << key << " failed: " << e.what();
+            }
+            if (blob) {
+              // wrap the cached blob in a message without copying it
+              auto hint = new BlobPtr(blob);
+              unique_ptr<FairMQMessage> reply(fTransportFactory->CreateMessage(
+                const_cast<char*>(blob->data()), blob->size(), ReleaseCachedBlob, hint));
+              backend->UnPack(std::move(reply));
             }
           } else if (mOperationType == "PUT") {
             std::string* messageString = new string();
@@ -116,5 +240,15 @@ void ConditionsMQClient::Run()
 
     boost::posix_time::ptime endTime = boost::posix_time::microsec_clock::local_time();
     LOG(DEBUG) << " Time elapsed: " << (endTime - startTime).total_milliseconds() << "ms";
+    LOG(DEBUG) << " Conditions cache: " << mCache.size() << " objects, " << mCache.getHits() << " hits, "
+               << mCache.getMisses() << " misses";
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mRequestsMutex);
+    mStopFetching = true;
+    mRequests.clear();
   }
+  mRequestsCondition.notify_one();
+  fetcher.join();
 }
@@ -26,9 +26,11 @@
 #include "Rtypes.h"
 
 #include "CCDB/Condition.h"
+#include "CCDB/ConditionId.h"
 #include "CCDB/ConditionsMQServer.h"
 #include "CCDB/IdPath.h"
 #include <FairMQLogger.h>
+#include <FairMQParts.h>
 #include <FairMQPoller.h>
 
 // Google protocol buffers headers
@@ -63,9 +65,9 @@ void ConditionsMQServer::InitTask()
       mCdbManager->setDefaultStorage(GetOutputName().c_str());
     }
   }
-}
 
-void free_tmessage(void* data, void* hint) { delete static_cast<TMessage*>(hint); }
+  mBlobCache.setCapacity(GetConfig()->GetValue<int>("cache-size"));
+}
 
 void ConditionsMQServer::ParseDataSource(std::string& dataSource, const std::string& data)
 {
@@ -79,14 +81,17 @@ void ConditionsMQServer::ParseDataSource(std::string& dataSource, const std::str
   delete msgReply;
 }
 
-void ConditionsMQServer::Deserialize(const std::string& messageString, std::string& object)
+bool ConditionsMQServer::Deserialize(const std::string& messageString, std::string& key, std::string& cachedId)
 {
   messaging::RequestMessage* requestMessage = new messaging::RequestMessage;
   requestMessage->ParseFromString(messageString);
 
-  object.assign(requestMessage->key());
+  key.assign(requestMessage->key());
+  bool withId = requestMessage->has_cachedid();
+  cachedId.assign(requestMessage->cachedid());
 
   delete requestMessage;
+  return withId;
 }
 
 void ConditionsMQServer::Run()
@@ -112,9 +117,10 @@ void ConditionsMQServer::Run()
         if (dataSource == "OCDB") {
           // Retrieve the key from the serialized message
           std::string key;
-          Deserialize(serialString, key);
+          std::string cachedId;
+          bool withId = Deserialize(serialString, key, cachedId);
 
-          getFromOCDB(key);
+          getFromOCDB(key, withId, cachedId);
         } else if (dataSource == "Riak") {
           // No need to de-serialize, just forward message to the broker
           fChannels.at("broker-get").at(0).Send(input);
@@ -155,7 +161,7 @@ void ConditionsMQServer::Run()
 }
 
 // Query OCDB for the condition
-void ConditionsMQServer::getFromOCDB(std::string key)
+void ConditionsMQServer::getFromOCDB(std::string key, bool withId, const std::string& cachedId)
 {
   // Change key from i.e. "/DET/Calib/Histo/Run2008_2008_v1_s0" to (DET/Calib/Histo, 2008)
   // FIXME: This will have to be changed in the future by adapting IdPath and getObject accordingly
@@ -165,24 +171,58 @@ void ConditionsMQServer::getFromOCDB(std::string key)
   std::size_t pos2 = key.find("_");
   int runId = atoi(key.substr(0, pos2).c_str());
 
-  Condition* aCondition = nullptr;
-
+  // the request is resolved to the stored object as the manager would do when getting it, in the specific
+  // storage of the path if there is one: a newly stored version has a new id and replaces the cached one
   mCdbManager->setRun(runId);
-  aCondition = mCdbManager->getCondition(IdPath(identifier), runId);
-
-  if (aCondition) {
-    LOG(DEBUG) << "Sending following parameter to the client:";
-    aCondition->printConditionMetaData();
-    TMessage* tmsg = new TMessage(kMESS_OBJECT);
-    tmsg->WriteObject(aCondition);
+  std::unique_ptr<ConditionId> conditionId(mCdbManager->getId(IdPath(identifier), runId));
+  std::string id = conditionId ? conditionId->ToString().Data() : "";
+
+  ObjectCache<TMessage>::ObjectPtr blob;
+  if (conditionId) {
+    blob = mBlobCache.get(id);
+    if (!blob) {
+      Condition* aCondition = mCdbManager->getCondition(*conditionId);
+      if (aCondition) {
+        LOG(DEBUG) << "Sending following parameter to the client:";
+        aCondition->printConditionMetaData();
+        auto serialized = std::make_shared<TMessage>(kMESS_OBJECT);
+        serialized->WriteObject(aCondition);
+        blob = serialized;
+        mBlobCache.put(id, blob);
+      }
+    }
+  }
+  if (!blob) {
+    LOG(ERROR) << R"(Could not get a condition for ")" << key << R"(" and run )" << runId << "!";
+    if (withId) {
+      // an empty id tells the client there is no such condition
+      FairMQParts reply;
+      reply.AddPart(fTransportFactory->CreateMessage());
+      reply.AddPart(fTransportFactory->CreateMessage());
+      Send(reply, "data-get");
+    }
+    return;
+  }
 
-    std::unique_ptr<FairMQMessage> message(
-      fTransportFactory->CreateMessage(tmsg->Buffer(), tmsg->BufferSize(), free_tmessage, tmsg));
+  // the message shares the ownership of the cached buffer, released when the message is sent
+  using BlobPtr = decltype(blob);
+  auto hint = new BlobPtr(blob);
+  std::unique_ptr<FairMQMessage> message(
+    fTransportFactory->CreateMessage(blob->Buffer(), blob->BufferSize(),
+                                     [](void* data, void* object) { delete static_cast<BlobPtr*>(object); }, hint));
 
+  if (!withId) {
     fChannels.at("data-get").at(0).Send(message);
-  } else {
-    LOG(ERROR) << R"(Could not get a condition for ")" << key << R"(" and run )" << runId << "!";
+    return;
   }
+  // the client keeps using its copy if it is still the condition the request resolves to
+  auto idString = new std::string(id);
+  FairMQParts reply;
+  reply.AddPart(fTransportFactory->CreateMessage(
+    const_cast<char*>(idString->data()), idString->size(),
+    [](void* data, void* object) { delete static_cast<std::string*>(object); }, idString));
+  reply.AddPart(id == cachedId ? fTransportFactory->CreateMessage() : std::move(message));
+  Send(reply, "data-get");
 }
 
 ConditionsMQServer::~ConditionsMQServer() { delete mCdbManager; }
@@ -17,6 +17,9 @@
 #include <TRegexp.h>            // for TRegexp
 #include <TSystem.h>            // for TSystem, gSystem
 #include "CCDB/Condition.h"          // for Condition
+#include <cctype>               // for isdigit
+#include <cstring>              // for strlen, strncmp
+#include <ctime>                // for time
 
 using namespace o2::CDB;
 
@@ -53,32 +56,42 @@ Bool_t LocalStorage::filenameToId(const char *filename, IdRunRange &runRange, In
 {
   // build  ConditionId from filename numbers
 
-  Ssiz_t mSize;
-
-  // valid filename: Run#firstRun_#lastRun_v#version_s#subVersion.root
-  TRegexp keyPattern("^Run[0-9]+_[0-9]+_v[0-9]+_s[0-9]+.root$");
-  keyPattern.Index(filename, &mSize);
-  if (!mSize) {
+  // valid filename: Run#firstRun_#lastRun_v#version_s#subVersion.root, numbers made of digits only
+  // (no signs or blanks, which sscanf would accept)
+  auto readText = [](const char *&pos, const char *text) {
+    size_t length = strlen(text);
+    if (strncmp(pos, text, length)) {
+      return false;
+    }
+    pos += length;
+    return true;
+  };
+  auto readNumber = [](const char *&pos, Int_t &value) {
+    if (!isdigit(*pos)) {
+      return false;
+    }
+    Long64_t number = 0;
+    while (isdigit(*pos)) {
+      number = number * 10 + (*pos++ - '0');
+      if (number > kMaxInt) {
+        return false;
+      }
+    }
+    value = number;
+    return true;
+  };
+
+  Int_t firstRun, lastRun;
+  const char *pos = filename;
+  if (!readText(pos, "Run") || !readNumber(pos, firstRun) || !readText(pos, "_") || !readNumber(pos, lastRun) ||
+      !readText(pos, "_v") || !readNumber(pos, version) || !readText(pos, "_s") || !readNumber(pos, subVersion) ||
+      !readText(pos, ".root") || *pos != '\0') {
     LOG(DEBUG) << "Bad filename <" << filename << ">." << FairLogger::endl;
     return kFALSE;
   }
 
-  TString idString(filename);
-  idString.Resize(idString.Length() - sizeof(".root") + 1);
-
-  TObjArray *strArray = (TObjArray *) idString.Tokenize("_");
-
-  TString firstRunString(((TObjString *) strArray->At(0))->GetString());
-  runRange.setFirstRun(atoi(firstRunString.Data() + 3));
-  runRange.setLastRun(atoi(((TObjString *) strArray->At(1))->GetString()));
-
-  TString verString(((TObjString *) strArray->At(2))->GetString());
-  version = atoi(verString.Data() + 1);
-
-  TString subVerString(((TObjString *) strArray->At(3))->GetString());
-  subVersion = atoi(subVerString.Data() + 1);
-
-  delete strArray;
+  runRange.setFirstRun(firstRun);
+  runRange.setLastRun(lastRun);
 
   return kTRUE;
 }
@@ -129,7 +142,14 @@ Bool_t LocalStorage::prepareId(ConditionId &id)
     }
   }
 
-  const char *filename;
+  gSystem->FreeDirectory(dirPtr);
+
+  const auto *entries = getPathIndex(id.getPathString());
+  if (!entries) {
+    LOG(ERROR) << R"(Can't read directory ")" << dirName.Data() << R"("!)" << FairLogger::endl;
+    return kFALSE;
+  }
+
   IdRunRange aIdRunRange;                         // the runRange got from filename
   IdRunRange lastIdRunRange(-1, -1);              // highest runRange found
   Int_t aVersion, aSubVersion;                // the version subVersion got from filename
@@ -137,17 +157,11 @@ Bool_t LocalStorage::prepareId(ConditionId &id)
 
   if (!id.hasVersion()) { // version not specified: look for highest version & subVersion
 
-    while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on the files
-
-      TString aString(filename);
-      if (aString == "." || aString == "..") {
-        continue;
-      }
-
-      if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
-        LOG(DEBUG) << "Bad filename <" << filename << ">! I'll skip it." << FairLogger::endl;
-        continue;
-      }
+    for (const auto &entry : *entries) { // loop on the files
+      aIdRunRange.setFirstRun(entry.firstRun);
+      aIdRunRange.setLastRun(entry.lastRun);
+      aVersion = entry.version;
+      aSubVersion = entry.subVersion;
 
       if (!aIdRunRange.isOverlappingWith(id.getIdRunRange())) {
         continue;
@@ -171,17 +185,11 @@ Bool_t LocalStorage::prepareId(ConditionId &id)
 
   } else { // version specified, look for highest subVersion only
 
-    while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on the files
-
-      TString aString(filename);
-      if (aString == "." || aString == "..") {
-        continue;
-      }
-
-      if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
-        LOG(DEBUG) << "Bad filename <" << filename << ">!I'll skip it." << FairLogger::endl;
-        continue;
-      }
+    for (const auto &entry : *entries) { // loop on the files
+      aIdRunRange.setFirstRun(entry.firstRun);
+      aIdRunRange.setLastRun(entry.lastRun);
+      aVersion = entry.version;
+      aSubVersion = entry.subVersion;
 
       if (aIdRunRange.isOverlappingWith(id.getIdRunRange()) && aVersion == id.getVersion() &&
           aSubVersion > lastSubVersion) {
@@ -193,8 +201,6 @@ Bool_t LocalStorage::prepareId(ConditionId &id)
     id.setSubVersion(lastSubVersion + 1);
   }
 
-  gSystem->FreeDirectory(dirPtr);
-
   TString lastStorage = id.getLastStorage();
   if (lastStorage.Contains(TString("grid"), TString::kIgnoreCase) && id.getSubVersion() > 0) {
     LOG(ERROR) << "GridStorage to LocalStorage Storage error! local object with version v" << id.getVersion() << "_s"
@@ -241,17 +247,14 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
     return result;
   }
 
-  // otherwise browse in the local filesystem CDB storage
-  TString dirName = Form("%s/%s", mBaseDirectory.Data(), query.getPathString().Data());
-
-  void *dirPtr = gSystem->OpenDirectory(dirName);
-  if (!dirPtr) {
+  // otherwise look in the index of the local filesystem CDB storage
+  const auto *entries = getPathIndex(query.getPathString());
+  if (!entries) {
     LOG(DEBUG) << "Directory <" << (query.getPathString()).Data() << "> not found" << FairLogger::endl;
     LOG(DEBUG) << "in DB folder " << mBaseDirectory.Data() << FairLogger::endl;
     return nullptr;
   }
 
-  const char *filename;
   ConditionId *result = new ConditionId();
   result->setPath(query.getPathString());
 
@@ -261,24 +264,20 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
   if (!query.hasVersion()) { // neither version and subversion specified -> look for highest version
     // and subVersion
 
-    while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on files
-
-      TString aString(filename);
-      if (aString.BeginsWith('.')) {
-        continue;
-      }
-
-      if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
-        continue;
-      }
-      // aIdRunRange, aVersion, aSubVersion filled from filename
+    for (const auto &entry : *entries) { // loop on files
+      aIdRunRange.setFirstRun(entry.firstRun);
+      aIdRunRange.setLastRun(entry.lastRun);
+      aVersion = entry.version;
+      aSubVersion = entry.subVersion;
+      // aIdRunRange, aVersion, aSubVersion filled from index
 
       if (!aIdRunRange.isSupersetOf(query.getIdRunRange())) {
         continue;
       }
       // aIdRunRange contains requested run!
 
-      LOG(DEBUG) << "Filename " << filename << " matches\n" << FairLogger::endl;
+      LOG(DEBUG) << "Run" << aIdRunRange.getFirstRun() << "_" << aIdRunRange.getLastRun() << "_v" << aVersion << "_s"
+                 << aSubVersion << " matches\n" << FairLogger::endl;
 
       if (result->getVersion() < aVersion) {
         result->setVersion(aVersion);
@@ -296,7 +295,6 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
       } else if (result->getVersion() == aVersion && result->getSubVersion() == aSubVersion) {
         LOG(ERROR) << "More than one object valid for run " << query.getFirstRun() << " version " << aVersion << "_"
                    << aSubVersion << "!" << FairLogger::endl;
-        gSystem->FreeDirectory(dirPtr);
         delete result;
         return nullptr;
       }
@@ -306,17 +304,12 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
     // subVersion
     result->setVersion(query.getVersion());
 
-    while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on files
-
-      TString aString(filename);
-      if (aString.BeginsWith('.')) {
-        continue;
-      }
-
-      if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
-        continue;
-      }
-      // aIdRunRange, aVersion, aSubVersion filled from filename
+    for (const auto &entry : *entries) { // loop on files
+      aIdRunRange.setFirstRun(entry.firstRun);
+      aIdRunRange.setLastRun(entry.lastRun);
+      aVersion = entry.version;
+      aSubVersion = entry.subVersion;
+      // aIdRunRange, aVersion, aSubVersion filled from index
 
       if (!aIdRunRange.isSupersetOf(query.getIdRunRange())) {
         continue;
@@ -331,7 +324,6 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
       if (result->getSubVersion() == aSubVersion) {
         LOG(ERROR) << "More than one object valid for run " << query.getFirstRun() << " version " << aVersion << "_"
                    << aSubVersion << "!" << FairLogger::endl;
-        gSystem->FreeDirectory(dirPtr);
         delete result;
         return nullptr;
       }
@@ -348,18 +340,12 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
 
     // ConditionId dataId(queryId.getPathString(), -1, -1, -1, -1);
     // Bool_t result;
-    while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on files
-
-      TString aString(filename);
-      if (aString.BeginsWith('.')) {
-        continue;
-      }
-
-      if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
-        LOG(DEBUG) << "Could not make id from file: " << filename << FairLogger::endl;
-        continue;
-      }
-      // aIdRunRange, aVersion, aSubVersion filled from filename
+    for (const auto &entry : *entries) { // loop on files
+      aIdRunRange.setFirstRun(entry.firstRun);
+      aIdRunRange.setLastRun(entry.lastRun);
+      aVersion = entry.version;
+      aSubVersion = entry.subVersion;
+      // aIdRunRange, aVersion, aSubVersion filled from index
 
       if (!aIdRunRange.isSupersetOf(query.getIdRunRange())) {
         continue;
@@ -379,9 +365,102 @@ ConditionId *LocalStorage::getId(const ConditionId &query)
     }
   }
 
+  return result;
+}
+
+const std::vector<LocalStorage::IndexEntry> *LocalStorage::getPathIndex(const TString &path)
+{
+  // get the (cached) list of objects stored for the path; the directory is scanned and the
+  // filenames are parsed only the first time or if the directory was modified since the last scan
+
+  TString dirName = Form("%s/%s", mBaseDirectory.Data(), path.Data());
+
+  FileStat_t dirStat;
+  if (gSystem->GetPathInfo(dirName, dirStat) || !R_ISDIR(dirStat.fMode)) {
+    mPathIndex.erase(path.Data());
+    return nullptr;
+  }
+
+  auto &index = mPathIndex[path.Data()];
+  if (index.modTime == dirStat.fMtime) {
+    // the mtime has a resolution of one second: the index is complete if it was scanned after the
+    // second of the last modification
+    if (index.scanTime > dirStat.fMtime) {
+      return &index.entries;
+    }
+    // otherwise, e.g. after our own put, another process might have stored an object in the same
+    // second. Files are only ever added to the storage, so counting them tells if it did
+    void *dirPtr = gSystem->OpenDirectory(dirName);
+    if (dirPtr) {
+      size_t numFiles = 0;
+      const char *filename;
+      while ((filename = gSystem->GetDirEntry(dirPtr))) {
+        if (filename[0] != '.') {
+          numFiles++;
+        }
+      }
+      gSystem->FreeDirectory(dirPtr);
+      if (numFiles == index.numFiles) {
+        // once that second is over, any other change shows in the mtime
+        Long_t now = time(nullptr);
+        if (now > dirStat.fMtime) {
+          index.scanTime = now;
+        }
+        return &index.entries;
+      }
+    }
+  }
+
+  void *dirPtr = gSystem->OpenDirectory(dirName);
+  if (!dirPtr) {
+    mPathIndex.erase(path.Data());
+    return nullptr;
+  }
+
+  index.scanTime = time(nullptr);
+  index.modTime = dirStat.fMtime;
+  index.numFiles = 0;
+  index.entries.clear();
+
+  const char *filename;
+  IdRunRange aIdRunRange;
+  Int_t aVersion, aSubVersion;
+  while ((filename = gSystem->GetDirEntry(dirPtr))) { // loop on files
+    if (filename[0] == '.') {
+      continue;
+    }
+    index.numFiles++;
+    if (!filenameToId(filename, aIdRunRange, aVersion, aSubVersion)) {
+      LOG(DEBUG) << "Bad filename <" << filename << ">! I'll skip it." << FairLogger::endl;
+      continue;
+    }
+    index.entries.push_back({ aIdRunRange.getFirstRun(), aIdRunRange.getLastRun(), aVersion, aSubVersion });
+  }
   gSystem->FreeDirectory(dirPtr);
 
-  return result;
+  LOG(DEBUG) << "Indexed " << index.entries.size() << " objects for path " << path.Data() << FairLogger::endl;
+  return &index.entries;
+}
+
+void LocalStorage::addToPathIndex(const ConditionId &id)
+{
+  // register newly stored object in an already built index, avoiding the rescan of the directory
+
+  auto iter = mPathIndex.find(id.getPathString().Data());
+  if (iter == mPathIndex.end()) {
+    return; // will be indexed at the 1st query
+  }
+  auto &index = iter->second;
+  index.entries.push_back({ id.getFirstRun(), id.getLastRun(), id.getVersion(), id.getSubVersion() });
+  index.numFiles++;
+
+  // prepareId has just validated the index: the next query counts the files to check that this put
+  // was the only change of the directory
+  FileStat_t dirStat;
+  TString dirName = Form("%s/%s", mBaseDirectory.Data(), id.getPathString().Data());
+  if (!gSystem->GetPathInfo(dirName, dirStat)) {
+    index.modTime = dirStat.fMtime;
+  }
 }
 
 Condition *LocalStorage::getCondition(const ConditionId &queryId)
@@ -766,6 +845,7 @@ Bool_t LocalStorage::putCondition(Condition *entry, const char *mirrors)
 
   file.Close();
   if (result) {
+    addToPathIndex(id);
     if (!(id.getPathString().Contains("SHUTTLE/STATUS")))
       LOG(INFO) << R"(CDB object stored into file ")" << filename.Data() << R"(")" << FairLogger::endl;
   }
@@ -1235,12 +1235,16 @@ ConditionId *Manager::getId(const ConditionId &query)
   }
 
   // Condition is not in cache -> retrieve it from CDB and cache it!!
+  Int_t version = -1, subVersion = -1;
   Storage *aStorage = nullptr;
   StorageParameters *aPar = selectSpecificStorage(query.getPathString());
 
   if (aPar) {
     aStorage = getStorage(aPar);
     TString str = aPar->getUri();
+    UInt_t uId = aPar->GetUniqueID();
+    version = Int_t(uId & 0xffff) - 1;
+    subVersion = Int_t(uId >> 16) - 1;
     LOG(DEBUG) << "Looking into storage: " << str.Data() << FairLogger::endl;
 
   } else {
@@ -1248,7 +1252,15 @@ ConditionId *Manager::getId(const ConditionId &query)
     LOG(DEBUG) << "Looking into default storage" << FairLogger::endl;
   }
 
-  return aStorage->getId(query);
+  // same version selection as getCondition, so that the id is the one of the object it returns
+  ConditionId finalQueryId(query);
+  if (version >= 0) {
+    finalQueryId.setVersion(version);
+  }
+  if (subVersion >= 0) {
+    finalQueryId.setSubVersion(subVersion);
+  }
+  return aStorage->getId(finalQueryId);
 }
 
 TList *Manager::getAllObjects(const IdPath &path, Int_t runNumber, Int_t version, Int_t subVersion)
@@ -22,7 +22,10 @@ void addCustomOptions(bpo::options_description& options)
   options.add_options()("parameter-name", bpo::value<string>()->default_value("DET/Calib/Histo"), "Parameter Name")(
     "operation-type", bpo::value<string>()->default_value("GET"), "Operation Type")(
     "data-source", bpo::value<string>()->default_value("OCDB"), "Data Source")(
-    "object-path", bpo::value<string>()->default_value("OCDB"), "Object Path");
+    "object-path", bpo::value<string>()->default_value("OCDB"), "Object Path")(
+    "cache-size", bpo::value<int>()->default_value(100), "Max number of conditions kept in the local cache")(
+    "prefetch-keys", bpo::value<string>()->default_value(""),
+    "Comma separated keys of conditions to prefetch asynchronously at start");
 }
 
 FairMQDevice* getDevice(const FairMQProgOptions& config) { return new ConditionsMQClient(); }
@@ -17,9 +17,12 @@
 
 #include <TNamed.h>
 #include <cassert>
+#include <cstring>
+#include <cstdint>
 #include <stdexcept>
 #include <gsl/gsl> // for guideline support library; array_view
 #include <type_traits>
+#include <vector>
 
 namespace o2
 {
@@ -35,6 +38,21 @@ struct MCTruthHeaderElement {
   ClassDefNV(MCTruthHeaderElement, 1);
 };
 
+// header of the flat (single buffer) representation of a MCTruthContainer:
+// it is followed by nHeaders MCTruthHeaderElement and, starting at elementsOffset
+// bytes from the beginning of the buffer, by nElements TruthElements
+struct MCTruthFlatHeader {
+  static constexpr uint32_t MagicWord = 0x4d435452; // "MCTR"
+  uint32_t magic = MagicWord;
+  uint32_t elementSize = 0;    // sizeof(TruthElement) the buffer was written with
+  uint32_t nHeaders = 0;       // number of header elements (i.e. indexed data objects)
+  uint32_t nElements = 0;      // number of truth elements
+  uint64_t elementsOffset = 0; // offset in bytes of 1st truth element wrt buffer start
+};
+
+template <typename TruthElement>
+class MCTruthContainerView;
+
 // A container to hold and manage MC truth information/labels.
 // The actual MCtruth type is a generic template type and can be supplied by the user
 // It is meant to manage associations from one "dataobject" identified by an index into an array
@@ -48,6 +66,16 @@ class MCTruthContainer
     mHeaderArray;                        // the header structure array serves as an index into the actual storage
   std::vector<TruthElement> mTruthArray; // the buffer containing the actual truth information
 
+  // append headers and elements of another container, offsetting the header indices
+  void appendFlat(gsl::span<const MCTruthHeaderElement> headers, gsl::span<const TruthElement> elements)
+  {
+    const uint offset = mTruthArray.size();
+    for (const auto& h : headers) {
+      mHeaderArray.emplace_back(h.index != uint(-1) ? h.index + offset : h.index);
+    }
+    mTruthArray.insert(mTruthArray.end(), elements.begin(), elements.end());
+  }
+
   size_t getSize(int dataindex) const
   {
     // calculate size / number of labels from a difference in pointed indices
@@ -97,6 +125,88 @@ class MCTruthContainer
     mTruthArray.clear();
   }
 
+  // size in bytes of the flat (single buffer) representation of this container
+  size_t getFlatBufferSize() const
+  {
+    return getFlatElementsOffset(mHeaderArray.size()) + mTruthArray.size() * sizeof(TruthElement);
+  }
+
+  // offset of the truth elements in the flat buffer, aligned for TruthElement
+  static size_t getFlatElementsOffset(size_t nheaders)
+  {
+    constexpr size_t align = alignof(TruthElement) > alignof(uint64_t) ? alignof(TruthElement) : alignof(uint64_t);
+    size_t offset = sizeof(MCTruthFlatHeader) + nheaders * sizeof(MCTruthHeaderElement);
+    return (offset + align - 1) / align * align;
+  }
+
+  // write the flat representation to externally provided buffer of given size (e.g. allocated
+  // for a message to be adopted by the DataAllocator), return the number of bytes written
+  size_t flattenTo(char* buffer, size_t size) const
+  {
+    static_assert(std::is_trivially_copyable<TruthElement>::value, "flat format needs trivially copyable elements");
+    const size_t flatSize = getFlatBufferSize();
+    if (size < flatSize) {
+      throw std::runtime_error("MCTruthContainer: buffer is too small for flattening");
+    }
+    MCTruthFlatHeader header;
+    header.elementSize = sizeof(TruthElement);
+    header.nHeaders = mHeaderArray.size();
+    header.nElements = mTruthArray.size();
+    header.elementsOffset = getFlatElementsOffset(mHeaderArray.size());
+    std::memcpy(buffer, &header, sizeof(MCTruthFlatHeader));
+    std::memcpy(buffer + sizeof(MCTruthFlatHeader), mHeaderArray.data(),
+                mHeaderArray.size() * sizeof(MCTruthHeaderElement));
+    std::memcpy(buffer + header.elementsOffset, mTruthArray.data(), mTruthArray.size() * sizeof(TruthElement));
+    return flatSize;
+  }
+
+  // write the flat representation to a resizable container of chars
+  template <typename ContainerType>
+  void flattenTo(ContainerType& container) const
+  {
+    static_assert(sizeof(typename ContainerType::value_type) == 1, "flattening needs container of bytes");
+    container.resize(getFlatBufferSize());
+    flattenTo(reinterpret_cast<char*>(container.data()), container.size());
+  }
+
+  // restore this container (making a copy) from the flat representation
+  void restoreFrom(const char* buffer, size_t size);
+
+  // append another container to this one, the indices of the appended data are
+  // offset by the current getIndexedSize()
+  void mergeAtBack(MCTruthContainer<TruthElement> const& other)
+  {
+    if (&other == this) {
+      throw std::runtime_error("MCTruthContainer: cannot merge a container with itself");
+    }
+    mHeaderArray.reserve(mHeaderArray.size() + other.mHeaderArray.size());
+    mTruthArray.reserve(mTruthArray.size() + other.mTruthArray.size());
+    appendFlat(other.mHeaderArray, other.mTruthArray);
+  }
+
+  // append the content of a view to this container
+  void mergeAtBack(MCTruthContainerView<TruthElement> const& other)
+  {
+    mHeaderArray.reserve(mHeaderArray.size() + other.getIndexedSize());
+    mTruthArray.reserve(mTruthArray.size() + other.getNElements());
+    appendFlat(other.getHeaders(), other.getTruthArray());
+  }
+
+  // concatenate (e.g. from several producers) multiple views in one pass
+  void mergeAtBack(gsl::span<const MCTruthContainerView<TruthElement>> others)
+  {
+    size_t nheaders = mHeaderArray.size(), nelements = mTruthArray.size();
+    for (const auto& other : others) {
+      nheaders += other.getIndexedSize();
+      nelements += other.getNElements();
+    }
+    mHeaderArray.reserve(nheaders);
+    mTruthArray.reserve(nelements);
+    for (const auto& other : others) {
+      appendFlat(other.getHeaders(), other.getTruthArray());
+    }
+  }
+
   // add element for a particular dataindex
   // at the moment only strictly consecutive modes are supported
   void addElement(uint dataindex, TruthElement const& element)
@@ -196,6 +306,80 @@ class MCTruthContainer
   ClassDefNV(MCTruthContainer, 1);
 }; // end class
 
+// A non-owning, read-only view on the flat representation of a MCTruthContainer
+// (as produced by MCTruthContainer::flattenTo), e.g. directly on the payload of a
+// received message; no deserialization or copy is involved.
+// The buffer must outlive the view.
+template <typename TruthElement>
+class MCTruthContainerView
+{
+ private:
+  gsl::span<const MCTruthHeaderElement> mHeaders;
+  gsl::span<const TruthElement> mTruthArray;
+
+  size_t getSize(int dataindex) const
+  {
+    const auto size = (dataindex < mHeaders.size() - 1) ? mHeaders[dataindex + 1].index - mHeaders[dataindex].index
+                                                        : mTruthArray.size() - mHeaders[dataindex].index;
+    return size;
+  }
+
+ public:
+  MCTruthContainerView() = default;
+
+  MCTruthContainerView(const char* buffer, size_t size)
+  {
+    if (size < sizeof(MCTruthFlatHeader)) {
+      throw std::runtime_error("MCTruthContainerView: buffer is too small");
+    }
+    MCTruthFlatHeader header;
+    std::memcpy(&header, buffer, sizeof(MCTruthFlatHeader));
+    if (header.magic != MCTruthFlatHeader::MagicWord || header.elementSize != sizeof(TruthElement)) {
+      throw std::runtime_error("MCTruthContainerView: buffer is not a flat MCTruthContainer of this type");
+    }
+    // the header elements have to fit before the truth elements, the truth elements in the buffer
+    if (header.elementsOffset % alignof(TruthElement) ||
+        header.elementsOffset < sizeof(MCTruthFlatHeader) + uint64_t(header.nHeaders) * sizeof(MCTruthHeaderElement) ||
+        header.elementsOffset > size || (size - header.elementsOffset) / sizeof(TruthElement) < header.nElements) {
+      throw std::runtime_error("MCTruthContainerView: inconsistent flat buffer");
+    }
+    mHeaders = gsl::span<const MCTruthHeaderElement>(
+      reinterpret_cast<const MCTruthHeaderElement*>(buffer + sizeof(MCTruthFlatHeader)), header.nHeaders);
+    mTruthArray = gsl::span<const TruthElement>(reinterpret_cast<const TruthElement*>(buffer + header.elementsOffset),
+                                                header.nElements);
+    // getLabels relies on increasing indices within the truth elements
+    uint previous = 0;
+    for (const auto& h : mHeaders) {
+      if (h.index < previous || h.index > header.nElements) {
+        throw std::runtime_error("MCTruthContainerView: invalid index in flat buffer");
+      }
+      previous = h.index;
+    }
+  }
+
+  MCTruthHeaderElement getMCTruthHeader(uint dataindex) const { return mHeaders[dataindex]; }
+  TruthElement const& getElement(uint elementindex) const { return mTruthArray[elementindex]; }
+  size_t getIndexedSize() const { return mHeaders.size(); }
+  size_t getNElements() const { return mTruthArray.size(); }
+  gsl::span<const MCTruthHeaderElement> getHeaders() const { return mHeaders; }
+  gsl::span<const TruthElement> getTruthArray() const { return mTruthArray; }
+
+  gsl::span<const TruthElement> getLabels(int dataindex) const
+  {
+    if (dataindex >= getIndexedSize())
+      return gsl::span<const TruthElement>();
+    return mTruthArray.subspan(mHeaders[dataindex].index, getSize(dataindex));
+  }
+};
+
+template <typename TruthElement>
+void MCTruthContainer<TruthElement>::restoreFrom(const char* buffer, size_t size)
+{
+  MCTruthContainerView<TruthElement> view(buffer, size);
+  clear();
+  mergeAtBack(view);
+}
+
 }
 }
 
@@ -24,10 +24,10 @@
 #include "Rtypes.h"
 #include "TParticle.h"
 
-#include <map>
 #include <memory>
 #include <stack>
 #include <utility>
+#include <vector>
 
 class TClonesArray;
 class TRefArray;
@@ -128,6 +128,11 @@ class Stack : public FairGenericStack
   /// Fill the MCTrack output array, applying filter criteria
   void FillTrackArray() override;
 
+  /// Number of secondaries pushed to the stack in the current event
+  Int_t getNSecondariesPushed() const { return mNSecondariesPushed; }
+  /// Number of secondaries kept in the output in the current event
+  Int_t getNSecondariesKept() const { return mNSecondariesKept; }
+
   /// Update the track index in the MCTracks and data produced by detectors
   void UpdateTrackIndex(TRefArray* detArray = nullptr) override;
 
@@ -171,8 +176,9 @@ class Stack : public FairGenericStack
 
  private:
   /// STL stack (FILO) used to handle the TParticles for tracking
-  /// stack entries refer to
-  std::stack<TParticle> mStack; //!
+  /// stack entries refer to; it is backed by a vector whose storage
+  /// is reused from event to event
+  std::stack<TParticle, std::vector<TParticle>> mStack; //!
 
   /// Array of TParticles (contains all TParticles put into or created
   /// by the transport)
@@ -190,8 +196,14 @@ class Stack : public FairGenericStack
   /// vector of reducded tracks written to the output
   std::vector<o2::MCTrack>* mTracks;
 
-  /// STL map from particle index to persistent track index
-  std::map<Int_t, Int_t> mIndexMap; //!
+  /// flat map from particle index to persistent track index (-1 if not stored)
+  std::vector<int> mIndexMap; //!
+
+  /// position in mParticles of the transported particle with given index (-1 if not in mParticles)
+  std::vector<int> mParticlePosition; //!
+
+  /// scratch map from position in mParticles to position in mTracks, reused for every primary
+  std::vector<int> mStoredPosition; //!
 
   /// cache active O2 detectors
   std::vector<o2::Base::Detector*> mActiveDetectors; //!
@@ -202,6 +214,8 @@ class Stack : public FairGenericStack
   Int_t mNumberOfEntriesInParticles; //! Number of entries in mParticles
   Int_t mNumberOfEntriesInTracks;    //! Number of entries in mTracks
   Int_t mIndex;                      //! Used for merging
+  Int_t mNSecondariesPushed = 0;     //! Number of secondaries pushed in current event
+  Int_t mNSecondariesKept = 0;       //! Number of secondaries stored in current event
 
   /// Variables defining the criteria for output selection
   Bool_t mStoreMothers;
@@ -237,6 +251,9 @@ class Stack : public FairGenericStack
   /// than donw with FillTrackArray which is only called once per event
   void finishCurrentPrimary();
 
+  /// register particle to be transported in the mParticles buffer
+  void addTransportedParticle(const TParticle& p);
+
   /// Increment number of hits for an arbitrary track in a given detector
   /// \param iDet    Detector unique identifier
   /// \param iTrack  Track number
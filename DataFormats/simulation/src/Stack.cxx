@@ -149,8 +149,7 @@ void Stack::PushTrack(Int_t toBeDone, Int_t parentId, Int_t pdgCode, Double_t px
   // so we have to register the particles here
   if (mIsG4Like && parentId >= 0) {
     // p.SetStatusCode(mParticles.size());
-    mParticles.emplace_back(p);
-    mTransportedIDs.emplace_back(p.GetStatusCode());
+    addTransportedParticle(p);
     mCurrentParticle = p;
   }
 
@@ -158,6 +157,8 @@ void Stack::PushTrack(Int_t toBeDone, Int_t parentId, Int_t pdgCode, Double_t px
   if (parentId < 0) {
     mNumberOfPrimaryParticles++;
     mPrimaryParticles.push_back(p);
+  } else {
+    mNSecondariesPushed++;
   }
 
   // Set argument variable
@@ -181,8 +182,7 @@ void Stack::SetCurrentTrack(Int_t iTrack)
       // This interface is called by Geant4 when activating a certain primary
       auto& p = mPrimaryParticles[iTrack];
       mIndexOfPrimaries.emplace_back(mParticles.size());
-      mParticles.emplace_back(p);
-      mTransportedIDs.emplace_back(p.GetStatusCode());
+      addTransportedParticle(p);
       mCurrentParticle = p;
     }
   }
@@ -227,8 +227,7 @@ TParticle* Stack::PopNextTrack(Int_t& iTrack)
     }
     mIndexOfPrimaries.emplace_back(mParticles.size());
   }
-  mParticles.emplace_back(mCurrentParticle);
-  mTransportedIDs.emplace_back(mCurrentParticle.GetStatusCode());
+  addTransportedParticle(mCurrentParticle);
 
   mIndexOfCurrentTrack = mCurrentParticle.GetStatusCode();
   iTrack = mIndexOfCurrentTrack;
@@ -259,6 +258,18 @@ void Stack::FillTrackArray()
   /// This interface is not implemented since we are filtering/filling the output array
   /// after each primary ... just give a summary message
   LOG(INFO) << "Stack: " << mTracks->size() << " out of " << mNumberOfEntriesInParticles << " stored \n";
+  LOG(INFO) << "Stack: " << mNSecondariesKept << " out of " << mNSecondariesPushed << " pushed secondaries stored \n";
+}
+
+void Stack::addTransportedParticle(const TParticle& p)
+{
+  const int id = p.GetStatusCode();
+  if (id >= mParticlePosition.size()) {
+    mParticlePosition.resize(id + 1, -1);
+  }
+  mParticlePosition[id] = mParticles.size();
+  mParticles.emplace_back(p);
+  mTransportedIDs.emplace_back(id);
 }
 
 void Stack::finishCurrentPrimary()
@@ -267,26 +278,25 @@ void Stack::finishCurrentPrimary()
   // we can do some cleanup of the memory structures
   LOG(DEBUG) << "STACK: Cleaning up" << FairLogger::endl;
   auto selected = selectTracks();
+  // all particle indices seen so far can be mapped
+  if (mIndexMap.size() < mNumberOfEntriesInParticles) {
+    mIndexMap.resize(mNumberOfEntriesInParticles, -1);
+  }
   // loop over current particle buffer
   int index = 0;
-  int indexoffset = mTracks->size();
   int neglected = 0;
-  std::vector<int> indicesKept;
+  mStoredPosition.assign(mParticles.size(), -1);
   for (const auto& particle : mParticles) {
     if (particle.getStore()) {
       // map the global track index to the new persistent index
-      // FIXME: only fill the map for non-trivial mappings in which mTransportedIDs[index]!=mTracks->size();
-      mIndexMap[mTransportedIDs[index]] = mTracks->size();
+      mIndexMap[mTransportedIDs[index]] = mStoredPosition[index] = mTracks->size();
       auto mother = particle.getMotherTrackId();
       assert(mother < index);
       mTracks->emplace_back(particle);
-      indicesKept.emplace_back(index);
       if (mother != -1) {
-        auto iter = std::find_if(indicesKept.begin(), indicesKept.end(), [mother](int x) { return x == mother; });
-        if (iter != indicesKept.end()) {
-          // complexity should be constant
-          auto newmother = std::distance(indicesKept.begin(), iter);
-          mTracks->back().SetMotherTrackId(newmother + indexoffset);
+        mNSecondariesKept++;
+        if (mother < mStoredPosition.size() && mStoredPosition[mother] >= 0) {
+          mTracks->back().SetMotherTrackId(mStoredPosition[mother]);
         }
       }
       // LOG(INFO) << "Adding to map " << mTransportedIDs[index] << " to " << mIndexMap[mTransportedIDs[index]];
@@ -297,6 +307,9 @@ void Stack::finishCurrentPrimary()
     mTracksDone++;
   }
   // we can now clear the particles buffer!
+  for (auto id : mTransportedIDs) {
+    mParticlePosition[id] = -1;
+  }
   mParticles.clear();
   mTransportedIDs.clear();
   mIndexOfPrimaries.clear();
@@ -354,12 +367,11 @@ void Stack::UpdateTrackIndex(TRefArray* detList)
   // use some caching since repeated trackIDs
   for (auto& ref : *mTrackRefs) {
     const auto id = ref.getTrackID();
-    auto iter = mIndexMap.find(id);
-    if (iter == mIndexMap.end()) {
+    if (id < 0 || id >= mIndexMap.size() || mIndexMap[id] < 0) {
       LOG(INFO) << "Invalid trackref ... needs to be removed\n";
       ref.setTrackID(-1);
     } else {
-      ref.setTrackID(iter->second);
+      ref.setTrackID(mIndexMap[id]);
     }
   }
 
@@ -413,6 +425,11 @@ void Stack::Reset()
   mPrimaryParticles.clear();
   mTrackRefs->clear();
   mIndexedTrackRefs->clear();
+  // the flat index buffers keep their capacity for the next event
+  mIndexMap.clear();
+  mParticlePosition.clear();
+  mNSecondariesPushed = 0;
+  mNSecondariesKept = 0;
 }
 
 void Stack::Register()
@@ -476,15 +493,13 @@ bool Stack::selectTracks()
       store = kTRUE;
     } else {
       // for other particles we (potentially need to correct the mother indices
-      auto rangestart = mTransportedIDs.begin() + mIndexOfPrimaries[prim];
-      auto rangeend = (prim < (mIndexOfPrimaries.size() - 1)) ? mTransportedIDs.begin() + mIndexOfPrimaries[prim + 1]
-                                                              : mTransportedIDs.end();
-      // auto rangeend = mTransportedIDs.end();
-
-      auto iter = std::find_if(rangestart, rangeend, [iMother](int x) { return x == iMother; });
-      if (iter != rangeend) {
-        // complexity should be constant
-        auto newmother = std::distance(mTransportedIDs.begin(), iter);
+      int rangestart = mIndexOfPrimaries[prim];
+      int rangeend =
+        (prim < (mIndexOfPrimaries.size() - 1)) ? mIndexOfPrimaries[prim + 1] : int(mTransportedIDs.size());
+
+      // position of the mother in the buffer via direct lookup (instead of searching the range)
+      int newmother = iMother < mParticlePosition.size() ? mParticlePosition[iMother] : -1;
+      if (newmother >= rangestart && newmother < rangeend) {
         // LOG(INFO) << "Fixing mother from " << iMother << " to " << newmother << FairLogger::endl;
         thisPart.SetMotherTrackId(newmother);
       }
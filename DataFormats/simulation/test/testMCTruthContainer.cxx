@@ -14,6 +14,7 @@
 #include <boost/test/unit_test.hpp>
 #include "SimulationDataFormat/MCTruthContainer.h"
 #include <algorithm>
+#include <cstring>
 
 namespace o2
 {
@@ -115,4 +116,87 @@ BOOST_AUTO_TEST_CASE(MCTruth_RandomAccess)
     BOOST_CHECK(view[1] == 21);
   }
 }
+
+BOOST_AUTO_TEST_CASE(MCTruth_FlatViewAndMerge)
+{
+  using TruthElement = long;
+  dataformats::MCTruthContainer<TruthElement> container;
+  container.addElement(0, TruthElement(1));
+  container.addElement(0, TruthElement(2));
+  container.addElement(2, TruthElement(10)); // leaves empty index 1
+
+  std::vector<char> buffer;
+  container.flattenTo(buffer);
+  BOOST_CHECK(buffer.size() == container.getFlatBufferSize());
+
+  // read through the non-owning view
+  dataformats::MCTruthContainerView<TruthElement> view(buffer.data(), buffer.size());
+  BOOST_CHECK(view.getIndexedSize() == 3);
+  BOOST_CHECK(view.getNElements() == 3);
+  BOOST_CHECK(view.getLabels(0).size() == 2);
+  BOOST_CHECK(view.getLabels(0)[1] == 2);
+  BOOST_CHECK(view.getLabels(1).size() == 0);
+  BOOST_CHECK(view.getLabels(2).size() == 1);
+  BOOST_CHECK(view.getLabels(2)[0] == 10);
+  BOOST_CHECK(view.getLabels(3).size() == 0);
+
+  // restore owning copy
+  dataformats::MCTruthContainer<TruthElement> restored;
+  restored.restoreFrom(buffer.data(), buffer.size());
+  BOOST_CHECK(restored.getIndexedSize() == 3);
+  BOOST_CHECK(restored.getLabels(0)[0] == 1);
+
+  // a buffer of a different element type must be rejected
+  BOOST_CHECK_THROW((dataformats::MCTruthContainerView<char>(buffer.data(), buffer.size())), std::runtime_error);
+
+  // as well as headers which do not match the buffer
+  dataformats::MCTruthFlatHeader flatHeader;
+  std::memcpy(&flatHeader, buffer.data(), sizeof(flatHeader));
+  auto corrupted = buffer;
+  auto corruptedHeader = flatHeader;
+  corruptedHeader.nHeaders = 1000;
+  std::memcpy(corrupted.data(), &corruptedHeader, sizeof(corruptedHeader));
+  BOOST_CHECK_THROW((dataformats::MCTruthContainerView<TruthElement>(corrupted.data(), corrupted.size())),
+                    std::runtime_error);
+  corruptedHeader = flatHeader;
+  corruptedHeader.elementsOffset = uint64_t(-8);
+  std::memcpy(corrupted.data(), &corruptedHeader, sizeof(corruptedHeader));
+  BOOST_CHECK_THROW((dataformats::MCTruthContainerView<TruthElement>(corrupted.data(), corrupted.size())),
+                    std::runtime_error);
+  corrupted = buffer;
+  dataformats::MCTruthHeaderElement badIndex(100);
+  std::memcpy(corrupted.data() + sizeof(flatHeader), &badIndex, sizeof(badIndex));
+  BOOST_CHECK_THROW((dataformats::MCTruthContainerView<TruthElement>(corrupted.data(), corrupted.size())),
+                    std::runtime_error);
+
+  // merge 2 views with index offsetting
+  dataformats::MCTruthContainer<TruthElement> other;
+  other.addElement(0, TruthElement(20));
+  other.addElement(1, TruthElement(21));
+  other.addElement(1, TruthElement(22));
+  std::vector<char> buffer2;
+  other.flattenTo(buffer2);
+  std::vector<dataformats::MCTruthContainerView<TruthElement>> views;
+  views.emplace_back(buffer.data(), buffer.size());
+  views.emplace_back(buffer2.data(), buffer2.size());
+
+  dataformats::MCTruthContainer<TruthElement> merged;
+  merged.mergeAtBack(gsl::span<const dataformats::MCTruthContainerView<TruthElement>>(views));
+  BOOST_CHECK(merged.getIndexedSize() == 5);
+  BOOST_CHECK(merged.getNElements() == 6);
+  BOOST_CHECK(merged.getLabels(2)[0] == 10);
+  BOOST_CHECK(merged.getLabels(3).size() == 1);
+  BOOST_CHECK(merged.getLabels(3)[0] == 20);
+  BOOST_CHECK(merged.getLabels(4).size() == 2);
+  BOOST_CHECK(merged.getLabels(4)[1] == 22);
+
+  // merging owning container gives the same
+  container.mergeAtBack(other);
+  BOOST_CHECK(container.getIndexedSize() == 5);
+  BOOST_CHECK(container.getLabels(4)[0] == 21);
+
+  // merging a container with itself is not supported
+  BOOST_CHECK_THROW(container.mergeAtBack(container), std::runtime_error);
+  BOOST_CHECK(container.getIndexedSize() == 5);
+}
 } // end namespace
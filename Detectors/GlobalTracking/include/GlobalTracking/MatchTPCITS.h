@@ -157,6 +157,11 @@ class MatchTPCITS
   ///< set ITS 0-th ROFrame time start in \mus
   void setITSROFrameOffsetMUS(float v) { mITSROFrameOffsetMUS = v; }
 
+  ///< set length (in ITS ROFrames) of the time window for streaming matching, <=0 to match the whole input at once
+  void setStreamingWindowROF(int n) { mStreamingWindowROF = n; }
+  ///< get length (in ITS ROFrames) of the time window for streaming matching
+  int getStreamingWindowROF() const { return mStreamingWindowROF; }
+
   ///< set tree/chain containing ITS tracks
   void setInputTreeITSTracks(TTree* tree) { mTreeITSTracks = tree; }
 
@@ -259,6 +264,18 @@ class MatchTPCITS
   void attachInputTrees();
   bool prepareTPCTracks();
   bool prepareITSTracks();
+  void clearTPCWork(int nreserve);
+  void clearITSWork();
+  bool addTPCTrack(int it);
+  void addITSTracksFromCurrentChunk();
+  void buildTPCSectorCaches();
+  void buildITSSectorCaches();
+  void matchPreparedTracks();
+
+  void runStreaming();
+  void sortTPCTracksForStreaming();
+  bool loadITSTracksUpToROF(int rof);
+  void releaseITSTracks(int rofMin);
   bool loadTPCTracksNextChunk();
   bool loadITSTracksNextChunk();
   void loadITSClustersChunk(int chunk);
@@ -315,6 +332,12 @@ class MatchTPCITS
     return rof < 0 ? 0 : rof;
   }
 
+  ///< estimate max time-bin of TPC track from its time0 and forward time-bins span
+  float getTPCTrackTMax(const o2::TPC::TrackTPC& trc) const
+  {
+    return trc.getTime0() - mNTPCBinsFullDrift + trc.getDeltaTFwd() + mTPCTimeEdgeTSafeMargin;
+  }
+
   ///< convert ITS ROFrame to TPC time bin units
   float itsROFrame2TPCTimeBin(int rof) const { return (rof + mITSROFramePhaseOffset) * mITSROFrame2TPCBin; }
 
@@ -386,6 +409,11 @@ class MatchTPCITS
   float mNTPCBinsFullDrift = 0.;    ///< max time bin for full drift
   float mTPCZMax = 0.;              ///< max drift length
 
+  int mStreamingWindowROF = 0;      ///< streaming matching window in ITS ROFrames, <=0: match whole input at once
+  int mNextITSStreamEntry = 0;      ///< next ITS tracks tree entry to stream in
+  int mMaxStreamedITSROF = -1;      ///< max ROFrame of ITS tracks streamed in so far
+  std::vector<int> mTPCStreamOrder; ///< indices of input TPC tracks sorted in max ITS ROFrame they may match to
+
   TTree* mTreeITSTracks = nullptr;   ///< input tree for ITS tracks
   TTree* mTreeTPCTracks = nullptr;   ///< input tree for TPC tracks
   TTree* mTreeITSClusters = nullptr; ///< input tree for ITS clusters
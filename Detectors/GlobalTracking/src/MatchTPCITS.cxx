@@ -53,8 +53,37 @@ void MatchTPCITS::run()
 
   mTimerTot.Start();
 
-  prepareTPCTracks();
-  prepareITSTracks();
+  if (mStreamingWindowROF > 0) {
+    runStreaming();
+  } else {
+    prepareTPCTracks();
+    prepareITSTracks();
+    matchPreparedTracks();
+  }
+
+#ifdef _ALLOW_DEBUG_TREES_
+  mDBGOut.reset();
+#endif
+
+  mTimerTot.Stop();
+
+  printf("Timing:\n");
+  printf("Total:        ");
+  mTimerTot.Print();
+  printf("Data IO:      ");
+  mTimerIO.Print();
+  printf("Registration: ");
+  mTimerReg.Print();
+  printf("Refits      : ");
+  mTimerRefit.Print();
+  printf("DBG trees:    ");
+  mTimerDBG.Print();
+}
+
+//______________________________________________
+void MatchTPCITS::matchPreparedTracks()
+{
+  ///< match TPC and ITS tracks currently in the work arrays, select and refit the winners
   for (int sec = o2::constants::math::NSectors; sec--;) {
     doMatching(sec);
   }
@@ -76,22 +105,77 @@ void MatchTPCITS::run()
   if (mDBGOut && isDebugFlag(WinnerMatchesTree)) {
     dumpWinnerMatches();
   }
-  mDBGOut.reset();
 #endif
+}
 
-  mTimerTot.Stop();
+//______________________________________________
+void MatchTPCITS::runStreaming()
+{
+  ///< perform matching in consecutive windows of mStreamingWindowROF ITS ROFrames.
+  ///< Only the TPC tracks with max time within the window and the ITS tracks they may match to
+  ///< are kept in the work arrays, ITS tracks which cannot match to TPC tracks of the following
+  ///< windows are released once the window is processed.
+  ///< ITS tracks validated as winners in one window are not offered to the following ones.
+  if (!loadTPCTracksNextChunk()) {
+    LOG(ERROR) << "No TPC tracks to match" << FairLogger::endl;
+    return;
+  }
+  sortTPCTracksForStreaming();
 
-  printf("Timing:\n");
-  printf("Total:        ");
-  mTimerTot.Print();
-  printf("Data IO:      ");
-  mTimerIO.Print();
-  printf("Registration: ");
-  mTimerReg.Print();
-  printf("Refits      : ");
-  mTimerRefit.Print();
-  printf("DBG trees:    ");
-  mTimerDBG.Print();
+  clearITSWork();
+  mNextITSStreamEntry = 0;
+  mMaxStreamedITSROF = -1;
+
+  // max number of ITS ROFrames separating the ITS track from the max time of TPC track it may match to
+  float maxTDriftSafe = (mNTPCBinsFullDrift + mITSTPCTimeBinSafeMargin + mTPCTimeEdgeTSafeMargin);
+  int maxDriftROF = 1 + int(maxTDriftSafe * mTPCBin2ITSROFrame);
+
+  int nWindows = 0, nMatched = 0, ntpc = mTPCStreamOrder.size(), itpc = 0;
+  for (int rofMin = 0; itpc < ntpc; rofMin += mStreamingWindowROF) {
+    int rofMax = rofMin + mStreamingWindowROF; // 1st ROFrame of the next window
+
+    clearTPCWork(0);
+    while (itpc < ntpc) {
+      int it = mTPCStreamOrder[itpc];
+      if (tpcTimeBin2ITSROFrame(getTPCTrackTMax((*mTPCTracksArrayInp)[it])) >= rofMax) {
+        break;
+      }
+      addTPCTrack(it);
+      itpc++;
+    }
+    loadITSTracksUpToROF(rofMax);
+
+    if (mTPCWork.size() && mITSWork.size()) {
+      mMatchesTPC.clear();
+      mMatchesITS.clear();
+      mMatchRecordsTPC.clear();
+      mMatchRecordsITS.clear();
+      for (auto& its : mITSWork) {
+        if (its.matchID != Validated) {
+          its.matchID = MinusOne;
+        }
+      }
+      buildTPCSectorCaches();
+      buildITSSectorCaches();
+
+      matchPreparedTracks();
+
+      // flag ITS tracks used by validated matches, they will not be considered in the following windows
+      for (auto& its : mITSWork) {
+        if (its.matchID > MinusOne && isValidatedITS(mMatchesITS[its.matchID])) {
+          its.matchID = Validated;
+          nMatched++;
+        }
+      }
+      nWindows++;
+    }
+    releaseITSTracks(rofMax - maxDriftROF);
+  }
+  mTPCWork.clear();
+  mTPCLblWork.clear();
+  clearITSWork();
+  LOG(INFO) << "Matched " << nMatched << " of " << ntpc << " TPC tracks in " << nWindows << " windows of "
+            << mStreamingWindowROF << " ITS ROFrames" << FairLogger::endl;
 }
 
 //______________________________________________
@@ -326,53 +410,74 @@ bool MatchTPCITS::prepareTPCTracks()
   mMatchRecordsTPC.reserve(mMatchRecordsTPC.size() + mMaxMatchCandidates * ntr);
 
   // copy the track params, propagate to reference X and build sector tables
+  clearTPCWork(ntr);
+  for (int it = 0; it < ntr; it++) {
+    addTPCTrack(it);
+  }
+  buildTPCSectorCaches();
+
+  return true;
+}
+
+//______________________________________________
+void MatchTPCITS::clearTPCWork(int nreserve)
+{
+  ///< clear TPC work arrays, reserving space for nreserve tracks
   mTPCWork.clear();
-  mTPCWork.reserve(ntr);
+  mTPCWork.reserve(nreserve);
   if (mMCTruthON) {
     mTPCLblWork.clear();
-    mTPCLblWork.reserve(ntr);
+    mTPCLblWork.reserve(nreserve);
+  }
+}
+
+//______________________________________________
+bool MatchTPCITS::addTPCTrack(int it)
+{
+  ///< create work copy of the TPC track it of currently loaded chunk, return false if it cannot be matched
+  o2::TPC::TrackTPC& trcOrig = (*mTPCTracksArrayInp)[it];
+
+  // make sure the track was propagated to inner TPC radius at the ref. radius
+  if (trcOrig.getX() > mXTPCInnerRef + 0.1)
+    return false; // failed propagation to inner TPC radius, cannot be matched
+
+  // create working copy of track param
+  mTPCWork.emplace_back(static_cast<o2::track::TrackParCov&>(trcOrig), mCurrTPCTracksTreeEntry, it);
+  auto& trc = mTPCWork.back();
+  // propagate to matching Xref
+  if (!propagateToRefX(trc)) {
+    mTPCWork.pop_back(); // discard track whose propagation to mXRef failed
+    return false;
+  }
+  if (mMCTruthON) {
+    mTPCLblWork.emplace_back(mTPCTrkLabels->getLabels(it)[0]);
+  }
+
+  float time0 = trcOrig.getTime0() - mNTPCBinsFullDrift;
+  trc.timeBins.set(time0 - trcOrig.getDeltaTBwd() - mTPCTimeEdgeTSafeMargin, getTPCTrackTMax(trcOrig));
+  // assign min max possible Z for this track which still respects the clusters A/C side
+  if (trcOrig.hasASideClustersOnly()) {
+    trc.zMin = trc.getZ() - trcOrig.getDeltaTBwd() * mTPCBin2Z;
+    trc.zMax = trc.getZ() + trcOrig.getDeltaTFwd() * mTPCBin2Z;
+  } else if (trcOrig.hasCSideClustersOnly()) {
+    trc.zMin = trc.getZ() - trcOrig.getDeltaTFwd() * mTPCBin2Z;
+    trc.zMax = trc.getZ() + trcOrig.getDeltaTBwd() * mTPCBin2Z;
   }
+  // TODO : special treatment of tracks crossing the CE
+  return true;
+}
+
+//______________________________________________
+void MatchTPCITS::buildTPCSectorCaches()
+{
+  ///< cache per sector indices of TPC work tracks, sorted in time, with 1st entries per ITS ROFrame
   for (int sec = o2::constants::math::NSectors; sec--;) {
     mTPCSectIndexCache[sec].clear();
-    mTPCSectIndexCache[sec].reserve(100 + 1.2 * ntr / o2::constants::math::NSectors);
+    mTPCSectIndexCache[sec].reserve(100 + 1.2 * mTPCWork.size() / o2::constants::math::NSectors);
     mTPCTimeBinStart[sec].clear();
   }
-
-  for (int it = 0; it < ntr; it++) {
-
-    o2::TPC::TrackTPC& trcOrig = (*mTPCTracksArrayInp)[it];
-
-    // make sure the track was propagated to inner TPC radius at the ref. radius
-    if (trcOrig.getX() > mXTPCInnerRef + 0.1)
-      continue; // failed propagation to inner TPC radius, cannot be matched
-
-    // create working copy of track param
-    mTPCWork.emplace_back(static_cast<o2::track::TrackParCov&>(trcOrig), mCurrTPCTracksTreeEntry, it);
-    auto& trc = mTPCWork.back();
-    // propagate to matching Xref
-    if (!propagateToRefX(trc)) {
-      mTPCWork.pop_back(); // discard track whose propagation to mXRef failed
-      continue;
-    }
-    if (mMCTruthON) {
-      mTPCLblWork.emplace_back(mTPCTrkLabels->getLabels(it)[0]);
-    }
-
-    float time0 = trcOrig.getTime0() - mNTPCBinsFullDrift;
-    trc.timeBins.set(time0 - trcOrig.getDeltaTBwd() - mTPCTimeEdgeTSafeMargin,
-                     time0 + trcOrig.getDeltaTFwd() + mTPCTimeEdgeTSafeMargin);
-    // assign min max possible Z for this track which still respects the clusters A/C side
-    if (trcOrig.hasASideClustersOnly()) {
-      trc.zMin = trc.getZ() - trcOrig.getDeltaTBwd() * mTPCBin2Z;
-      trc.zMax = trc.getZ() + trcOrig.getDeltaTFwd() * mTPCBin2Z;
-    } else if (trcOrig.hasCSideClustersOnly()) {
-      trc.zMin = trc.getZ() - trcOrig.getDeltaTFwd() * mTPCBin2Z;
-      trc.zMax = trc.getZ() + trcOrig.getDeltaTBwd() * mTPCBin2Z;
-    }
-    // TODO : special treatment of tracks crossing the CE
-
-    // cache work track index
-    mTPCSectIndexCache[o2::utils::Angle2Sector(trc.getAlpha())].push_back(mTPCWork.size() - 1);
+  for (int it = 0; it < int(mTPCWork.size()); it++) {
+    mTPCSectIndexCache[o2::utils::Angle2Sector(mTPCWork[it].getAlpha())].push_back(it);
   }
 
   // sort tracks in each sector according to their timeMax
@@ -409,8 +514,6 @@ bool MatchTPCITS::prepareTPCTracks()
       }
     }
   } // loop over tracks of single sector
-
-  return true;
 }
 
 //_____________________________________________________
@@ -418,71 +521,103 @@ bool MatchTPCITS::prepareITSTracks()
 {
   // load next chunk of ITS data and prepare for matching
   mMatchesITS.clear();
-  mITSWork.clear();
   // number of records might be actually more than N tracks!
   mMatchRecordsITS.clear(); // RS TODO reserve(mMatchRecordsITS.size() + mMaxMatchCandidates*ntr);
+  clearITSWork();
+
+  while (loadITSTracksNextChunk()) {
+    addITSTracksFromCurrentChunk();
+  }
+  buildITSSectorCaches();
+
+  return true;
+}
+
+//_____________________________________________________
+void MatchTPCITS::clearITSWork()
+{
+  ///< clear ITS work arrays
+  mITSWork.clear();
   if (mMCTruthON) {
     mITSLblWork.clear();
   }
-  for (int sec = o2::constants::math::NSectors; sec--;) {
-    mITSSectIndexCache[sec].clear();
-  }
+}
 
-  while (loadITSTracksNextChunk()) {
-    int ntr = mITSTracksArrayInp->size();
-    for (int it = 0; it < ntr; it++) {
-      auto& trcOrig = (*mITSTracksArrayInp)[it];
+//_____________________________________________________
+void MatchTPCITS::addITSTracksFromCurrentChunk()
+{
+  ///< create work copies of the ITS tracks of currently loaded chunk
+  int ntr = mITSTracksArrayInp->size();
+  for (int it = 0; it < ntr; it++) {
+    auto& trcOrig = (*mITSTracksArrayInp)[it];
 
-      if (trcOrig.getParamOut().getX() < 1.) {
-        continue; // backward refit failed
-      }
-      // working copy of outer track param
-      mITSWork.emplace_back(static_cast<o2::track::TrackParCov&>(trcOrig.getParamOut()), mCurrITSTracksTreeEntry, it);
-      auto& trc = mITSWork.back();
+    if (trcOrig.getROFrame() > mMaxStreamedITSROF) {
+      mMaxStreamedITSROF = trcOrig.getROFrame();
+    }
+    if (trcOrig.getParamOut().getX() < 1.) {
+      continue; // backward refit failed
+    }
+    // working copy of outer track param
+    mITSWork.emplace_back(static_cast<o2::track::TrackParCov&>(trcOrig.getParamOut()), mCurrITSTracksTreeEntry, it);
+    auto& trc = mITSWork.back();
 
-      // TODO: why I did this?
-      if (!trc.rotate(o2::utils::Angle2Alpha(trc.getPhiPos()))) {
-        mITSWork.pop_back(); // discard failed track
-        continue;
-      }
-      // make sure the track is at the ref. radius
-      if (!propagateToRefX(trc)) {
-        mITSWork.pop_back(); // discard failed track
-        continue;            // add to cache only those ITS tracks which reached ref.X and have reasonable snp
-      }
-      if (mMCTruthON) {
-        mITSLblWork.emplace_back(mITSTrkLabels->getLabels(it)[0]);
-      }
+    // TODO: why I did this?
+    if (!trc.rotate(o2::utils::Angle2Alpha(trc.getPhiPos()))) {
+      mITSWork.pop_back(); // discard failed track
+      continue;
+    }
+    // make sure the track is at the ref. radius
+    if (!propagateToRefX(trc)) {
+      mITSWork.pop_back(); // discard failed track
+      continue;            // add to cache only those ITS tracks which reached ref.X and have reasonable snp
+    }
+    if (mMCTruthON) {
+      mITSLblWork.emplace_back(mITSTrkLabels->getLabels(it)[0]);
+    }
 
-      float tmn = itsROFrame2TPCTimeBin(trcOrig.getROFrame());
-      trc.timeBins.set(tmn, tmn + mITSROFrame2TPCBin);
-      trc.roFrame = trcOrig.getROFrame();
-
-      // cache work track index
-      int sector = o2::utils::Angle2Sector(trc.getAlpha());
-      mITSSectIndexCache[sector].push_back(mITSWork.size() - 1);
-
-      // If the ITS track is very close to the sector edge, it may match also to a TPC track in the neighb. sector.
-      // For a track with Yr and Phir at Xr the distance^2 between the poisition of this track in the neighb. sector
-      // when propagated to Xr (in this neighbouring sector) and the edge will be (neglecting the curvature)
-      // [(Xr*tg(10)-Yr)/(tgPhir+tg70)]^2  / cos(70)^2  // for the next sector
-      // [(Xr*tg(10)+Yr)/(tgPhir-tg70)]^2  / cos(70)^2  // for the prev sector
-      // Distances to the sector edges in neighbourings sectors (at Xref in theit proper frames)
-      float tgp = trc.getSnp();
-      tgp /= std::sqrt((1.f - tgp) * (1.f + tgp)); // tan of track direction XY
-
-      // sector up
-      float dy2Up = (mYMaxAtXRef - trc.getY()) / (tgp + Tan70);
-      if ((dy2Up * dy2Up * Cos70I2) < mSectEdgeMargin2) { // need to check this track for matching in sector up
-        addTrackCloneForNeighbourSector(trc, sector < (o2::constants::math::NSectors - 1) ? sector + 1 : 0);
-      }
-      // sector down
-      float dy2Dn = (mYMaxAtXRef + trc.getY()) / (tgp - Tan70);
-      if ((dy2Dn * dy2Dn * Cos70I2) < mSectEdgeMargin2) { // need to check this track for matching in sector down
-        addTrackCloneForNeighbourSector(trc, sector > 1 ? sector - 1 : o2::constants::math::NSectors - 1);
-      }
+    float tmn = itsROFrame2TPCTimeBin(trcOrig.getROFrame());
+    trc.timeBins.set(tmn, tmn + mITSROFrame2TPCBin);
+    trc.roFrame = trcOrig.getROFrame();
+
+    int sector = o2::utils::Angle2Sector(trc.getAlpha());
+
+    // If the ITS track is very close to the sector edge, it may match also to a TPC track in the neighb. sector.
+    // For a track with Yr and Phir at Xr the distance^2 between the poisition of this track in the neighb. sector
+    // when propagated to Xr (in this neighbouring sector) and the edge will be (neglecting the curvature)
+    // [(Xr*tg(10)-Yr)/(tgPhir+tg70)]^2  / cos(70)^2  // for the next sector
+    // [(Xr*tg(10)+Yr)/(tgPhir-tg70)]^2  / cos(70)^2  // for the prev sector
+    // Distances to the sector edges in neighbourings sectors (at Xref in theit proper frames)
+    float tgp = trc.getSnp();
+    tgp /= std::sqrt((1.f - tgp) * (1.f + tgp)); // tan of track direction XY
+
+    // sector up
+    float dy2Up = (mYMaxAtXRef - trc.getY()) / (tgp + Tan70);
+    if ((dy2Up * dy2Up * Cos70I2) < mSectEdgeMargin2) { // need to check this track for matching in sector up
+      addTrackCloneForNeighbourSector(trc, sector < (o2::constants::math::NSectors - 1) ? sector + 1 : 0);
+    }
+    // sector down
+    float dy2Dn = (mYMaxAtXRef + trc.getY()) / (tgp - Tan70);
+    if ((dy2Dn * dy2Dn * Cos70I2) < mSectEdgeMargin2) { // need to check this track for matching in sector down
+      addTrackCloneForNeighbourSector(trc, sector > 1 ? sector - 1 : o2::constants::math::NSectors - 1);
+    }
+  }
+}
+
+//_____________________________________________________
+void MatchTPCITS::buildITSSectorCaches()
+{
+  ///< cache per sector indices of ITS work tracks, sorted in ROFrame and tgl, with 1st entries per ROFrame
+  for (int sec = o2::constants::math::NSectors; sec--;) {
+    mITSSectIndexCache[sec].clear();
+    mITSTimeBinStart[sec].clear();
+  }
+  for (int it = 0; it < int(mITSWork.size()); it++) {
+    if (mITSWork[it].matchID == Validated) {
+      continue; // already used by the match validated in the previous streaming window
     }
+    mITSSectIndexCache[o2::utils::Angle2Sector(mITSWork[it].getAlpha())].push_back(it);
   }
+
   // sort tracks in each sector according to their time, then tgl
   for (int sec = o2::constants::math::NSectors; sec--;) {
     auto& indexCache = mITSSectIndexCache[sec];
@@ -520,10 +655,63 @@ bool MatchTPCITS::prepareITSTracks()
   } // loop over tracks of single sector
   mMatchesITS.reserve(mITSWork.size());
   mMatchRecordsITS.reserve(mITSWork.size() * mMaxMatchCandidates);
+}
 
+//_____________________________________________________
+void MatchTPCITS::sortTPCTracksForStreaming()
+{
+  ///< sort indices of currently loaded TPC tracks in the max ITS ROFrame they may match to
+  int ntr = mTPCTracksArrayInp->size();
+  mTPCStreamOrder.resize(ntr);
+  for (int it = 0; it < ntr; it++) {
+    mTPCStreamOrder[it] = it;
+  }
+  std::sort(mTPCStreamOrder.begin(), mTPCStreamOrder.end(), [this](int a, int b) {
+    return getTPCTrackTMax((*mTPCTracksArrayInp)[a]) < getTPCTrackTMax((*mTPCTracksArrayInp)[b]);
+  });
+  mMatchesTPC.clear();
+  mMatchRecordsTPC.clear();
+}
+
+//_____________________________________________________
+bool MatchTPCITS::loadITSTracksUpToROF(int rof)
+{
+  ///< stream in ITS tracks chunks until the tracks of ROFrame rof are loaded,
+  ///< assuming that the ITS tracks tree entries are ordered in ROFrames
+  while (mMaxStreamedITSROF < rof) {
+    if (mNextITSStreamEntry >= mTreeITSTracks->GetEntries()) {
+      return false;
+    }
+    loadITSTracksChunk(mNextITSStreamEntry++);
+    addITSTracksFromCurrentChunk();
+  }
   return true;
 }
 
+//_____________________________________________________
+void MatchTPCITS::releaseITSTracks(int rofMin)
+{
+  ///< remove from work arrays the ITS tracks with ROFrame below rofMin
+  int nkeep = 0, ntr = mITSWork.size();
+  for (int it = 0; it < ntr; it++) {
+    if (mITSWork[it].roFrame < rofMin) {
+      continue;
+    }
+    if (it != nkeep) {
+      mITSWork[nkeep] = mITSWork[it];
+      if (mMCTruthON) {
+        mITSLblWork[nkeep] = mITSLblWork[it];
+      }
+    }
+    nkeep++;
+  }
+  mITSWork.resize(nkeep);
+  if (mMCTruthON) {
+    mITSLblWork.resize(nkeep);
+  }
+  LOG(DEBUG) << "Released " << ntr - nkeep << " ITS tracks below ROFrame " << rofMin << FairLogger::endl;
+}
+
 //_____________________________________________________
 bool MatchTPCITS::loadITSTracksNextChunk()
 {
@@ -976,7 +1164,6 @@ void MatchTPCITS::addTrackCloneForNeighbourSector(const TrackLocITS& src, int se
       o2::Base::Propagator::Instance()->PropagateToXBxByBz(trc, mXRef, o2::constants::physics::MassPionCharged, MaxSnp,
                                                            2., 0)) {
     // TODO: use faster prop here, no 3d field, materials
-    mITSSectIndexCache[sector].push_back(mITSWork.size() - 1); // register track CLONE
     if (mMCTruthON) {
       mITSLblWork.emplace_back(mITSTrkLabels->getLabels(src.source.getIndex())[0]);
     }
@@ -1039,6 +1226,11 @@ void MatchTPCITS::print() const
   printf("TPC-ITS time(bins) bracketing safety margin: %6.2f\n", mTimeBinTolerance);
   printf("TPC Z->time(bins) bracketing safety margin: %6.2f\n", mTPCTimeEdgeZSafeMargin);
   printf("Max.Number of matched tracks per output entry: %d\n", mMaxOutputTracksPerEntry);
+  if (mStreamingWindowROF > 0) {
+    printf("Streaming matching in windows of %d ITS ROFrames\n", mStreamingWindowROF);
+  } else {
+    printf("Streaming matching: off\n");
+  }
 
 #ifdef _ALLOW_DEBUG_TREES_
 
@@ -1065,6 +1257,7 @@ void MatchTPCITS::refitWinners()
   mTimerRefit.Start(false);
 
   LOG(INFO) << "Refitting winner matches" << FairLogger::endl;
+  mWinnerChi2Refit.clear();
   mWinnerChi2Refit.resize(mITSWork.size(), -1.f);
   mCurrITSTracksTreeEntry = -1;
   mCurrITSClustersTreeEntry = -1;
@@ -1193,7 +1386,7 @@ void MatchTPCITS::loadTPCTracksChunk(int chunk)
   // load single entry from TPC tracks tree
   if (mCurrTPCTracksTreeEntry != chunk) {
     mTimerIO.Start(false);
-    mTreeITSTracks->GetEntry(mCurrTPCTracksTreeEntry = chunk);
+    mTreeTPCTracks->GetEntry(mCurrTPCTracksTreeEntry = chunk);
     mTimerIO.Stop();
   }
 }
@@ -0,0 +1,87 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PadGrid.h"
+#include <cmath>
+#include <limits>
+
+namespace o2
+{
+namespace mch
+{
+namespace mapping
+{
+namespace impl3
+{
+
+PadGrid::PadGrid(std::vector<Box> padBoxes, int maxCellsPerPad) : mPadBoxes{ std::move(padBoxes) }
+{
+  if (mPadBoxes.empty()) {
+    return;
+  }
+
+  // bounding box of all the pads and size of the smallest one
+  double xmax{ std::numeric_limits<double>::lowest() };
+  double ymax{ std::numeric_limits<double>::lowest() };
+  double dx{ std::numeric_limits<double>::max() };
+  double dy{ std::numeric_limits<double>::max() };
+  mXmin = std::numeric_limits<double>::max();
+  mYmin = std::numeric_limits<double>::max();
+  for (const auto& box : mPadBoxes) {
+    mXmin = std::min(mXmin, box.xmin);
+    mYmin = std::min(mYmin, box.ymin);
+    xmax = std::max(xmax, box.xmax);
+    ymax = std::max(ymax, box.ymax);
+    dx = std::min(dx, box.xmax - box.xmin);
+    dy = std::min(dy, box.ymax - box.ymin);
+  }
+
+  // cells of the size of the smallest pad, enlarged if there would be too many of them
+  double nofCellsX = std::ceil((xmax - mXmin) / dx);
+  double nofCellsY = std::ceil((ymax - mYmin) / dy);
+  double maxNofCells = static_cast<double>(maxCellsPerPad) * mPadBoxes.size();
+  if (nofCellsX * nofCellsY > maxNofCells) {
+    double scale = std::sqrt(nofCellsX * nofCellsY / maxNofCells);
+    nofCellsX = std::ceil(nofCellsX / scale);
+    nofCellsY = std::ceil(nofCellsY / scale);
+  }
+  mNofCellsX = std::max(1, static_cast<int>(nofCellsX));
+  mNofCellsY = std::max(1, static_cast<int>(nofCellsY));
+  mInvDx = mNofCellsX / (xmax - mXmin);
+  mInvDy = mNofCellsY / (ymax - mYmin);
+
+  // register each pad in all the cells it intersects (counting first, then filling)
+  auto forEachCell = [this](const Box& box, auto&& func) {
+    for (int iy = cellY(box.ymin), iy2 = cellY(box.ymax); iy <= iy2; ++iy) {
+      for (int ix = cellX(box.xmin), ix2 = cellX(box.xmax); ix <= ix2; ++ix) {
+        func(ix + iy * mNofCellsX);
+      }
+    }
+  };
+
+  mCellFirstPad.assign(nofCells() + 1, 0);
+  for (const auto& box : mPadBoxes) {
+    forEachCell(box, [this](int cell) { ++mCellFirstPad[cell + 1]; });
+  }
+  for (int cell = 0; cell < nofCells(); ++cell) {
+    mCellFirstPad[cell + 1] += mCellFirstPad[cell];
+  }
+
+  mCellPads.resize(mCellFirstPad.back());
+  std::vector<int> next(mCellFirstPad.begin(), mCellFirstPad.end() - 1);
+  for (int paduid = 0; paduid < static_cast<int>(mPadBoxes.size()); ++paduid) {
+    forEachCell(mPadBoxes[paduid], [this, &next, paduid](int cell) { mCellPads[next[cell]++] = paduid; });
+  }
+}
+
+} // namespace impl3
+} // namespace mapping
+} // namespace mch
+} // namespace o2
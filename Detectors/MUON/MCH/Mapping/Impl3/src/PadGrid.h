@@ -0,0 +1,108 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// @brief Uniform grid of cells, each one pointing to the pads it intersects
+
+#ifndef O2_MCH_MAPPING_IMPL3_PADGRID_H
+#define O2_MCH_MAPPING_IMPL3_PADGRID_H
+
+#include <algorithm>
+#include <vector>
+
+namespace o2
+{
+namespace mch
+{
+namespace mapping
+{
+namespace impl3
+{
+
+/// A PadGrid divides the bounding box of the pads of one segmentation
+/// in a uniform grid of cells (by default the size of the smallest pad),
+/// and keeps for each cell the list of pads intersecting it.
+///
+/// Position and area queries then only have to check the few pads
+/// of the cells they cover, instead of going through a tree.
+class PadGrid
+{
+ public:
+  struct Box {
+    double xmin, ymin, xmax, ymax;
+  };
+
+  PadGrid() = default;
+
+  /// Build the grid for the given pads, the paduid being the index in the vector.
+  /// The number of cells is limited to maxCellsPerPad times the number of pads.
+  explicit PadGrid(std::vector<Box> padBoxes, int maxCellsPerPad = 16);
+
+  /// Call func(paduid) once for each pad intersecting the box {xmin,ymin,xmax,ymax}
+  /// (pads touching the box included).
+  template <typename CALLABLE>
+  void forEachPadInArea(double xmin, double ymin, double xmax, double ymax, CALLABLE&& func) const;
+
+  int nofCells() const { return mNofCellsX * mNofCellsY; }
+
+ private:
+  int cellX(double x) const { return std::min(mNofCellsX - 1, std::max(0, static_cast<int>((x - mXmin) * mInvDx))); }
+
+  int cellY(double y) const { return std::min(mNofCellsY - 1, std::max(0, static_cast<int>((y - mYmin) * mInvDy))); }
+
+ private:
+  std::vector<Box> mPadBoxes{};
+  double mXmin{ 0 };
+  double mYmin{ 0 };
+  double mInvDx{ 0 };
+  double mInvDy{ 0 };
+  int mNofCellsX{ 0 };
+  int mNofCellsY{ 0 };
+  std::vector<int> mCellFirstPad{}; // index in mCellPads of the first pad of each cell (plus the end)
+  std::vector<int> mCellPads{};     // paduids of the pads intersecting each cell
+};
+
+template <typename CALLABLE>
+void PadGrid::forEachPadInArea(double xmin, double ymin, double xmax, double ymax, CALLABLE&& func) const
+{
+  if (mCellPads.empty()) {
+    return;
+  }
+
+  int ix1 = cellX(xmin);
+  int ix2 = cellX(xmax);
+  int iy1 = cellY(ymin);
+  int iy2 = cellY(ymax);
+
+  for (int iy = iy1; iy <= iy2; ++iy) {
+    for (int ix = ix1; ix <= ix2; ++ix) {
+      int cell = ix + iy * mNofCellsX;
+      for (int i = mCellFirstPad[cell]; i < mCellFirstPad[cell + 1]; ++i) {
+        int paduid = mCellPads[i];
+        const Box& box = mPadBoxes[paduid];
+        if (box.xmin > xmax || box.xmax < xmin || box.ymin > ymax || box.ymax < ymin) {
+          continue;
+        }
+        // a pad can be registered in several cells of the area:
+        // only report it from the cell containing the lower left corner of the intersection
+        if (ix == cellX(std::max(box.xmin, xmin)) && iy == cellY(std::max(box.ymin, ymin))) {
+          func(paduid);
+        }
+      }
+    }
+  }
+}
+
+} // namespace impl3
+} // namespace mapping
+} // namespace mch
+} // namespace o2
+
+#endif
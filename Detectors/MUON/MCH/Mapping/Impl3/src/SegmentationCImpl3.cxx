@@ -15,6 +15,7 @@
 #include "SegmentationImpl3.h"
 #include "mchmappingimpl3_export.h"
 #include <fstream>
+#include <memory>
 
 extern "C" {
 
@@ -141,9 +142,7 @@ MCHMAPPINGIMPL3_EXPORT
 void mchSegmentationForEachPadInArea(MchSegmentationHandle segHandle, double xmin, double ymin, double xmax,
                                      double ymax, MchPadHandler handler, void* clientData)
 {
-  for (auto p : segHandle->impl->getPadUids(xmin, ymin, xmax, ymax)) {
-    handler(clientData, p);
-  }
+  segHandle->impl->forEachPadInArea(xmin, ymin, xmax, ymax, [&](int paduid) { handler(clientData, paduid); });
 }
 
 MCHMAPPINGIMPL3_EXPORT
@@ -49,9 +49,10 @@ Segmentation* createSegmentation(int detElemId, bool isBendingPlane)
   return creator(isBendingPlane);
 }
 
-void Segmentation::fillRtree()
+void Segmentation::fillPadGrid()
 {
   int paduid{ 0 };
+  std::vector<PadGrid::Box> padBoxes;
 
   for (auto padGroupIndex = 0; padGroupIndex < mPadGroups.size(); ++padGroupIndex) {
     mPadGroupIndex2PadUidIndex.push_back(paduid);
@@ -68,8 +69,7 @@ void Segmentation::fillRtree()
           double ymin = iy * dy + pg.mY;
           double ymax = (iy + 1) * dy + pg.mY;
 
-          mRtree.insert(std::make_pair(
-            Segmentation::Box{ Segmentation::Point(xmin, ymin), Segmentation::Point(xmax, ymax) }, paduid));
+          padBoxes.push_back({ xmin, ymin, xmax, ymax });
 
           mPadUid2PadGroupIndex.push_back(padGroupIndex);
           mPadUid2PadGroupTypeFastIndex.push_back(pgt.fastIndex(ix, iy));
@@ -78,6 +78,8 @@ void Segmentation::fillRtree()
       }
     }
   }
+
+  mPadGrid = PadGrid(std::move(padBoxes));
 }
 
 std::set<int> getUnique(const std::vector<PadGroup>& padGroups)
@@ -110,11 +112,12 @@ Segmentation::Segmentation(int segType, bool isBendingPlane, std::vector<PadGrou
     mDualSampaIds{ getUnique(mPadGroups) },
     mPadGroupTypes{ std::move(padGroupTypes) },
     mPadSizes{ std::move(padSizes) },
+    mPadGrid{},
     mPadUid2PadGroupIndex{},
     mPadUid2PadGroupTypeFastIndex{},
     mPadGroupIndex2PadUidIndex{}
 {
-  fillRtree();
+  fillPadGrid();
 }
 
 std::vector<int> Segmentation::getPadUids(int dualSampaId) const
@@ -136,13 +139,8 @@ std::vector<int> Segmentation::getPadUids(int dualSampaId) const
 
 std::vector<int> Segmentation::getPadUids(double xmin, double ymin, double xmax, double ymax) const
 {
-  std::vector<Segmentation::Value> result_n;
-  mRtree.query(boost::geometry::index::intersects(Segmentation::Box({ xmin, ymin }, { xmax, ymax })),
-               std::back_inserter(result_n));
   std::vector<int> paduids;
-  for (auto& r : result_n) {
-    paduids.push_back(r.second);
-  }
+  forEachPadInArea(xmin, ymin, xmax, ymax, [&paduids](int paduid) { paduids.push_back(paduid); });
   return paduids;
 }
 
@@ -170,18 +168,17 @@ double Segmentation::squaredDistance(int paduid, double x, double y) const
 int Segmentation::findPadByPosition(double x, double y) const
 {
   const double epsilon{ 1E-4 };
-  auto pads = getPadUids(x - epsilon, y - epsilon, x + epsilon, y + epsilon);
 
   double dmin{ std::numeric_limits<double>::max() };
   int paduid{ InvalidPadUid };
 
-  for (auto i = 0; i < pads.size(); ++i) {
-    double d{ squaredDistance(pads[i], x, y) };
+  forEachPadInArea(x - epsilon, y - epsilon, x + epsilon, y + epsilon, [&](int puid) {
+    double d{ squaredDistance(puid, x, y) };
     if (d < dmin) {
-      paduid = pads[i];
+      paduid = puid;
       dmin = d;
     }
-  }
+  });
 
   return paduid;
 }
@@ -14,12 +14,12 @@
 #ifndef O2_MCH_MAPPING_IMPL3_SEGMENTATION_H
 #define O2_MCH_MAPPING_IMPL3_SEGMENTATION_H
 
+#include "PadGrid.h"
 #include "PadGroup.h"
 #include "PadGroupType.h"
 #include <vector>
 #include <set>
 #include <ostream>
-#include <boost/geometry/index/rtree.hpp>
 
 namespace o2
 {
@@ -35,10 +35,6 @@ class Segmentation
  public:
   static constexpr int InvalidPadUid{ -1 };
 
-  using Point = boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian>;
-  using Box = boost::geometry::model::box<Point>;
-  using Value = std::pair<Box, unsigned>;
-
   Segmentation(int segType, bool isBendingPlane, std::vector<PadGroup> padGroups,
                std::vector<PadGroupType> padGroupTypes, std::vector<std::pair<float, float>> padSizes);
 
@@ -48,6 +44,13 @@ class Segmentation
   /// Return the list of paduids for the pads contained in the box {xmin,ymin,xmax,ymax}.
   std::vector<int> getPadUids(double xmin, double ymin, double xmax, double ymax) const;
 
+  /// Call func(paduid) for each pad contained in the box {xmin,ymin,xmax,ymax}.
+  template <typename CALLABLE>
+  void forEachPadInArea(double xmin, double ymin, double xmax, double ymax, CALLABLE&& func) const
+  {
+    mPadGrid.forEachPadInArea(xmin, ymin, xmax, ymax, func);
+  }
+
   /// Return the list of paduids of the pads which are neighbours to paduid
   std::vector<int> getNeighbouringPadUids(int paduid) const;
 
@@ -81,7 +84,7 @@ class Segmentation
  private:
   int dualSampaIndex(int dualSampaId) const;
 
-  void fillRtree();
+  void fillPadGrid();
 
   std::ostream& showPad(std::ostream& out, int index) const;
 
@@ -98,7 +101,7 @@ class Segmentation
   std::set<int> mDualSampaIds;
   std::vector<PadGroupType> mPadGroupTypes;
   std::vector<std::pair<float, float>> mPadSizes;
-  boost::geometry::index::rtree<Value, boost::geometry::index::quadratic<8>> mRtree;
+  PadGrid mPadGrid;
   std::vector<int> mPadUid2PadGroupIndex;
   std::vector<int> mPadUid2PadGroupTypeFastIndex;
   std::vector<int> mPadGroupIndex2PadUidIndex;
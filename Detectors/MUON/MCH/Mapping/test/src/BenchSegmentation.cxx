@@ -106,10 +106,35 @@ BENCHMARK_DEFINE_F(BenchO2, findPadByPosition)(benchmark::State& state)
   state.counters["ntp"] = ntp;
 }
 
+// time the area queries, with areas of the size typically used to look for pads around a cluster
+BENCHMARK_DEFINE_F(BenchO2, forEachPadInArea)(benchmark::State& state)
+{
+  int detElemId = state.range(0);
+  bool isBendingPlane = state.range(1);
+  o2::mch::mapping::Segmentation seg{ detElemId, isBendingPlane };
+  auto bbox = o2::mch::mapping::getBBox(seg);
+
+  const int n = 100000;
+  const double halfSize = 1.0; // cm
+  auto testpoints = generateUniformTestPoints(n, bbox.xmin(), bbox.ymin(), bbox.xmax(), bbox.ymax());
+
+  int npads{ 0 };
+  for (auto _ : state) {
+    npads = 0;
+    for (auto& tp : testpoints) {
+      seg.forEachPadInArea(tp.x - halfSize, tp.y - halfSize, tp.x + halfSize, tp.y + halfSize,
+                           [&npads](int /*paduid*/) { ++npads; });
+    }
+  }
+  state.counters["npads"] = npads;
+}
+
 BENCHMARK(benchSegmentationConstructionAll)->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(BenchO2, findPadByPosition)->Apply(segmentationList)->Unit(benchmark::kMillisecond);
 
+BENCHMARK_REGISTER_F(BenchO2, forEachPadInArea)->Apply(segmentationList)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_REGISTER_F(BenchO2, ctor)->Apply(segmentationList)->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
@@ -10,7 +10,9 @@
 
 #include "PreClusterFinder.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -24,6 +26,13 @@ namespace mch
 
 using namespace std;
 
+//_________________________________________________________________________________________________
+PreClusterFinder::~PreClusterFinder()
+{
+  /// Destructor
+  stopWorkers();
+}
+
 //_________________________________________________________________________________________________
 void PreClusterFinder::init(std::string& fileName)
 {
@@ -54,36 +63,151 @@ void PreClusterFinder::deinit()
 void PreClusterFinder::reset()
 {
   /// reset fired pad and precluster information
+  processDEs([this](int iDE) { reset(iDE); });
+}
+
+//_________________________________________________________________________________________________
+void PreClusterFinder::reset(int iDE)
+{
+  /// reset fired pad and precluster information of the DE "iDE"
 
   Mapping::MpPad* pad(nullptr);
 
-  // loop over DEs
-  for (int iDE = 0; iDE < SNDEs; ++iDE) {
+  DetectionElement& de(mDEs[iDE]);
 
-    DetectionElement& de(mDEs[iDE]);
+  // loop over planes
+  for (int iPlane = 0; iPlane < 2; ++iPlane) {
 
-    // loop over planes
-    for (int iPlane = 0; iPlane < 2; ++iPlane) {
+    // clear number of preclusters
+    mNPreClusters[iDE][iPlane] = 0;
+
+    // loop over fired pads
+    for (int iFiredPad = 0; iFiredPad < de.nFiredPads[iPlane]; ++iFiredPad) {
+
+      pad = &de.mapping->pads[de.firedPads[iPlane][iFiredPad]];
+      pad->iDigit = 0;
+      pad->useMe = false;
+    }
+
+    // clear number of fired pads
+    de.nFiredPads[iPlane] = 0;
+  }
+
+  // clear ordered number of fired pads
+  de.nOrderedPads[0] = 0;
+  de.nOrderedPads[1] = 0;
+  mNMergedPreClusters[iDE] = 0;
+}
+
+//_________________________________________________________________________________________________
+void PreClusterFinder::setNThreads(int nThreads)
+{
+  /// process the DEs in parallel using nThreads threads, including the calling one
+
+  stopWorkers();
+
+  mStopWorkers = false;
+  for (int iThread = 1; iThread < nThreads; ++iThread) {
+    mWorkers.emplace_back(&PreClusterFinder::workerLoop, this);
+  }
+}
+
+//_________________________________________________________________________________________________
+void PreClusterFinder::processDEs(const std::function<void(int)>& task)
+{
+  /// execute the task on every DE, distributing the DEs between the calling thread and the workers.
+  /// The task must only access data belonging to the DE it is given.
+  /// The first exception thrown by the task is rethrown once all DEs have been processed
+
+  if (mWorkers.empty()) {
+    for (int iDE = 0; iDE < SNDEs; ++iDE) {
+      task(iDE);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mTaskMutex);
+    mTask = &task;
+    mTaskException = nullptr;
+    mNextDE = 0;
+    mNBusyWorkers = mWorkers.size();
+    ++mTaskId;
+  }
+  mTaskReady.notify_all();
+
+  runTask(task);
 
-      // clear number of preclusters
-      mNPreClusters[iDE][iPlane] = 0;
+  std::unique_lock<std::mutex> lock(mTaskMutex);
+  mTaskDone.wait(lock, [this] { return mNBusyWorkers == 0; });
+  mTask = nullptr;
 
-      // loop over fired pads
-      for (int iFiredPad = 0; iFiredPad < de.nFiredPads[iPlane]; ++iFiredPad) {
+  if (mTaskException) {
+    std::rethrow_exception(mTaskException);
+  }
+}
 
-        pad = &de.mapping->pads[de.firedPads[iPlane][iFiredPad]];
-        pad->iDigit = 0;
-        pad->useMe = false;
+//_________________________________________________________________________________________________
+void PreClusterFinder::runTask(const std::function<void(int)>& task)
+{
+  /// execute the task on the DEs not yet processed by another thread
+
+  for (int iDE = mNextDE++; iDE < SNDEs; iDE = mNextDE++) {
+    try {
+      task(iDE);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mTaskMutex);
+      if (!mTaskException) {
+        mTaskException = std::current_exception();
       }
+    }
+  }
+}
 
-      // clear number of fired pads
-      de.nFiredPads[iPlane] = 0;
+//_________________________________________________________________________________________________
+void PreClusterFinder::workerLoop()
+{
+  /// wait for tasks and help processing the DEs
+
+  uint64_t lastTaskId(0);
+
+  while (true) {
+
+    const std::function<void(int)>* task(nullptr);
+    {
+      std::unique_lock<std::mutex> lock(mTaskMutex);
+      mTaskReady.wait(lock, [this, lastTaskId] { return mStopWorkers || mTaskId != lastTaskId; });
+      if (mStopWorkers) {
+        return;
+      }
+      lastTaskId = mTaskId;
+      task = mTask;
     }
 
-    // clear ordered number of fired pads
-    de.nOrderedPads[0] = 0;
-    de.nOrderedPads[1] = 0;
+    runTask(*task);
+
+    std::lock_guard<std::mutex> lock(mTaskMutex);
+    if (--mNBusyWorkers == 0) {
+      mTaskDone.notify_one();
+    }
+  }
+}
+
+//_________________________________________________________________________________________________
+void PreClusterFinder::stopWorkers()
+{
+  /// terminate the worker threads
+
+  {
+    std::lock_guard<std::mutex> lock(mTaskMutex);
+    mStopWorkers = true;
+  }
+  mTaskReady.notify_all();
+
+  for (auto& worker : mWorkers) {
+    worker.join();
   }
+  mWorkers.clear();
 }
 
 //_________________________________________________________________________________________________
@@ -136,154 +260,167 @@ void PreClusterFinder::loadDigits(const DigitStruct* digits, uint32_t nDigits)
 int PreClusterFinder::run()
 {
   /// preclusterize each cathod separately then merge them
-  preClusterizeRecursive();
-  return mergePreClusters();
+
+  processDEs([this](int iDE) {
+    preClusterize(iDE);
+    mNMergedPreClusters[iDE] = mergePreClusters(iDE);
+  });
+
+  int nPreClusters(0);
+  for (int iDE = 0; iDE < SNDEs; ++iDE) {
+    nPreClusters += mNMergedPreClusters[iDE];
+  }
+
+  return nPreClusters;
 }
 
 //_________________________________________________________________________________________________
-void PreClusterFinder::preClusterizeRecursive()
+void PreClusterFinder::preClusterize(int iDE)
 {
-  /// preclusterize both planes of every DE using recursive algorithm
+  /// preclusterize both planes of the DE "iDE" using an iterative flood-fill algorithm
 
-  PreCluster* cluster(nullptr);
   uint16_t iPad(0);
 
-  // loop over DEs
-  for (int iDE = 0; iDE < SNDEs; ++iDE) {
-
-    DetectionElement& de(mDEs[iDE]);
+  DetectionElement& de(mDEs[iDE]);
 
-    // loop over planes
-    for (int iPlane = 0; iPlane < 2; ++iPlane) {
-
-      // loop over fired pads
-      for (int iFiredPad = 0; iFiredPad < de.nFiredPads[iPlane]; ++iFiredPad) {
-
-        iPad = de.firedPads[iPlane][iFiredPad];
+  // make room for all the fired pads so that they can be added without further check
+  size_t nFiredPads = de.nFiredPads[0] + de.nFiredPads[1];
+  if (de.orderedPads[0].size() < nFiredPads) {
+    de.orderedPads[0].resize(nFiredPads);
+  }
 
-        if (de.mapping->pads[iPad].useMe) {
+  // loop over planes
+  for (int iPlane = 0; iPlane < 2; ++iPlane) {
 
-          // create the precluster if needed
-          if (mNPreClusters[iDE][iPlane] >= mPreClusters[iDE][iPlane].size()) {
-            mPreClusters[iDE][iPlane].push_back(std::make_unique<PreCluster>());
-          }
+    // loop over fired pads
+    for (int iFiredPad = 0; iFiredPad < de.nFiredPads[iPlane]; ++iFiredPad) {
 
-          // get the precluster
-          cluster = mPreClusters[iDE][iPlane][mNPreClusters[iDE][iPlane]].get();
-          ++mNPreClusters[iDE][iPlane];
+      iPad = de.firedPads[iPlane][iFiredPad];
 
-          // reset its content
-          cluster->area[0][0] = 1.e6;
-          cluster->area[0][1] = -1.e6;
-          cluster->area[1][0] = 1.e6;
-          cluster->area[1][1] = -1.e6;
-          cluster->useMe = true;
-          cluster->storeMe = false;
+      if (de.mapping->pads[iPad].useMe) {
 
-          // add the pad and its fired neighbours recusively
-          cluster->firstPad = de.nOrderedPads[0];
-          addPad(de, iPad, *cluster);
+        // extend the pool of preclusters if needed
+        if (mNPreClusters[iDE][iPlane] >= mPreClusters[iDE][iPlane].size()) {
+          mPreClusters[iDE][iPlane].emplace_back();
         }
+
+        // get the precluster
+        PreCluster& cluster(mPreClusters[iDE][iPlane][mNPreClusters[iDE][iPlane]]);
+        ++mNPreClusters[iDE][iPlane];
+
+        // reset its content
+        cluster.area[0][0] = 1.e6;
+        cluster.area[0][1] = -1.e6;
+        cluster.area[1][0] = 1.e6;
+        cluster.area[1][1] = -1.e6;
+        cluster.useMe = true;
+        cluster.storeMe = false;
+
+        // add the pad and all its fired neighbours
+        cluster.firstPad = de.nOrderedPads[0];
+        addPads(de, iPad, cluster);
       }
     }
   }
 }
 
 //_________________________________________________________________________________________________
-void PreClusterFinder::addPad(DetectionElement& de, uint16_t iPad, PreCluster& cluster)
+void PreClusterFinder::addPads(DetectionElement& de, uint16_t iPad, PreCluster& cluster)
 {
-  /// add the given MpPad and its fired neighbours (recursive method)
+  /// add the given MpPad and all its fired neighbours (iterative method):
+  /// the pads added to the orderedPads array are used as the queue of pads to be visited
 
   Mapping::MpPad* pads(de.mapping->pads.get());
+  uint16_t* orderedPads(de.orderedPads[0].data());
 
   // add the given pad
-  Mapping::MpPad& pad(pads[iPad]);
-  if (de.nOrderedPads[0] < de.orderedPads[0].size()) {
-    de.orderedPads[0][de.nOrderedPads[0]] = iPad;
-  } else {
-    de.orderedPads[0].push_back(iPad);
-  }
-  cluster.lastPad = de.nOrderedPads[0];
-  ++de.nOrderedPads[0];
-  if (pad.area[0][0] < cluster.area[0][0])
-    cluster.area[0][0] = pad.area[0][0];
-  if (pad.area[0][1] > cluster.area[0][1])
-    cluster.area[0][1] = pad.area[0][1];
-  if (pad.area[1][0] < cluster.area[1][0])
-    cluster.area[1][0] = pad.area[1][0];
-  if (pad.area[1][1] > cluster.area[1][1])
-    cluster.area[1][1] = pad.area[1][1];
-
-  pad.useMe = false;
-
-  // loop over its neighbours
-  for (int iNeighbour = 0; iNeighbour < pad.nNeighbours; ++iNeighbour) {
-
-    if (pads[pad.neighbours[iNeighbour]].useMe) {
-
-      // add the pad to the precluster
-      addPad(de, pad.neighbours[iNeighbour], cluster);
+  pads[iPad].useMe = false;
+  orderedPads[de.nOrderedPads[0]++] = iPad;
+
+  // visit the pads of the precluster as long as new ones are added
+  for (int iOrderPad = cluster.firstPad; iOrderPad < de.nOrderedPads[0]; ++iOrderPad) {
+
+    Mapping::MpPad& pad(pads[orderedPads[iOrderPad]]);
+
+    if (pad.area[0][0] < cluster.area[0][0])
+      cluster.area[0][0] = pad.area[0][0];
+    if (pad.area[0][1] > cluster.area[0][1])
+      cluster.area[0][1] = pad.area[0][1];
+    if (pad.area[1][0] < cluster.area[1][0])
+      cluster.area[1][0] = pad.area[1][0];
+    if (pad.area[1][1] > cluster.area[1][1])
+      cluster.area[1][1] = pad.area[1][1];
+
+    // loop over its neighbours
+    for (int iNeighbour = 0; iNeighbour < pad.nNeighbours; ++iNeighbour) {
+
+      uint16_t iNeighbourPad = pad.neighbours[iNeighbour];
+
+      if (pads[iNeighbourPad].useMe) {
+
+        // add the pad to the precluster
+        pads[iNeighbourPad].useMe = false;
+        orderedPads[de.nOrderedPads[0]++] = iNeighbourPad;
+      }
     }
   }
+
+  cluster.lastPad = de.nOrderedPads[0] - 1;
 }
 
 //_________________________________________________________________________________________________
-int PreClusterFinder::mergePreClusters()
+int PreClusterFinder::mergePreClusters(int iDE)
 {
-  /// merge overlapping preclusters on every DE
-  /// return the total number of preclusters after merging
+  /// merge overlapping preclusters of the DE "iDE"
+  /// return the number of preclusters after merging
 
   PreCluster* cluster(nullptr);
   int nPreClusters(0);
 
-  // loop over DEs
-  for (int iDE = 0; iDE < SNDEs; ++iDE) {
-
-    DetectionElement& de(mDEs[iDE]);
-
-    // loop over preclusters of one plane
-    for (int iCluster = 0; iCluster < mNPreClusters[iDE][0]; ++iCluster) {
+  DetectionElement& de(mDEs[iDE]);
 
-      if (!mPreClusters[iDE][0][iCluster]->useMe) {
-        continue;
-      }
+  // loop over preclusters of one plane
+  for (int iCluster = 0; iCluster < mNPreClusters[iDE][0]; ++iCluster) {
 
-      cluster = mPreClusters[iDE][0][iCluster].get();
-      cluster->useMe = false;
+    if (!mPreClusters[iDE][0][iCluster].useMe) {
+      continue;
+    }
 
-      // look for overlapping preclusters in the other plane
-      PreCluster* mergedCluster(nullptr);
-      mergePreClusters(*cluster, mPreClusters[iDE], mNPreClusters[iDE], de, 1, mergedCluster);
+    cluster = &mPreClusters[iDE][0][iCluster];
+    cluster->useMe = false;
 
-      // add the current one
-      if (!mergedCluster) {
-        mergedCluster = usePreClusters(cluster, de);
-      } else {
-        mergePreClusters(*mergedCluster, *cluster, de);
-      }
+    // look for overlapping preclusters in the other plane
+    PreCluster* mergedCluster(nullptr);
+    mergePreClusters(*cluster, mPreClusters[iDE], mNPreClusters[iDE], de, 1, mergedCluster);
 
-      ++nPreClusters;
+    // add the current one
+    if (!mergedCluster) {
+      mergedCluster = usePreClusters(cluster, de);
+    } else {
+      mergePreClusters(*mergedCluster, *cluster, de);
     }
 
-    // loop over preclusters of the other plane
-    for (int iCluster = 0; iCluster < mNPreClusters[iDE][1]; ++iCluster) {
-
-      if (!mPreClusters[iDE][1][iCluster]->useMe) {
-        continue;
-      }
+    ++nPreClusters;
+  }
 
-      // all remaining preclusters have to be stored
-      usePreClusters(mPreClusters[iDE][1][iCluster].get(), de);
+  // loop over preclusters of the other plane
+  for (int iCluster = 0; iCluster < mNPreClusters[iDE][1]; ++iCluster) {
 
-      ++nPreClusters;
+    if (!mPreClusters[iDE][1][iCluster].useMe) {
+      continue;
     }
+
+    // all remaining preclusters have to be stored
+    usePreClusters(&mPreClusters[iDE][1][iCluster], de);
+
+    ++nPreClusters;
   }
 
   return nPreClusters;
 }
 
 //_________________________________________________________________________________________________
-void PreClusterFinder::mergePreClusters(PreCluster& cluster, std::vector<std::unique_ptr<PreCluster>> preClusters[2],
+void PreClusterFinder::mergePreClusters(PreCluster& cluster, std::vector<PreCluster> preClusters[2],
                                         int nPreClusters[2], DetectionElement& de, int iPlane,
                                         PreCluster*& mergedCluster)
 {
@@ -297,11 +434,11 @@ void PreClusterFinder::mergePreClusters(PreCluster& cluster, std::vector<std::un
   // loop over preclusters in the given plane
   for (int iCluster = 0; iCluster < nPreClusters[iPlane]; ++iCluster) {
 
-    if (!preClusters[iPlane][iCluster]->useMe) {
+    if (!preClusters[iPlane][iCluster].useMe) {
       continue;
     }
 
-    cluster2 = preClusters[iPlane][iCluster].get();
+    cluster2 = &preClusters[iPlane][iCluster];
     if (Mapping::areOverlapping(cluster.area, cluster2->area, overlapPrecision) &&
         areOverlapping(cluster, *cluster2, de, overlapPrecision)) {
 
@@ -373,15 +510,76 @@ bool PreClusterFinder::areOverlapping(PreCluster& cluster1, PreCluster& cluster2
   /// check if the two preclusters overlap
   /// precision in cm: positive = increase pad size / negative = decrease pad size
 
-  // loop over all pads of the precluster1
-  for (int iOrderPad1 = cluster1.firstPad; iOrderPad1 <= cluster1.lastPad; ++iOrderPad1) {
+  Mapping::MpPad* pads(de.mapping->pads.get());
+
+  // only the pads located in the area of the other precluster can overlap with it
+  auto selectPads = [&](PreCluster& cluster, PreCluster& otherCluster, std::vector<uint16_t>& selectedPads) {
+    selectedPads.clear();
+    for (int iOrderPad = cluster.firstPad; iOrderPad <= cluster.lastPad; ++iOrderPad) {
+      uint16_t iPad = de.orderedPads[0][iOrderPad];
+      if (Mapping::areOverlapping(pads[iPad].area, otherCluster.area, precision)) {
+        selectedPads.push_back(iPad);
+      }
+    }
+    return !selectedPads.empty();
+  };
+  if (!selectPads(cluster1, cluster2, de.overlapPads[0]) || !selectPads(cluster2, cluster1, de.overlapPads[1])) {
+    return false;
+  }
+
+  // common range in x of the two preclusters (excluding the precision margin)
+  float xMin = std::max(cluster1.area[0][0], cluster2.area[0][0]);
+  float xMax = std::min(cluster1.area[0][1], cluster2.area[0][1]);
 
-    // loop over all pads of the precluster2
-    for (int iOrderPad2 = cluster2.firstPad; iOrderPad2 <= cluster2.lastPad; ++iOrderPad2) {
+  // test all pairs of selected pads if there are only a few of them
+  if (de.overlapPads[0].size() * de.overlapPads[1].size() <= static_cast<size_t>(SMaxPadPairsToTest) || xMax <= xMin) {
+    for (auto iPad1 : de.overlapPads[0]) {
+      for (auto iPad2 : de.overlapPads[1]) {
+        if (Mapping::areOverlapping(pads[iPad1].area, pads[iPad2].area, precision)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
 
-      if (Mapping::areOverlapping(de.mapping->pads[de.orderedPads[0][iOrderPad1]].area,
-                                  de.mapping->pads[de.orderedPads[0][iOrderPad2]].area, precision)) {
-        return true;
+  // otherwise distribute the selected pads of precluster2 in bins along x
+  // and test each pad of precluster1 only against the pads in the bins it covers
+  int nBins = std::min(SMaxOverlapBins, static_cast<int>(de.overlapPads[1].size()));
+  float binsPerCm = nBins / (xMax - xMin);
+  float margin = std::abs(precision);
+  auto getBin = [&](float x) { return std::min(nBins - 1, std::max(0, static_cast<int>((x - xMin) * binsPerCm))); };
+
+  de.overlapBinFirstPad.assign(nBins + 1, 0);
+  for (auto iPad2 : de.overlapPads[1]) {
+    for (int iBin = getBin(pads[iPad2].area[0][0] - margin), iLastBin = getBin(pads[iPad2].area[0][1] + margin);
+         iBin <= iLastBin; ++iBin) {
+      ++de.overlapBinFirstPad[iBin + 1];
+    }
+  }
+  for (int iBin = 0; iBin < nBins; ++iBin) {
+    de.overlapBinFirstPad[iBin + 1] += de.overlapBinFirstPad[iBin];
+  }
+  de.overlapBinPads.resize(de.overlapBinFirstPad[nBins]);
+  for (auto iPad2 : de.overlapPads[1]) {
+    for (int iBin = getBin(pads[iPad2].area[0][0] - margin), iLastBin = getBin(pads[iPad2].area[0][1] + margin);
+         iBin <= iLastBin; ++iBin) {
+      de.overlapBinPads[de.overlapBinFirstPad[iBin]++] = iPad2;
+    }
+  }
+  // the first pad index of each bin has been moved to the next bin while filling: shift them back
+  for (int iBin = nBins; iBin > 0; --iBin) {
+    de.overlapBinFirstPad[iBin] = de.overlapBinFirstPad[iBin - 1];
+  }
+  de.overlapBinFirstPad[0] = 0;
+
+  for (auto iPad1 : de.overlapPads[0]) {
+    for (int iBin = getBin(pads[iPad1].area[0][0] - margin), iLastBin = getBin(pads[iPad1].area[0][1] + margin);
+         iBin <= iLastBin; ++iBin) {
+      for (int i = de.overlapBinFirstPad[iBin]; i < de.overlapBinFirstPad[iBin + 1]; ++i) {
+        if (Mapping::areOverlapping(pads[iPad1].area, pads[de.overlapBinPads[i]].area, precision)) {
+          return true;
+        }
       }
     }
   }
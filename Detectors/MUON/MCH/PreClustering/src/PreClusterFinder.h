@@ -15,8 +15,14 @@
 #ifndef ALICEO2_MCH_PRECLUSTERFINDER_H_
 #define ALICEO2_MCH_PRECLUSTERFINDER_H_
 
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -40,7 +46,7 @@ class PreClusterFinder
   };
 
   PreClusterFinder() = default;
-  ~PreClusterFinder() = default;
+  ~PreClusterFinder();
 
   PreClusterFinder(const PreClusterFinder&) = delete;
   PreClusterFinder& operator=(const PreClusterFinder&) = delete;
@@ -51,12 +57,19 @@ class PreClusterFinder
   void deinit();
   void reset();
 
+  void setNThreads(int nThreads);
+  /// return the number of threads used to process the DEs
+  int getNThreads() const { return mWorkers.size() + 1; }
+  void processDEs(const std::function<void(int)>& task);
+
   void loadDigits(const DigitStruct* digits, uint32_t nDigits);
 
   int run();
 
   int getNDEWithPreClusters(int& nUsedDigits);
   bool hasPreClusters(int iDE);
+  int getNMergedPreClusters(int iDE);
+  int getNUsedDigits(int iDE);
   int getNPreClusters(int iDE, int iPlane);
   const PreCluster* getPreCluster(int iDE, int iPlane, int iCluster);
   const DigitStruct* getDigit(int iDE, uint16_t iOrderedPad);
@@ -73,6 +86,9 @@ class PreClusterFinder
     std::vector<uint16_t> firedPads[2];     // indices of fired pads on each plane
     uint16_t nOrderedPads[2];               // current number of fired pads in the following arrays
     std::vector<uint16_t> orderedPads[2];   // indices of fired pads ordered after preclustering and merging
+    std::vector<uint16_t> overlapPads[2];   // pads of each precluster located in the area of the other one
+    std::vector<int> overlapBinFirstPad;    // index of the first pad of each bin in overlapBinPads
+    std::vector<uint16_t> overlapBinPads;   // pads of the second precluster sorted per bin along x
   };
 
   /// Return detection element ID part of the unique ID
@@ -81,11 +97,13 @@ class PreClusterFinder
   /// Return the cathode part of the unique ID
   int cathode(uint32_t uid) { return (uid & 0x40000000) >> 30; }
 
-  void preClusterizeRecursive();
-  void addPad(DetectionElement& de, uint16_t iPad, PreCluster& cluster);
+  void reset(int iDE);
+
+  void preClusterize(int iDE);
+  void addPads(DetectionElement& de, uint16_t iPad, PreCluster& cluster);
 
-  int mergePreClusters();
-  void mergePreClusters(PreCluster& cluster, std::vector<std::unique_ptr<PreCluster>> preClusters[2],
+  int mergePreClusters(int iDE);
+  void mergePreClusters(PreCluster& cluster, std::vector<PreCluster> preClusters[2],
                         int nPreClusters[2], DetectionElement& de, int iPlane, PreCluster*& mergedCluster);
   PreCluster* usePreClusters(PreCluster* cluster, DetectionElement& de);
   void mergePreClusters(PreCluster& cluster1, PreCluster& cluster2, DetectionElement& de);
@@ -94,13 +112,31 @@ class PreClusterFinder
 
   void readMapping(const char* fileName);
 
-  static constexpr int SNDEs = 156; ///< number of DEs
+  void runTask(const std::function<void(int)>& task);
+  void workerLoop();
+  void stopWorkers();
+
+  static constexpr int SNDEs = 156;             ///< number of DEs
+  static constexpr int SMaxPadPairsToTest = 32; ///< max number of pad pairs tested without binning
+  static constexpr int SMaxOverlapBins = 64;    ///< max number of bins used to test the overlap
 
   DetectionElement mDEs[SNDEs]{};            ///< internal mapping
   std::unordered_map<int, int> mDEIndices{}; ///< maps DE indices from DE IDs
 
   int mNPreClusters[SNDEs][2]{}; ///< number of preclusters in each cathods of each DE
-  std::vector<std::unique_ptr<PreCluster>> mPreClusters[SNDEs][2]{}; ///< preclusters in each cathods of each DE
+  std::vector<PreCluster> mPreClusters[SNDEs][2]{}; ///< pool of preclusters in each cathods of each DE
+  int mNMergedPreClusters[SNDEs]{}; ///< number of preclusters to be stored in each DE after merging
+
+  std::vector<std::thread> mWorkers{};                 ///< threads helping the caller to process the DEs
+  std::mutex mTaskMutex{};                             ///< protect the task information shared with the workers
+  std::condition_variable mTaskReady{};                ///< signal a new task (or the end) to the workers
+  std::condition_variable mTaskDone{};                 ///< signal the end of the task to the caller
+  const std::function<void(int)>* mTask = nullptr;     ///< task currently executed on every DE
+  uint64_t mTaskId = 0;                                ///< identifier of the current task
+  int mNBusyWorkers = 0;                               ///< number of workers still executing the current task
+  bool mStopWorkers = false;                           ///< tell the workers to exit
+  std::atomic<int> mNextDE{0};                         ///< index of the next DE to be processed
+  std::exception_ptr mTaskException = nullptr;         ///< first exception thrown while executing the task
 };
 
 //_________________________________________________________________________________________________
@@ -132,6 +168,22 @@ inline bool PreClusterFinder::hasPreClusters(int iDE)
   return (mDEs[iDE].nOrderedPads[1] > 0);
 }
 
+//_________________________________________________________________________________________________
+inline int PreClusterFinder::getNMergedPreClusters(int iDE)
+{
+  /// return the number of preclusters to be stored in DE "iDE"
+  assert(iDE >= 0 && iDE < SNDEs);
+  return mNMergedPreClusters[iDE];
+}
+
+//_________________________________________________________________________________________________
+inline int PreClusterFinder::getNUsedDigits(int iDE)
+{
+  /// return the number of digits associated to the preclusters to be stored in DE "iDE"
+  assert(iDE >= 0 && iDE < SNDEs);
+  return mDEs[iDE].nOrderedPads[1];
+}
+
 //_________________________________________________________________________________________________
 inline int PreClusterFinder::getNPreClusters(int iDE, int iPlane)
 {
@@ -146,7 +198,7 @@ inline const PreClusterFinder::PreCluster* PreClusterFinder::getPreCluster(int i
   /// return the preclusters "iCluster" in plane "iPlane" of DE "iDE"
   assert(iDE >= 0 && iDE < SNDEs && iPlane >= 0 && iPlane < 2 && iCluster >= 0 &&
          iCluster < mNPreClusters[iDE][iPlane]);
-  return mPreClusters[iDE][iPlane][iCluster].get();
+  return &mPreClusters[iDE][iPlane][iCluster];
 }
 
 //_________________________________________________________________________________________________
@@ -55,6 +55,11 @@ void PreClusterFinderDevice::InitTask()
     ChangeState(ERROR_FOUND);
     return;
   }
+
+  // Process the DEs in parallel if requested
+  auto nThreads = fConfig->GetValue<int>("nthreads");
+  mPreClusterFinder.setNThreads(nThreads);
+  LOG(INFO) << "Preclusterizing with " << mPreClusterFinder.getNThreads() << " thread(s)";
 }
 
 //_________________________________________________________________________________________________
@@ -62,6 +67,13 @@ void PreClusterFinderDevice::ResetTask()
 {
   /// Clear the preclusterizer
 
+  if (mNEvents > 0) {
+    LOG(INFO) << "Preclusterized " << mNEvents << " events in: " << mPreClusteringTime << " ms ("
+              << mPreClusteringTime / mNEvents << " ms/event)";
+  }
+  mNEvents = 0;
+  mPreClusteringTime = 0.;
+
   auto tStart = std::chrono::high_resolution_clock::now();
 
   mPreClusterFinder.deinit();
@@ -116,7 +128,11 @@ bool PreClusterFinderDevice::processData(FairMQMessagePtr& msg, int /*index*/)
   if (validBlockFound) {
 
     // preclusterize
+    auto tStart = std::chrono::high_resolution_clock::now();
     int nPreClusters = mPreClusterFinder.run();
+    auto tEnd = std::chrono::high_resolution_clock::now();
+    mPreClusteringTime += std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+    ++mNEvents;
 
     if (nPreClusters > 0) {
 
@@ -168,68 +184,87 @@ void PreClusterFinderDevice::fillBlockData(AliHLTComponentBlockData& blockData)
 //_________________________________________________________________________________________________
 void PreClusterFinderDevice::storePreClusters(uint8_t* buffer, uint32_t size)
 {
-  /// store the preclusters in the given buffer
+  /// store the preclusters in the given buffer, the data block of each DE being filled in parallel
 
-  const PreClusterFinder::PreCluster* cluster(nullptr);
-  const DigitStruct* digit(nullptr);
+  // compute the position of the data block of each DE in the buffer
   uint32_t totalBytesUsed(0);
-
-  // loop over DEs
   for (int iDE = 0, nDEs = mPreClusterFinder.getNDEs(); iDE < nDEs; ++iDE) {
-
-    if (!mPreClusterFinder.hasPreClusters(iDE)) {
-      continue;
+    mBlockOffsets[iDE] = totalBytesUsed;
+    if (mPreClusterFinder.hasPreClusters(iDE)) {
+      totalBytesUsed += sizeof(AliHLTComponentBlockData) +
+                        PreClusterBlock::sizeOfPreClusterBlocks(1, mPreClusterFinder.getNMergedPreClusters(iDE),
+                                                                mPreClusterFinder.getNUsedDigits(iDE));
     }
+  }
+  mBlockOffsets[mPreClusterFinder.getNDEs()] = totalBytesUsed;
 
-    // create the preclusters data block for this DE
-    AliHLTComponentBlockData* blockData(nullptr);
-    if (size - totalBytesUsed >= sizeof(AliHLTComponentBlockData)) {
-      blockData = reinterpret_cast<AliHLTComponentBlockData*>(buffer + totalBytesUsed);
-      fillBlockData(*blockData);
-      totalBytesUsed += sizeof(AliHLTComponentBlockData);
-    } else {
-      LOG(ERROR) << "The buffer is too small to store the data block.";
-      throw overflow_error("The buffer is too small to store the data block.");
-    }
+  if (totalBytesUsed > size) {
+    LOG(ERROR) << "The buffer is too small to store the data blocks.";
+    throw overflow_error("The buffer is too small to store the data blocks.");
+  }
 
-    if (mPreClusterBlock.reset(buffer + totalBytesUsed, size - totalBytesUsed, true) < 0) {
-      throw runtime_error("Cannot reset the cluster block.");
+  mPreClusterFinder.processDEs([this, buffer](int iDE) {
+    if (mPreClusterFinder.hasPreClusters(iDE)) {
+      storePreClusters(iDE, buffer + mBlockOffsets[iDE], mBlockOffsets[iDE + 1] - mBlockOffsets[iDE]);
     }
+  });
+}
+
+//_________________________________________________________________________________________________
+void PreClusterFinderDevice::storePreClusters(int iDE, uint8_t* buffer, uint32_t size)
+{
+  /// store the preclusters of the DE "iDE" in the given buffer
 
-    // loop over planes
-    for (int iPlane = 0; iPlane < 2; ++iPlane) {
+  const PreClusterFinder::PreCluster* cluster(nullptr);
+  const DigitStruct* digit(nullptr);
+  PreClusterBlock& preClusterBlock(mPreClusterBlocks[iDE]);
 
-      // loop over preclusters
-      for (int iCluster = 0, nClusters = mPreClusterFinder.getNPreClusters(iDE, iPlane); iCluster < nClusters;
-           ++iCluster) {
+  // create the preclusters data block for this DE
+  AliHLTComponentBlockData* blockData(nullptr);
+  if (size >= sizeof(AliHLTComponentBlockData)) {
+    blockData = reinterpret_cast<AliHLTComponentBlockData*>(buffer);
+    fillBlockData(*blockData);
+  } else {
+    LOG(ERROR) << "The buffer is too small to store the data block.";
+    throw overflow_error("The buffer is too small to store the data block.");
+  }
 
-        cluster = mPreClusterFinder.getPreCluster(iDE, iPlane, iCluster);
-        if (!cluster->storeMe) {
-          continue;
-        }
+  if (preClusterBlock.reset(buffer + sizeof(AliHLTComponentBlockData), size - sizeof(AliHLTComponentBlockData), true) <
+      0) {
+    throw runtime_error("Cannot reset the cluster block.");
+  }
 
-        // add the precluster with its first digit
-        digit = mPreClusterFinder.getDigit(iDE, cluster->firstPad);
-        if (mPreClusterBlock.startPreCluster(*digit) < 0) {
-          throw runtime_error("Cannot store a new precluster.");
-        }
+  // loop over planes
+  for (int iPlane = 0; iPlane < 2; ++iPlane) {
 
-        // loop over other pads and add corresponding digits
-        for (uint16_t iOrderedPad = cluster->firstPad + 1; iOrderedPad <= cluster->lastPad; ++iOrderedPad) {
-          digit = mPreClusterFinder.getDigit(iDE, iOrderedPad);
-          if (mPreClusterBlock.addDigit(*digit) < 0) {
-            throw runtime_error("Cannot store a new digit.");
-          }
+    // loop over preclusters
+    for (int iCluster = 0, nClusters = mPreClusterFinder.getNPreClusters(iDE, iPlane); iCluster < nClusters;
+         ++iCluster) {
+
+      cluster = mPreClusterFinder.getPreCluster(iDE, iPlane, iCluster);
+      if (!cluster->storeMe) {
+        continue;
+      }
+
+      // add the precluster with its first digit
+      digit = mPreClusterFinder.getDigit(iDE, cluster->firstPad);
+      if (preClusterBlock.startPreCluster(*digit) < 0) {
+        throw runtime_error("Cannot store a new precluster.");
+      }
+
+      // loop over other pads and add corresponding digits
+      for (uint16_t iOrderedPad = cluster->firstPad + 1; iOrderedPad <= cluster->lastPad; ++iOrderedPad) {
+        digit = mPreClusterFinder.getDigit(iDE, iOrderedPad);
+        if (preClusterBlock.addDigit(*digit) < 0) {
+          throw runtime_error("Cannot store a new digit.");
         }
       }
     }
-
-    // complete the data block information
-    uint32_t bytesUsed(mPreClusterBlock.getCurrentSize());
-    blockData->fSize = bytesUsed;
-    blockData->fSpecification = mPreClusterFinder.getDEId(iDE);
-    totalBytesUsed += bytesUsed;
   }
+
+  // complete the data block information
+  blockData->fSize = preClusterBlock.getCurrentSize();
+  blockData->fSpecification = mPreClusterFinder.getDEId(iDE);
 }
 
 } // namespace mch
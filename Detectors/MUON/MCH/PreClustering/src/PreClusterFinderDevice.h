@@ -49,12 +49,17 @@ class PreClusterFinderDevice : public FairMQDevice
 
   void fillBlockData(AliHLTComponentBlockData& blockData);
   void storePreClusters(uint8_t* buffer, uint32_t size);
+  void storePreClusters(int iDE, uint8_t* buffer, uint32_t size);
 
   o2::alice_hlt::MessageFormat mFormatHandler{}; /// HLT format handler
 
   PreClusterFinder mPreClusterFinder{}; /// preclusterizer
 
-  PreClusterBlock mPreClusterBlock{}; ///< to fill preclusters data blocks
+  PreClusterBlock mPreClusterBlocks[PreClusterFinder::getNDEs()]{}; ///< to fill preclusters data block of each DE
+  uint32_t mBlockOffsets[PreClusterFinder::getNDEs() + 1]{};         ///< position of the data block of each DE
+
+  int mNEvents = 0;               ///< number of processed events
+  double mPreClusteringTime = 0.; ///< time spent preclusterizing in ms
 };
 
 } // namespace mch
@@ -24,9 +24,16 @@ namespace mid
 
 //______________________________________________________________________________
 Clusterizer::Clusterizer()
-  : mMapping(), mMpDEs(), mNPreClusters(), mPreClusters(), mActiveDEs(), mClusters(), mNClusters(0)
+  : mMapping(), mMpDEs(), mNPreClusters(), mPreClusters(), mActiveDEs(), mNeighbours(), mClusters(), mNClusters(0)
 {
   /// Default constructor
+  for (int deId = 0; deId < Constants::sNDetectionElements; ++deId) {
+    mMpDEs[deId].deId = deId;
+    mMpDEs[deId].firedColumns = 0;
+    for (auto& column : mMpDEs[deId].columns) {
+      column.patterns.fill(0);
+    }
+  }
 }
 
 //______________________________________________________________________________
@@ -42,9 +49,7 @@ bool Clusterizer::process(const std::vector<ColumnData>& stripPatterns)
   // Load the stripPatterns to get the fired strips
   if (loadPatterns(stripPatterns)) {
     // Loop only on fired detection elements
-    for (auto& pair : mActiveDEs) {
-      // loop on active DEs
-      int deIndex = pair.first;
+    for (auto deIndex : mActiveDEs) {
 
       // reset number of preclusters
       mNPreClusters.fill(0);
@@ -67,10 +72,11 @@ bool Clusterizer::init()
   /// Initializes the class
 
   // prepare storage of clusters and PreClusters
-  for (int iPlane = 0; iPlane < 2; ++iPlane) {
-    mPreClusters[iPlane].reserve(100);
-    mClusters.reserve(100);
+  for (auto& preClusters : mPreClusters) {
+    preClusters.reserve(16);
   }
+  mClusters.reserve(100);
+  mActiveDEs.reserve(Constants::sNDetectionElements);
 
   return true;
 }
@@ -81,23 +87,18 @@ bool Clusterizer::loadPatterns(const std::vector<ColumnData>& stripPatterns)
   /// Fills the mpDE structure with fired pads
 
   // Loop on stripPatterns
-  for (auto col : stripPatterns) {
+  for (const auto& col : stripPatterns) {
     int deIndex = col.deId;
-    assert(deIndex < 72);
+    assert(deIndex < Constants::sNDetectionElements);
 
-    auto search = mMpDEs.find(deIndex);
-    PatternStruct* de = nullptr;
-    if (search == mMpDEs.end()) {
-      de = &mMpDEs[deIndex];
-      de->deId = col.deId;
-    } else {
-      de = &(search->second);
-    }
+    PatternStruct& de = mMpDEs[deIndex];
 
-    mActiveDEs[deIndex] = 1;
+    if (de.firedColumns == 0) {
+      mActiveDEs.push_back(deIndex);
+    }
 
-    de->firedColumns |= (1 << col.columnId);
-    de->columns[col.columnId] = col.patterns;
+    de.firedColumns |= (1 << col.columnId);
+    de.columns[col.columnId] = col.patterns;
   }
 
   return (stripPatterns.size() > 0);
@@ -115,45 +116,59 @@ Clusterizer::PreCluster* Clusterizer::nextPreCluster(int icolumn)
   return pc;
 }
 
+//______________________________________________________________________________
+double Clusterizer::addStrips(double limit, int firstStrip, int lastStrip, int cathode, int icolumn, int deId)
+{
+  /// Extends the limit of a pre-cluster with the strips in [firstStrip, lastStrip]
+  for (int istrip = firstStrip; istrip <= lastStrip; ++istrip) {
+    limit += mMapping.getStripSize(istrip, cathode, icolumn, deId);
+  }
+  return limit;
+}
+
 //______________________________________________________________________________
 void Clusterizer::preClusterizeNBP(PatternStruct& de)
 {
   /// PreClusterizes non-bending plane
+  /// The runs of consecutive fired strips are directly extracted from the pattern:
+  /// the first fired strip is given by the number of trailing zeros
+  /// and the run length by the number of trailing ones from there.
+  /// A run reaching the last strip of a column continues on the first strip of the next one.
   PreCluster* pc = nullptr;
   double limit = 0;
   for (int icolumn = 0; icolumn < 7; ++icolumn) {
-    if (de.columns[icolumn].getNonBendPattern() == 0) {
+    int nStripsNBP = mMapping.getNStripsNBP(icolumn, de.deId);
+    unsigned int pattern = de.columns[icolumn].getNonBendPattern() & ((1u << nStripsNBP) - 1);
+    if (pattern == 0) {
+      pc = nullptr;
       continue;
     }
-    int nStripsNBP = mMapping.getNStripsNBP(icolumn, de.deId);
-    for (int istrip = 0; istrip < nStripsNBP; ++istrip) {
-      if (de.columns[icolumn].isNBPStripFired(istrip)) {
-        if (pc) {
-          if (istrip == 0) {
-            // We're changing column
-            // In principle we could simply add the pitch, but for the cut RPCs
-            // the y dimension changes as well in column 0
-            pc->area[icolumn] = mMapping.stripByLocation(istrip, 1, 0, icolumn, de.deId);
-            limit = pc->area[icolumn].getXmax();
-          } else {
-            limit += mMapping.getStripSize(istrip, 1, icolumn, de.deId);
-          }
-        } else {
-          pc = nextPreCluster(7);
-          pc->paired = 0;
-          pc->firstColumn = icolumn;
-          pc->area[icolumn] = mMapping.stripByLocation(istrip, 1, 0, icolumn, de.deId);
-          limit = pc->area[icolumn].getXmax();
-          LOG(DEBUG) << "New precluster NBP: DE  " << de.deId;
-        }
-        pc->lastColumn = icolumn;
-        pc->area[icolumn].setXmax(limit);
-        LOG(DEBUG) << "  adding col " << icolumn << "  strip " << istrip << "  (" << pc->area[icolumn].getXmin() << ", "
-                   << pc->area[icolumn].getXmax() << ") (" << pc->area[icolumn].getYmin() << ", "
-                   << pc->area[icolumn].getYmax();
+    int lastStrip = -1;
+    while (pattern != 0) {
+      int firstStrip = __builtin_ctz(pattern);
+      lastStrip = firstStrip + __builtin_ctz(~(pattern >> firstStrip)) - 1;
+      if (pc && firstStrip == 0) {
+        // We're changing column
+        // In principle we could simply add the pitch, but for the cut RPCs
+        // the y dimension changes as well in column 0
+        pc->area[icolumn] = mMapping.stripByLocation(0, 1, 0, icolumn, de.deId);
       } else {
-        pc = nullptr;
+        pc = nextPreCluster(7);
+        pc->paired = 0;
+        pc->firstColumn = icolumn;
+        pc->area[icolumn] = mMapping.stripByLocation(firstStrip, 1, 0, icolumn, de.deId);
+        LOG(DEBUG) << "New precluster NBP: DE  " << de.deId;
       }
+      limit = addStrips(pc->area[icolumn].getXmax(), firstStrip + 1, lastStrip, 1, icolumn, de.deId);
+      pc->lastColumn = icolumn;
+      pc->area[icolumn].setXmax(limit);
+      LOG(DEBUG) << "  adding col " << icolumn << "  strips " << firstStrip << "-" << lastStrip << "  ("
+                 << pc->area[icolumn].getXmin() << ", " << pc->area[icolumn].getXmax() << ") ("
+                 << pc->area[icolumn].getYmin() << ", " << pc->area[icolumn].getYmax();
+      pattern &= ~((2u << lastStrip) - (1u << firstStrip));
+    }
+    if (lastStrip != nStripsNBP - 1) {
+      pc = nullptr;
     }
     de.columns[icolumn].setNonBendPattern(0); // Reset pattern
   }
@@ -163,38 +178,46 @@ void Clusterizer::preClusterizeNBP(PatternStruct& de)
 void Clusterizer::preClusterizeBP(PatternStruct& de)
 {
   /// PreClusterizes bending plane
+  /// The runs of fired strips are extracted from the patterns as in the non-bending plane.
+  /// A run reaching the last strip of a board continues on the first strip of the board above.
   PreCluster* pc = nullptr;
-  double limit = 0;
   for (int icolumn = mMapping.getFirstColumn(de.deId); icolumn < 7; ++icolumn) {
     if ((de.firedColumns & (1 << icolumn)) == 0) {
       continue;
     }
+    pc = nullptr;
     int firstLine = mMapping.getFirstBoardBP(icolumn, de.deId);
     int lastLine = mMapping.getLastBoardBP(icolumn, de.deId);
     for (int iline = firstLine; iline <= lastLine; ++iline) {
-      if (de.columns[icolumn].getBendPattern(iline) == 0) {
+      unsigned int pattern = de.columns[icolumn].getBendPattern(iline);
+      if (pattern == 0) {
+        pc = nullptr;
         continue;
       }
-      for (int istrip = 0; istrip < 16; ++istrip) {
-        if (de.columns[icolumn].isBPStripFired(istrip, iline)) {
-          if (pc) {
-            limit += mMapping.getStripSize(istrip, 0, icolumn, de.deId);
-          } else {
-            pc = nextPreCluster(icolumn);
-            pc->paired = 0;
-            pc->firstColumn = icolumn;
-            pc->lastColumn = icolumn;
-            pc->area[icolumn] = mMapping.stripByLocation(istrip, 0, iline, icolumn, de.deId);
-            limit = pc->area[icolumn].getYmax();
-            LOG(DEBUG) << "New precluster BP: DE  " << de.deId << "  icolumn " << icolumn;
-          }
-          pc->area[icolumn].setYmax(limit);
-          LOG(DEBUG) << "  adding line " << iline << "  strip " << istrip << "  (" << pc->area[icolumn].getXmin()
-                     << ", " << pc->area[icolumn].getXmax() << ") (" << pc->area[icolumn].getYmin() << ", "
-                     << pc->area[icolumn].getYmax() << ")";
+      int lastStrip = -1;
+      while (pattern != 0) {
+        int firstStrip = __builtin_ctz(pattern);
+        lastStrip = firstStrip + __builtin_ctz(~(pattern >> firstStrip)) - 1;
+        double limit = 0;
+        if (pc && firstStrip == 0) {
+          limit = addStrips(pc->area[icolumn].getYmax(), firstStrip, lastStrip, 0, icolumn, de.deId);
         } else {
-          pc = nullptr;
+          pc = nextPreCluster(icolumn);
+          pc->paired = 0;
+          pc->firstColumn = icolumn;
+          pc->lastColumn = icolumn;
+          pc->area[icolumn] = mMapping.stripByLocation(firstStrip, 0, iline, icolumn, de.deId);
+          limit = addStrips(pc->area[icolumn].getYmax(), firstStrip + 1, lastStrip, 0, icolumn, de.deId);
+          LOG(DEBUG) << "New precluster BP: DE  " << de.deId << "  icolumn " << icolumn;
         }
+        pc->area[icolumn].setYmax(limit);
+        LOG(DEBUG) << "  adding line " << iline << "  strips " << firstStrip << "-" << lastStrip << "  ("
+                   << pc->area[icolumn].getXmin() << ", " << pc->area[icolumn].getXmax() << ") ("
+                   << pc->area[icolumn].getYmin() << ", " << pc->area[icolumn].getYmax() << ")";
+        pattern &= ~((2u << lastStrip) - (1u << firstStrip));
+      }
+      if (lastStrip != 15) {
+        pc = nullptr;
       }
       de.columns[icolumn].setBendPattern(0, iline); // Reset pattern
     }                                               // loop on lines
@@ -222,10 +245,10 @@ void Clusterizer::makeClusters(const int& deIndex)
     } else {
       // The NBP pre-cluster spans different columns.
       // The BP contour is therefore a serie of neighbour rectangles
-      std::vector<std::vector<PreCluster*>> pcBneighbours;
       LOG(DEBUG) << "Spanning non-bend: " << icolumn << " -> " << pcNB.lastColumn;
-      buildListOfNeighbours(icolumn, pcNB.lastColumn, pcBneighbours);
-      for (const auto pcBlist : pcBneighbours) {
+      mNeighbours.clear();
+      buildListOfNeighbours(icolumn, pcNB.lastColumn, mNeighbours);
+      for (const auto& pcBlist : mNeighbours) {
         makeCluster(pcBlist, deIndex, &pcNB);
       }
     }
@@ -239,9 +262,9 @@ void Clusterizer::makeClusters(const int& deIndex)
   } // loop over pre-clusters in the NBP
 
   /// Search for monocathodic clusters in the BP
-  std::vector<std::vector<PreCluster*>> pcBneighbours;
-  buildListOfNeighbours(0, 6, pcBneighbours, true);
-  for (const auto pcBlist : pcBneighbours) {
+  mNeighbours.clear();
+  buildListOfNeighbours(0, 6, mNeighbours, true);
+  for (const auto& pcBlist : mNeighbours) {
     makeCluster(pcBlist, deIndex);
   }
 }
@@ -278,7 +301,7 @@ void Clusterizer::makeCluster(PreCluster& clBend, PreCluster& clNonBend, const i
 }
 
 //______________________________________________________________________________
-void Clusterizer::makeCluster(std::vector<PreCluster*> pcBlist, const int& deIndex, PreCluster* clNonBend)
+void Clusterizer::makeCluster(const std::vector<PreCluster*>& pcBlist, const int& deIndex, PreCluster* clNonBend)
 {
   /// Makes the cluster from pre-clusters
   // This is the general case:
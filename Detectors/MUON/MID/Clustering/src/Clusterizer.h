@@ -16,8 +16,9 @@
 #ifndef O2_MID_CLUSTERIZER_H
 #define O2_MID_CLUSTERIZER_H
 
-#include <unordered_map>
+#include <array>
 #include <vector>
+#include "MIDBase/Constants.h"
 #include "MIDBase/Mapping.h"
 #include "DataFormatsMID/Cluster2D.h"
 #include "DataFormatsMID/StripPattern.h"
@@ -67,6 +68,7 @@ class Clusterizer
   void preClusterizeBP(PatternStruct& de);
   void preClusterizeNBP(PatternStruct& de);
   PreCluster* nextPreCluster(int icolumn);
+  double addStrips(double limit, int firstStrip, int lastStrip, int cathode, int icolumn, int deId);
 
   bool buildListOfNeighbours(int icolumn, int lastColumn, std::vector<std::vector<PreCluster*>>& neighbours,
                              bool skipPaired = false, int currentList = 0);
@@ -74,18 +76,19 @@ class Clusterizer
   Cluster2D& nextCluster();
   void makeClusters(const int& deIndex);
   void makeCluster(PreCluster& clBend, PreCluster& clNonBend, const int& deIndex);
-  void makeCluster(std::vector<PreCluster*> pcBlist, const int& deIndex, PreCluster* clNonBend = nullptr);
+  void makeCluster(const std::vector<PreCluster*>& pcBlist, const int& deIndex, PreCluster* clNonBend = nullptr);
 
-  Mapping mMapping;                              ///< Mapping
-  std::unordered_map<int, PatternStruct> mMpDEs; ///< internal mapping
+  Mapping mMapping;                                                 ///< Mapping
+  std::array<PatternStruct, Constants::sNDetectionElements> mMpDEs; ///< internal mapping
 
   std::array<int, 8> mNPreClusters; ///< number of PreClusters in each DE per column (last column is the NBP)
   std::array<std::vector<PreCluster>, 8>
     mPreClusters; ///< list of PreClusters in each DE per column (last column is the NBP)
 
-  std::unordered_map<int, bool> mActiveDEs; ///< List of active detection elements for event
-  std::vector<Cluster2D> mClusters;         ///< list of clusters
-  unsigned long int mNClusters;             ///< Number of clusters
+  std::vector<int> mActiveDEs;                        ///< List of active detection elements for event
+  std::vector<std::vector<PreCluster*>> mNeighbours; ///< lists of neighbour BP pre-clusters
+  std::vector<Cluster2D> mClusters;                  ///< list of clusters
+  unsigned long int mNClusters;                      ///< Number of clusters
 };
 } // namespace mid
 } // namespace o2
@@ -17,13 +17,16 @@
 #include <iostream>
 #include <random>
 #include "MIDBase/Mapping.h"
+#include "MIDBase/HitFinder.h"
 #include "DataFormatsMID/StripPattern.h"
+#include "DataFormatsMID/Track.h"
+#include "MIDTestingSimTools/TrackGenerator.h"
 #include "Clusterizer.h"
 
 o2::mid::ColumnData& getColumn(std::vector<o2::mid::ColumnData>& patterns, uint8_t icolumn, uint8_t deId)
 {
   for (auto& currColumn : patterns) {
-    if (currColumn.columnId == icolumn) {
+    if (currColumn.deId == deId && currColumn.columnId == icolumn) {
       return currColumn;
     }
   }
@@ -102,10 +105,57 @@ std::vector<o2::mid::ColumnData> generateTestData(int deId, int nClusters, int c
   return patterns;
 }
 
+std::vector<o2::mid::ColumnData> generateTrackData(int nTracks, o2::mid::TrackGenerator& trackGen,
+                                                   const o2::mid::HitFinder& hitFinder,
+                                                   const o2::mid::Mapping& midMapping)
+{
+  // The fired strips are the strip crossed by the track and its neighbours in both cathodes.
+  // As in the clustering test, the bending strips not overlapping with the non-bending plane are rejected
+  std::vector<o2::mid::ColumnData> patterns;
+  std::vector<o2::mid::Track> tracks = trackGen.generate(nTracks);
+  for (auto& track : tracks) {
+    for (int ich = 0; ich < 4; ++ich) {
+      std::vector<std::pair<int, Point3D<float>>> pairs = hitFinder.getLocalPositions(track, ich);
+      for (auto& pair : pairs) {
+        int deId = pair.first;
+        for (int cathode = 1; cathode >= 0; --cathode) {
+          o2::mid::Mapping::MpStripIndex stripIndex =
+            midMapping.stripByPosition(pair.second.x(), pair.second.y(), cathode, deId, false);
+          if (!stripIndex.isValid()) {
+            continue;
+          }
+          std::vector<o2::mid::Mapping::MpStripIndex> neighbours = midMapping.getNeighbours(stripIndex, cathode, deId);
+          neighbours.push_back(stripIndex);
+          for (auto& neigh : neighbours) {
+            if (cathode == 0) {
+              bool hasColumn = false;
+              for (auto& currColumn : patterns) {
+                if (currColumn.deId == deId && currColumn.columnId == neigh.column) {
+                  hasColumn = true;
+                  break;
+                }
+              }
+              if (!hasColumn) {
+                continue;
+              }
+            }
+            o2::mid::ColumnData& column =
+              getColumn(patterns, static_cast<uint8_t>(neigh.column), static_cast<uint8_t>(deId));
+            addStrip(column, cathode, neigh.line, neigh.strip);
+          }
+        }
+      } // loop on fired pos
+    }   // loop on chambers
+  }     // loop on tracks
+  return patterns;
+}
+
 class BenchClustering : public benchmark::Fixture
 {
  public:
-  BenchClustering() : midMapping(), clusterizer() { clusterizer.init(); }
+  BenchClustering() : trackGen(), hitFinder(), midMapping(), clusterizer() { clusterizer.init(); }
+  o2::mid::TrackGenerator trackGen;
+  o2::mid::HitFinder hitFinder;
   o2::mid::Mapping midMapping;
   o2::mid::Clusterizer clusterizer;
 };
@@ -143,6 +193,33 @@ static void CustomArguments(benchmark::internal::Benchmark* bench)
   }
 }
 
+BENCHMARK_DEFINE_F(BenchClustering, clusteringTracks)(benchmark::State& state)
+{
+
+  int nTracksPerEvent = state.range(0);
+  double num{ 0 };
+
+  std::vector<o2::mid::ColumnData> inputData;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    inputData = generateTrackData(nTracksPerEvent, trackGen, hitFinder, midMapping);
+    state.ResumeTiming();
+    clusterizer.process(inputData);
+    ++num;
+  }
+
+  state.counters["num"] = benchmark::Counter(num, benchmark::Counter::kIsRate);
+}
+
+static void TrackArguments(benchmark::internal::Benchmark* bench)
+{
+  for (int itrack = 1; itrack <= 8; ++itrack) {
+    bench->Arg(itrack);
+  }
+}
+
 BENCHMARK_REGISTER_F(BenchClustering, clustering)->Apply(CustomArguments)->Unit(benchmark::kNanosecond);
+BENCHMARK_REGISTER_F(BenchClustering, clusteringTracks)->Apply(TrackArguments)->Unit(benchmark::kNanosecond);
 
 BENCHMARK_MAIN();
@@ -14,6 +14,7 @@
 /// \date   09 May 2017
 #include "Tracker.h"
 
+#include <algorithm>
 #include <cmath>
 #include "FairLogger.h"
 #include "MIDBase/Constants.h"
@@ -42,6 +43,7 @@ bool Tracker::init()
 
   // Prepare storage of tracks
   mTracks.reserve(30);
+  mTrackClusterIds.reserve(30);
 
   return true;
 }
@@ -55,6 +57,7 @@ void Tracker::reset()
   }
 
   mNTracks = 0;
+  mTrackClusterIds.clear();
 }
 
 //______________________________________________________________________________
@@ -95,15 +98,80 @@ bool Tracker::loadClusters(const std::vector<Cluster2D>& clusters)
     cl.position = mTransformer.localToGlobal(deId, currData.xCoor, currData.yCoor);
     cl.sigmaX2 = currData.sigmaX2;
     cl.sigmaY2 = currData.sigmaY2;
+    if (mNClusters[deId] == 1) {
+      mMaxSigmaX2[deId] = cl.sigmaX2;
+      mMinZ[deId] = cl.position.z();
+      mMaxZ[deId] = cl.position.z();
+    } else {
+      mMaxSigmaX2[deId] = std::max(mMaxSigmaX2[deId], cl.sigmaX2);
+      mMinZ[deId] = std::min(mMinZ[deId], cl.position.z());
+      mMaxZ[deId] = std::max(mMaxZ[deId], cl.position.z());
+    }
 
     LOG(DEBUG) << "deId " << deId << " pos: (" << currData.xCoor << ", " << currData.yCoor << ") err2: ("
                << currData.sigmaX2 << ", " << currData.sigmaY2 << ") => (" << cl.position.x() << "," << cl.position.y()
                << "," << cl.position.z() << ")";
   }
 
+  // Sort the clusters of each RPC in the non-bending coordinate,
+  // so that the search for the next cluster only visits the compatible ones.
+  // The insertion order breaks the ties, so that the result does not depend on the sorting algorithm.
+  // The clusters keep their id, i.e. their position in the input, which is used to flag the matched clusters
+  for (int deId = 0; deId < 72; ++deId) {
+    if (mNClusters[deId] < 2) {
+      continue;
+    }
+    auto first = mClusters[deId].begin();
+    std::sort(first, first + mNClusters[deId], [](const Cluster3D& cl1, const Cluster3D& cl2) {
+      return (cl1.position.x() == cl2.position.x()) ? cl1.id < cl2.id : cl1.position.x() < cl2.position.x();
+    });
+  }
+
   return (clusters.size() > 0);
 }
 
+//______________________________________________________________________________
+void Tracker::getClusterWindow(const Track& track, int deId, int& firstCl, int& lastCl) const
+{
+  /// Gets the range [firstCl, lastCl) of the clusters of the RPC
+  /// that can pass the cut on the non-bending coordinate in tryOneCluster
+  firstCl = 0;
+  lastCl = mNClusters[deId];
+  if (lastCl <= 4) {
+    // Testing the few clusters directly is cheaper than computing the window
+    return;
+  }
+
+  // The cut is computed at the z of the cluster: take the most permissive values
+  // within the z range of the clusters of the RPC
+  const std::array<float, 6> covParams = track.getCovarianceParameters();
+  double minX = 0., maxX = 0., maxErr2 = 0.;
+  double dZs[2] = { mMinZ[deId] - track.getPosition().z(), mMaxZ[deId] - track.getPosition().z() };
+  for (int iz = 0; iz < 2; ++iz) {
+    double dZ = dZs[iz];
+    double xPos = track.getPosition().x() + track.getDirection().x() * dZ;
+    double err2 = covParams[0] + dZ * dZ * covParams[2] + 2. * dZ * covParams[4] + mMaxSigmaX2[deId];
+    minX = (iz == 0) ? xPos : std::min(minX, xPos);
+    maxX = (iz == 0) ? xPos : std::max(maxX, xPos);
+    maxErr2 = (iz == 0) ? err2 : std::max(maxErr2, err2);
+  }
+  if (!(maxErr2 >= 0.)) {
+    // The cut cannot be evaluated: test all clusters
+    return;
+  }
+  // Add a small margin to be safe against rounding
+  double distMax = mSigmaCut * std::sqrt(2. * maxErr2) + 4. + 0.01;
+
+  auto first = mClusters[deId].begin();
+  auto last = first + lastCl;
+  firstCl = std::lower_bound(first, last, minX - distMax,
+                             [](const Cluster3D& cl, double xPos) { return cl.position.x() < xPos; }) -
+            first;
+  lastCl = std::upper_bound(first + firstCl, last, maxX + distMax,
+                            [](double xPos, const Cluster3D& cl) { return xPos < cl.position.x(); }) -
+           first;
+}
+
 //______________________________________________________________________________
 bool Tracker::process(const std::vector<Cluster2D>& clusters)
 {
@@ -250,9 +318,11 @@ bool Tracker::findNextCluster(const Track& track, bool isRight, bool isInward, i
   int nextChamber = (isInward) ? chamber - 1 : chamber + 1;
   int rpcOffset = Constants::getDEId(isRight, chamber, 0);
   Track newTrack;
+  int firstCl = 0, lastCl = 0;
   for (int irpc = firstRPC; irpc <= lastRPC; ++irpc) {
     int deId = rpcOffset + irpc;
-    for (int icl = 0; icl < mNClusters[deId]; ++icl) {
+    getClusterWindow(track, deId, firstCl, lastCl);
+    for (int icl = firstCl; icl < lastCl; ++icl) {
       auto& cl = mClusters[deId][icl];
       double addChi2AtCluster = tryOneCluster(track, cl, newTrack);
       double sumChi2 = chi2 + addChi2AtCluster;
@@ -399,6 +469,14 @@ void Tracker::finalizeTrack(Track& track)
   LOG(DEBUG) << track;
 }
 
+//______________________________________________________________________________
+std::array<int, 4> Tracker::getClusterIds(const Track& track) const
+{
+  /// Gets the Ids of the clusters matched to the track in each chamber
+  return { track.getClusterMatched(0), track.getClusterMatched(1), track.getClusterMatched(2),
+           track.getClusterMatched(3) };
+}
+
 //______________________________________________________________________________
 bool Tracker::addTrack(const Track& track)
 {
@@ -407,6 +485,11 @@ bool Tracker::addTrack(const Track& track)
   /// If track parameters are compatible, selects the track with the
   /// smallest chi2
 
+  std::array<int, 4> clusterIds = getClusterIds(track);
+  if (mTrackClusterIds.count(clusterIds) > 0) {
+    return false;
+  }
+
   float chi2OverNDF = track.getChi2OverNDF();
   // We divide the chi2 by two since we want to consider only the uncertainty
   // on one of the two tracks. We further reduce to 0.4 since we want to account
@@ -414,21 +497,14 @@ bool Tracker::addTrack(const Track& track)
   // of the other
   float chi2Cut = 0.4 * mSigmaCut * mSigmaCut;
   for (int itrack = 0; itrack < mNTracks; ++itrack) {
-    int nCommonClusters = 0;
     auto& checkTrack = mTracks[itrack];
-    for (int ich = 0; ich < 4; ++ich) {
-      if (track.getClusterMatched(ich) == checkTrack.getClusterMatched(ich)) {
-        ++nCommonClusters;
-      }
-    }
-    if (nCommonClusters == 4) {
-      return false;
-    }
     if (track.isCompatible(checkTrack, chi2Cut)) {
       // The new track is compatible with an existing one
       if (chi2OverNDF < checkTrack.getChi2OverNDF()) {
         // The new track is more precise than the old one: replace it!
         LOG(DEBUG) << "Replacing track " << checkTrack << "\n with " << track;
+        mTrackClusterIds.erase(getClusterIds(checkTrack));
+        mTrackClusterIds.insert(clusterIds);
         checkTrack = track;
         return true;
       } else {
@@ -440,6 +516,7 @@ bool Tracker::addTrack(const Track& track)
   }
 
   // The new track is not compatible with the previous ones: add the track to the list
+  mTrackClusterIds.insert(clusterIds);
   ++mNTracks;
   return true;
 }
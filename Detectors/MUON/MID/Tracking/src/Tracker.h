@@ -16,6 +16,8 @@
 #ifndef O2_MID_TRACKER_H
 #define O2_MID_TRACKER_H
 
+#include <array>
+#include <unordered_set>
 #include <vector>
 #include "DataFormatsMID/Cluster2D.h"
 #include "DataFormatsMID/Cluster3D.h"
@@ -63,6 +65,8 @@ class Tracker
   bool findNextCluster(const Track& track, bool isRight, bool isInward, int chamber, int firstRPC, int lastRPC,
                        int& nFiredChambers, double& bestChi2, Track& bestTrack, double chi2 = 0., int depth = 1) const;
   int getClusterId(int id, int deId) const;
+  std::array<int, 4> getClusterIds(const Track& track) const;
+  void getClusterWindow(const Track& track, int deId, int& firstCl, int& lastCl) const;
   int getFirstNeighbourRPC(int rpc) const;
   int getLastNeighbourRPC(int rpc) const;
   bool loadClusters(const std::vector<Cluster2D>& clusters);
@@ -76,11 +80,27 @@ class Tracker
   float mSigmaCut;       ///< Number of sigmas cut
   float mMaxChi2;        ///< Maximum cut on chi2
 
-  std::vector<Cluster3D> mClusters[72]; ///< Ordered arrays of clusters
+  /// Hash of the clusters matched to a track
+  struct ClusterIdsHash {
+    size_t operator()(const std::array<int, 4>& ids) const
+    {
+      size_t hash = 0;
+      for (auto& id : ids) {
+        hash = hash * 1000003 + static_cast<size_t>(id);
+      }
+      return hash;
+    }
+  };
+
+  std::vector<Cluster3D> mClusters[72]; ///< Arrays of clusters ordered in x
   unsigned long int mNClusters[72];     ///< Number of clusters per RPC
+  float mMaxSigmaX2[72];                ///< Maximum dispersion along x of the clusters per RPC
+  float mMinZ[72];                      ///< Minimum z of the clusters per RPC
+  float mMaxZ[72];                      ///< Maximum z of the clusters per RPC
 
   std::vector<Track> mTracks; ///< Array of tracks
   unsigned long int mNTracks; ///< Number of tracks
+  std::unordered_set<std::array<int, 4>, ClusterIdsHash> mTrackClusterIds; ///< Matched clusters of the tracks
 
   GeometryTransformer mTransformer; ///< Geometry transformer
 };
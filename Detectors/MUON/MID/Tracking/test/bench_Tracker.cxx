@@ -95,6 +95,10 @@ static void CustomArguments(benchmark::internal::Benchmark* bench)
   for (int itrack = 1; itrack <= 8; ++itrack) {
     bench->Arg(itrack);
   }
+  // High multiplicities
+  for (int itrack = 16; itrack <= 64; itrack *= 2) {
+    bench->Arg(itrack);
+  }
 }
 
 BENCHMARK_REGISTER_F(BenchTracking, tracking)->Apply(CustomArguments)->Unit(benchmark::kNanosecond);
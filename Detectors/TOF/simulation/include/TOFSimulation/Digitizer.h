@@ -16,6 +16,10 @@
 #include "TOFSimulation/Detector.h"
 #include "SimulationDataFormat/MCTruthContainer.h"
 #include "TOFSimulation/MCLabel.h"
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
 
 namespace o2
 {
@@ -51,6 +55,19 @@ class Digitizer
     mMCTruthContainer = truthcontainer;
   }
 
+  /// forget the digits indexed for merging, to be called when a new readout window starts
+  /// (done automatically when process() is given another or a cleared digits container)
+  void resetDigitIndex() { mDigitIndex.reset(); }
+
+  /// in continuous mode the digits are accumulated per readout window (Geo::TIMEFRAMEWINDOW) and
+  /// process() moves to its output only the windows completed before the current event time
+  void setContinuous(bool v) { mContinuous = v; }
+  bool isContinuous() const { return mContinuous; }
+  /// move to the output the digits (and their labels to the MC truth container) of the readout windows
+  /// ending before maxTime (ns), by default of all the buffered windows
+  void fillOutputContainer(std::vector<Digit>* digits, double maxTime = std::numeric_limits<double>::max());
+  int getNOpenWindows() const { return mWindows.size(); }
+
   void initParameters();
   void printParameters();
 
@@ -91,7 +108,50 @@ class Digitizer
   void addDigit(Int_t channel, Float_t time, Float_t x, Float_t z, Float_t charge, Int_t iX, Int_t iZ, Int_t padZfired,
                 Int_t trackID);
 
-  bool isMergable(Digit digit1, Digit digit2)
+  // index of the digits of a readout window by (channel, BC), to find merging candidates in O(1):
+  // open addressing table pointing to the last digit added with a given key, the previous digits with
+  // the same key being chained through nextSameKey
+  struct DigitIndex {
+    struct Slot {
+      uint64_t key;
+      int digit; // -1 for an empty slot
+    };
+    std::vector<Slot> table;
+    std::vector<int> nextSameKey; ///< previous digit with the same (channel, BC), -1 if none
+    std::vector<int> usedSlots;   ///< filled slots of the table, to reset only those
+    size_t nIndexed = 0;
+
+    static uint64_t key(Int_t channel, Int_t bc) { return (uint64_t(uint32_t(bc)) << 32) | uint32_t(channel); }
+    int first(Int_t channel, Int_t bc) const; ///< last digit added with this channel and BC, -1 if none
+    int next(int digit) const { return nextSameKey[digit]; }
+    void add(const std::vector<Digit>& digits, int digitindex);
+    void reset();
+
+   private:
+    size_t findSlot(uint64_t key) const;
+    void grow();
+  };
+
+  DigitIndex mDigitIndex;                             //! index of the digits in mDigits (triggered mode)
+  const std::vector<Digit>* mIndexedDigits = nullptr; //! digits container mDigitIndex refers to
+  void syncDigitIndex();
+
+  // continuous mode: the digits are buffered per readout window until the window is complete
+  struct ReadoutWindow {
+    Int_t id = 0;
+    std::vector<Digit> digits;
+    o2::dataformats::MCTruthContainer<o2::tof::MCLabel> labels;
+    DigitIndex index;
+  };
+  bool mContinuous = false;
+  std::deque<ReadoutWindow> mWindows;        //! open readout windows, in increasing id
+  std::vector<ReadoutWindow> mFreeWindows;   //! flushed windows, kept to reuse their memory
+  ReadoutWindow& getWindow(Int_t id);
+
+  /// max time (ns) a digit can precede its collision because of the smearing and time walk corrections
+  static constexpr double MAXEARLYDIGITTIME = 5.;
+
+  bool isMergable(const Digit& digit1, const Digit& digit2) const
   {
     if (digit1.getChannel() != digit2.getChannel()) {
       return false;
@@ -20,6 +20,7 @@
 #include "TRandom.h"
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 
 using namespace o2::tof;
 
@@ -29,16 +30,59 @@ void Digitizer::process(const std::vector<HitType>* hits,std::vector<Digit>* dig
   // hits array of TOF hits for a given simulated event
   mDigits = digits;
 
+  if (mContinuous) {
+    // the collisions come ordered in time: the windows ending before this one are complete
+    fillOutputContainer(digits, mEventTime - MAXEARLYDIGITTIME);
+  } else {
+    syncDigitIndex();
+  }
+
   for (auto& hit : *hits) {
-    Int_t timeframe =
-      Int_t((mEventTime + hit.GetTime()) * Geo::TIMEFRAMEWINDOW_INV); // to be replaced with uncalibrated time
-    //TODO: put timeframe counting/selection
-    //if (timeframe == mTimeFrameCurrent) {
-      processHit(hit, mEventTime);
-    //}
+    processHit(hit, mEventTime);
   } // end loop over hits
 }
 
+void Digitizer::fillOutputContainer(std::vector<Digit>* digits, double maxTime)
+{
+  while (!mWindows.empty() && (mWindows.front().id + 1) * double(Geo::TIMEFRAMEWINDOW) <= maxTime) {
+    auto& window = mWindows.front();
+    if (mMCTruthContainer) {
+      // the labels of the output are indexed by the position of the digits in the output
+      assert(mMCTruthContainer->getIndexedSize() == digits->size());
+      mMCTruthContainer->mergeAtBack(window.labels);
+    }
+    digits->insert(digits->end(), window.digits.begin(), window.digits.end());
+
+    window.digits.clear();
+    window.labels.clear();
+    window.index.reset();
+    mFreeWindows.emplace_back(std::move(window));
+    mWindows.pop_front();
+  }
+  if (!mWindows.empty()) {
+    mTimeFrameCurrent = mWindows.front().id;
+  }
+}
+
+Digitizer::ReadoutWindow& Digitizer::getWindow(Int_t id)
+{
+  // windows are mostly requested in increasing order
+  auto iter = mWindows.end();
+  while (iter != mWindows.begin() && std::prev(iter)->id >= id) {
+    --iter;
+  }
+  if (iter != mWindows.end() && iter->id == id) {
+    return *iter;
+  }
+  ReadoutWindow window;
+  if (!mFreeWindows.empty()) {
+    window = std::move(mFreeWindows.back());
+    mFreeWindows.pop_back();
+  }
+  window.id = id;
+  return *mWindows.emplace(iter, std::move(window));
+}
+
 
 Int_t Digitizer::processHit(const HitType &hit,Double_t event_time)
 {
@@ -194,52 +238,143 @@ void Digitizer::addDigit(Int_t channel, Float_t time, Float_t x, Float_t z, Floa
   Int_t nbc = Int_t(time * Geo::BC_TIME_INPS_INV); // time elapsed in number of bunch crossing
   Digit newdigit(time, channel, (time - Geo::BC_TIME_INPS * nbc) * Geo::NTDCBIN_PER_PS, tot * Geo::NTOTBIN_PER_NS, nbc);
 
-  // check if such mergeable digit already exists
-  int digitindex = 0;
-  for (auto& digit : *mDigits) {
-    if (isMergable(digit, newdigit)) {
-      LOG(INFO) << "MERGING DIGITS " << digitindex << "\n";
-      merged = true;
-      // merge it
-      if (newdigit.getTDC() < digit.getTDC()) {
-        // adjust TOT
-        digit.setTDC(newdigit.getTDC());
-        digit.setTimeStamp(newdigit.getTimeStamp());
-      } else {
-        // adjust TOT
-      }
-      // adjust truth information
-      if (mMCTruthContainer) {
-        o2::tof::MCLabel label(trackID, mEventID, mSrcID, newdigit.getTDC());
-        mMCTruthContainer->addElementRandomAccess(digitindex, label);
-
-        // sort the labels according to increasing tdc value
-        auto labels = mMCTruthContainer->getLabels(digitindex);
-        std::sort(labels.begin(), labels.end(),
-                  [](o2::tof::MCLabel a, o2::tof::MCLabel b) { return a.getTDC() < b.getTDC(); });
-        //for (auto& e : labels) {
-        //  LOG(INFO) << e.getEventID() << " " << e.getTrackID() << " " << e.getTDC() << "\n";
-        //}
-        // assert(labels[0].getTDC() <= labels[1].getTDC());
-      }
+  // in continuous mode the digit goes to the buffer of its readout window
+  std::vector<Digit>* digits = mDigits;
+  o2::dataformats::MCTruthContainer<o2::tof::MCLabel>* mcTruthContainer = mMCTruthContainer;
+  DigitIndex* index = &mDigitIndex;
+  if (mContinuous) {
+    auto& window = getWindow(Int_t(time * 1E-3 * Geo::TIMEFRAMEWINDOW_INV));
+    digits = &window.digits;
+    mcTruthContainer = mMCTruthContainer ? &window.labels : nullptr;
+    index = &window.index;
+  }
+
+  // check if such mergeable digit already exists, only digits with the same channel and BC are candidates
+  int digitindex = -1;
+  for (int idx = index->first(channel, nbc); idx >= 0; idx = index->next(idx)) {
+    if (isMergable((*digits)[idx], newdigit)) {
+      digitindex = idx;
       break;
     }
-    digitindex++;
+  }
+
+  if (digitindex >= 0) {
+    auto& digit = (*digits)[digitindex];
+    LOG(DEBUG) << "MERGING DIGITS " << digitindex << "\n";
+    merged = true;
+    // merge it
+    if (newdigit.getTDC() < digit.getTDC()) {
+      // adjust TOT
+      digit.setTDC(newdigit.getTDC());
+      digit.setTimeStamp(newdigit.getTimeStamp());
+    } else {
+      // adjust TOT
+    }
+    // adjust truth information
+    if (mcTruthContainer) {
+      o2::tof::MCLabel label(trackID, mEventID, mSrcID, newdigit.getTDC());
+      mcTruthContainer->addElementRandomAccess(digitindex, label);
+
+      // keep the labels sorted according to increasing tdc value: the previous ones are already sorted,
+      // the new label (at the back) has just to be moved in place
+      auto labels = mcTruthContainer->getLabels(digitindex);
+      auto pos = std::upper_bound(
+        labels.begin(), labels.end() - 1, label,
+        [](const o2::tof::MCLabel& a, const o2::tof::MCLabel& b) { return a.getTDC() < b.getTDC(); });
+      std::rotate(pos, labels.end() - 1, labels.end());
+    }
   }
 
   if (!merged) {
     // note that tdc calculation is done in [ps]; whereas the tot is done in [ns]
     auto tdc = (time - Geo::BC_TIME_INPS * nbc) * Geo::NTDCBIN_PER_PS;
-    mDigits->emplace_back(time, channel, tdc, tot * Geo::NTOTBIN_PER_NS, nbc);
+    digits->emplace_back(time, channel, tdc, tot * Geo::NTOTBIN_PER_NS, nbc);
+    index->add(*digits, digits->size() - 1);
 
-    if (mMCTruthContainer) {
-      auto ndigits = mDigits->size() - 1;
+    if (mcTruthContainer) {
+      auto ndigits = digits->size() - 1;
       o2::tof::MCLabel label(trackID, mEventID, mSrcID, tdc);
-      mMCTruthContainer->addElement(ndigits, label);
+      mcTruthContainer->addElement(ndigits, label);
     }
   }
 }
 
+void Digitizer::syncDigitIndex()
+{
+  // a new readout window starts when we are given another container or the current one was cleared
+  if (mDigits != mIndexedDigits || mDigits->size() < mDigitIndex.nIndexed) {
+    mDigitIndex.reset();
+    mIndexedDigits = mDigits;
+  }
+  // index the digits which were not added by this digitizer
+  for (size_t i = mDigitIndex.nIndexed; i < mDigits->size(); i++) {
+    mDigitIndex.add(*mDigits, i);
+  }
+}
+
+void Digitizer::DigitIndex::reset()
+{
+  for (auto slot : usedSlots) {
+    table[slot].digit = -1;
+  }
+  usedSlots.clear();
+  nextSameKey.clear();
+  nIndexed = 0;
+}
+
+size_t Digitizer::DigitIndex::findSlot(uint64_t key) const
+{
+  // returns the slot holding the key or the empty slot where it should be inserted
+  const size_t mask = table.size() - 1;
+  size_t slot = ((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  while (table[slot].digit >= 0 && table[slot].key != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+int Digitizer::DigitIndex::first(Int_t channel, Int_t bc) const
+{
+  if (table.empty()) {
+    return -1;
+  }
+  return table[findSlot(key(channel, bc))].digit;
+}
+
+void Digitizer::DigitIndex::grow()
+{
+  // the size stays a power of 2 and the load factor below 1/2
+  std::vector<Slot> old;
+  old.swap(table);
+  table.assign(old.empty() ? 1024 : old.size() * 2, Slot{ 0, -1 });
+  usedSlots.clear();
+  for (const auto& entry : old) {
+    if (entry.digit >= 0) {
+      auto slot = findSlot(entry.key);
+      table[slot] = entry;
+      usedSlots.push_back(slot);
+    }
+  }
+}
+
+void Digitizer::DigitIndex::add(const std::vector<Digit>& digits, int digitindex)
+{
+  if (2 * (usedSlots.size() + 1) > table.size()) {
+    grow();
+  }
+  const auto& digit = digits[digitindex];
+  auto digitKey = key(digit.getChannel(), digit.getBC());
+  auto slot = findSlot(digitKey);
+  if (table[slot].digit < 0) {
+    table[slot].key = digitKey;
+    usedSlots.push_back(slot);
+  }
+  nextSameKey.resize(digitindex + 1, -1);
+  nextSameKey[digitindex] = table[slot].digit;
+  table[slot].digit = digitindex;
+  nIndexed = digitindex + 1;
+}
+
 Float_t Digitizer::getShowerTimeSmeared(Float_t time, Float_t charge)
 {
   // add the smearing common to all the digits belongin to the same shower
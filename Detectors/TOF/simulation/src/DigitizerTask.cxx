@@ -54,6 +54,9 @@ InitStatus DigitizerTask::Init()
 
   //  mDigitizer.setCoeffToNanoSecond(mFairTimeUnitInNS);
 
+  // in continuous mode the digits of each event entry are those of the readout windows completed so far
+  mDigitizer.setContinuous(mContinuous);
+
   //  mDigitizer.init();
   return kSUCCESS;
 }
@@ -107,7 +110,19 @@ void DigitizerTask::FinishTask()
   mgr->SetLastFill(kTRUE); /// necessary, otherwise the data is not written out
   if (mDigitsArray)
     mDigitsArray->clear();
+  if (mMCTruthArray) {
+    mMCTruthArray->clear();
+  }
+
+  o2::dataformats::MCTruthContainer<o2::tof::MCLabel> transientTruthContainer;
+  mDigitizer.setMCTruthContainer(&transientTruthContainer);
 
-  // TODO: reenable this
-  // mDigitizer.fillOutputContainer(mDigitsArray);
+  mDigitizer.fillOutputContainer(mDigitsArray);
+
+  if (mMCTruthArray) {
+    for (int index = 0; index < transientTruthContainer.getIndexedSize(); ++index) {
+      mMCTruthArray->addElements(index, transientTruthContainer.getLabels(index));
+    }
+  }
+  mDigitizer.setMCTruthContainer(nullptr);
 }
@@ -0,0 +1,89 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file   TOF/simulation/test/bench_Digitizer.cxx
+/// \brief  Benchmark of the TOF digitization of piled-up collisions
+
+#include "benchmark/benchmark.h"
+#include <random>
+#include <vector>
+#include "TMath.h"
+#include "TOFBase/Geo.h"
+#include "TOFSimulation/Digitizer.h"
+
+using o2::tof::Geo;
+using o2::tof::HitType;
+
+// positions of hits on the TOF surface, generated once and shared by all the collisions
+// (the same tracks seen in several collisions give overlapping hits, as with pileup)
+std::vector<HitType> generateHitPool(int nhits, std::mt19937& mt)
+{
+  std::uniform_real_distribution<float> distPhi(0., TMath::TwoPi());
+  std::uniform_real_distribution<float> distZ(-Geo::MAXHZTOF, Geo::MAXHZTOF);
+  std::uniform_real_distribution<float> distR(Geo::RMIN, Geo::RMAX);
+
+  std::vector<HitType> hits;
+  Int_t det[5];
+  while (int(hits.size()) < nhits) {
+    float r = distR(mt), phi = distPhi(mt);
+    Float_t pos[3] = { r * std::cos(phi), r * std::sin(phi), distZ(mt) };
+    Geo::getDetID(pos, det);
+    if (det[0] < 0 || det[1] < 0 || det[2] < 0 || det[3] < 0 || det[4] < 0) {
+      continue; // not in a pad
+    }
+    hits.emplace_back(pos[0], pos[1], pos[2], 10., 1.e-5, hits.size(), 0);
+  }
+  return hits;
+}
+
+static void BM_DigitizePileup(benchmark::State& state)
+{
+  int nCollisions = state.range(0);
+  int nHitsPerCollision = state.range(1);
+
+  std::mt19937 mt(12345);
+  auto pool = generateHitPool(4 * nHitsPerCollision, mt);
+  std::uniform_int_distribution<int> distHit(0, pool.size() - 1);
+  std::uniform_real_distribution<double> distTime(0., Geo::TIMEFRAMEWINDOW);
+
+  // collisions of one readout window
+  std::vector<std::vector<HitType>> collisions(nCollisions);
+  std::vector<double> collisionTimes(nCollisions);
+  for (int icol = 0; icol < nCollisions; icol++) {
+    for (int ihit = 0; ihit < nHitsPerCollision; ihit++) {
+      collisions[icol].push_back(pool[distHit(mt)]);
+    }
+    collisionTimes[icol] = distTime(mt);
+  }
+
+  o2::tof::Digitizer digitizer;
+  std::vector<o2::tof::Digit> digits;
+  o2::dataformats::MCTruthContainer<o2::tof::MCLabel> labels;
+  digitizer.setMCTruthContainer(&labels);
+
+  double ndigits = 0;
+  for (auto _ : state) {
+    digits.clear(); // new readout window
+    labels.clear();
+    for (int icol = 0; icol < nCollisions; icol++) {
+      digitizer.setEventTime(collisionTimes[icol]);
+      digitizer.setEventID(icol);
+      digitizer.process(&collisions[icol], &digits);
+    }
+    ndigits += digits.size();
+  }
+
+  state.counters["digits"] = benchmark::Counter(ndigits, benchmark::Counter::kIsRate);
+  state.counters["collisions"] = benchmark::Counter(double(nCollisions) * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_DigitizePileup)->RangeMultiplier(2)->Ranges({ { 1, 64 }, { 1000, 1000 } })->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
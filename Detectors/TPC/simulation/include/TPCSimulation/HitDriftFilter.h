@@ -15,11 +15,45 @@
 #ifndef ALICEO2_TPC_HitDriftFilter_H_
 #define ALICEO2_TPC_HitDriftFilter_H_
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "TChain.h"
+
 namespace o2
 {
 namespace TPC
 {
 
+// select the hit groups of one event (chain entry) within the time window
+inline void selectHitGroups(const std::vector<o2::TPC::HitGroup>& groups, int entry, float eventtime,
+                            std::vector<o2::TPC::TPCHitGroupID>& hitids, float tmin /*NS*/, float tmax /*NS*/,
+                            const std::function<float(float, float, float)>& f)
+{
+  int groupid = -1;
+  for (auto& singlegroup : groups) {
+    if (singlegroup.getSize() == 0) {
+      // there are not hits in this group .. so continue
+      // TODO: figure out why such a group would exist??
+      continue;
+    }
+    groupid++;
+    auto zmax = singlegroup.mZAbsMax;
+    auto zmin = singlegroup.mZAbsMin;
+    // in case of secondaries, the time ordering may be reversed
+    if (zmax < zmin) {
+      std::swap(zmax, zmin);
+    }
+    float tmaxtrack = f(eventtime, 0., zmin);
+    float tmintrack = f(eventtime, 0., zmax);
+    if (tmin > tmaxtrack || tmax < tmintrack) {
+      continue;
+    }
+    // need to record index of the group
+    hitids.emplace_back(entry, groupid);
+  }
+}
+
 template <typename Collection>
 void getHits(TChain& chain, const Collection& eventrecords, std::vector<std::vector<o2::TPC::HitGroup>*>& hitvectors,
              std::vector<o2::TPC::TPCHitGroupID>& hitids, const char* branchname, float tmin /*NS*/, float tmax /*NS*/,
@@ -50,33 +84,7 @@ void getHits(TChain& chain, const Collection& eventrecords, std::vector<std::vec
       br->GetEntry(entry);
     }
 
-    int groupid = -1;
-    auto groups = hitvectors[entry];
-    for (auto& singlegroup : *groups) {
-      if (singlegroup.getSize() == 0) {
-        // there are not hits in this group .. so continue
-        // TODO: figure out why such a group would exist??
-        continue;
-      }
-      const auto& pos = singlegroup.getHit(0).getPos();
-      // std::cout << "This Group is in sector " << o2::TPC::Sector::ToSector(pos.X(), pos.Y(), pos.Z()) << "\n";
-      groupid++;
-      auto zmax = singlegroup.mZAbsMax;
-      auto zmin = singlegroup.mZAbsMin;
-      // in case of secondaries, the time ordering may be reversed
-      if (zmax < zmin) {
-        std::swap(zmax, zmin);
-      }
-      // auto tof = singlegroup.
-      float tmaxtrack = f(eventrecords[entry].timeNS, 0., zmin);
-      float tmintrack = f(eventrecords[entry].timeNS, 0., zmax);
-      if (tmin > tmaxtrack || tmax < tmintrack) {
-        // std::cout << "DISCARDING " << groupid << " OF ENTRY " << entry << "\n";
-        continue;
-      }
-      // need to record index of the group
-      hitids.emplace_back(entry, groupid);
-    }
+    selectHitGroups(*hitvectors[entry], entry, eventrecords[entry].timeNS, hitids, tmin, tmax, f);
   }
 }
 
@@ -13,6 +13,7 @@
 #include "Framework/ChannelSpec.h"
 
 #include <functional>
+#include <string>
 
 namespace o2
 {
@@ -52,6 +53,15 @@ struct ChannelConfigurationPolicyHelpers {
   static InputChannelModifier reqInput;
   /// Makes the passed output channel bind and reply
   static OutputChannelModifier replyOutput;
+
+  /// Whether @a hostname refers to the host the workflow runs on.
+  static bool isLocalHost(std::string const& hostname);
+  /// Applies @a modifier to the passed input channel and makes it use
+  /// @a protocol (e.g. ipc or shared memory) if the channel does not leave
+  /// the host. Remote channels keep using the network.
+  static InputChannelModifier localInput(InputChannelModifier modifier, ChannelProtocol protocol);
+  /// Same as localInput, for the output channels.
+  static OutputChannelModifier localOutput(OutputChannelModifier modifier, ChannelProtocol protocol);
 };
 
 } // namespace framework
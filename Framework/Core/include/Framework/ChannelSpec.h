@@ -30,6 +30,14 @@ enum ChannelType {
   Pull,
 };
 
+/// How the messages of a channel travel between the two devices. IPC and
+/// SharedMemory can only be used when both ends run on the same host.
+enum ChannelProtocol {
+  Network,
+  IPC,
+  SharedMemory
+};
+
 /// This describes an input channel. Since they are point to 
 /// point connections, there is not much to say about them.
 struct InputChannelSpec {
@@ -37,6 +45,8 @@ struct InputChannelSpec {
   enum ChannelType type;
   enum ChannelMethod method;
   unsigned short port;
+  std::string hostname = "localhost";
+  enum ChannelProtocol protocol = ChannelProtocol::Network;
 };
 
 /// This describes an output channel. Output channels are semantically
@@ -50,6 +60,8 @@ struct OutputChannelSpec {
   enum ChannelMethod method;
   unsigned short port;
   size_t listeners;
+  std::string hostname = "localhost";
+  enum ChannelProtocol protocol = ChannelProtocol::Network;
 };
 
 }
@@ -16,6 +16,7 @@
 #include "Framework/OutputRef.h"
 #include "Framework/OutputRoute.h"
 #include "Framework/DataChunk.h"
+#include "Framework/DataRef.h"
 #include "Framework/MessageContext.h"
 #include "Framework/RootObjectContext.h"
 #include "Framework/TMessageSerializer.h"
@@ -24,6 +25,7 @@
 
 #include "fairmq/FairMQMessage.h"
 
+#include <memory>
 #include <vector>
 #include <map>
 #include <string>
@@ -58,7 +60,22 @@ public:
   DataChunk newChunk(const Output&, size_t);
   DataChunk newChunk(OutputRef const& ref, size_t size) { return newChunk(getOutputByBind(ref), size); }
 
-  DataChunk adoptChunk(const Output&, char *, size_t, fairmq_free_fn*, void *);
+  /// Send the buffer without copying it, the free function is called with the hint once the buffer is
+  /// not used anymore. The buffer can also hold already serialized data, e.g. a TMessage buffer shared
+  /// between several outputs, with the serialization method to be used by the consumers.
+  DataChunk adoptChunk(const Output&, char *, size_t, fairmq_free_fn*, void *,
+                       o2::header::SerializationMethod method = o2::header::gSerializationMethodNone);
+
+  /// Send the payload of @a input, one of the inputs being processed, without
+  /// copying it. The input message is shared between the input record and the
+  /// new output and is released once both are done with it, so the input can
+  /// still be forwarded after the processing. The serialization method of the
+  /// input is kept.
+  DataChunk adoptInput(const Output&, DataRef const& input);
+
+  /// Sets the messages of the inputs being processed, as ordered in the
+  /// InputRecord, so that they can be shared with adoptInput.
+  void setInputs(std::vector<std::unique_ptr<FairMQMessage>>* inputs) { mInputs = inputs; }
 
   // In case no extra argument is provided and the passed type is trivially
   // copyable and non polymorphic, the most likely wanted behavior is to create
@@ -336,10 +353,11 @@ public:
   AllowedOutputRoutes mAllowedOutputRoutes;
   MessageContext* mContext;
   RootObjectContext* mRootContext;
+  std::vector<std::unique_ptr<FairMQMessage>>* mInputs = nullptr;
 
-  std::string matchDataHeader(const Output &spec, size_t timeframeId);
+  OutputRoute const& matchDataRoute(const Output &spec, size_t timeframeId);
   FairMQMessagePtr headerMessageFromOutput(Output const &spec,
-                                           std::string const &channel,
+                                           OutputRoute const &route,
                                            o2::header::SerializationMethod serializationMethod);
 
   Output getOutputByBind(OutputRef const& ref)
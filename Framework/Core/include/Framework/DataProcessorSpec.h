@@ -49,6 +49,11 @@ struct DataProcessorSpec {
   /// which involve a DataProcessorSpec with a given label.
   /// Examples labels could be "reco", "qc".
   std::vector<DataProcessorLabel> labels;
+  /// Resources needed by the DataProcessor, in number of cores and MB
+  /// of memory. Resource aware ResourceManagers use them to place the
+  /// associated devices on the node. Zero means no specific requirement.
+  float cpuRequirement = 0.f;
+  float memoryRequirement = 0.f;
 
   // FIXME: for the moment I put them here, but it's a hack
   //        since we do not want to expose this to users...
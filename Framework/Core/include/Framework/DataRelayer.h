@@ -57,6 +57,16 @@ public:
   std::vector<std::unique_ptr<FairMQMessage>>
   getInputsForTimeslice(size_t i);
 
+  /// Gives back the Condition inputs handed out by getInputsForTimeslice
+  /// once the processing is done, so that they can be reused for the
+  /// following timeslices. The other inputs are left untouched.
+  void recycleConditions(std::vector<std::unique_ptr<FairMQMessage>> &inputs);
+
+  /// Returns true if the input at position @a pos of the last timeslice
+  /// handed out is a Condition which was already handed out for a previous
+  /// timeslice, and therefore must not be forwarded again.
+  bool isReusedCondition(size_t pos) const;
+
   /// Returns the index of the arguments which have to be forwarded to
   /// the next processor
   const std::vector<int> &forwardingMask();
@@ -86,6 +96,29 @@ private:
   /// This is the timeslices for all the in flight parts.
   std::vector<TimesliceId> mTimeslices;
 
+  /// A version of a Condition input, valid for the timeslices in
+  /// [validFrom, validUntil).
+  struct ConditionVersion {
+    PartRef part;
+    int64_t validFrom;
+    int64_t validUntil;
+    bool handedOut; // Whether it was already used for a timeslice
+  };
+
+  /// Condition inputs are not stored in the cache lines, but only once
+  /// for each version, and then used for all the timeslices they are valid
+  /// for, until a newer version arrives. The versions are sorted by
+  /// validFrom. Empty for the inputs which are not Conditions.
+  std::vector<std::vector<ConditionVersion>> mConditions;
+  /// Version of each Condition handed out with the last timeslice, or -1.
+  std::vector<int> mHandedOutConditions;
+  /// Whether each Condition handed out with the last timeslice was
+  /// already used for a previous one.
+  std::vector<bool> mReusedConditions;
+  /// Whether each input is a Condition kept aside from the cache lines,
+  /// computed once since it is needed for every message and timeslice.
+  std::vector<bool> mIsConditionInput;
+
   std::vector<bool> mForwardingMask;
 };
 
@@ -13,6 +13,8 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <regex>
 #include <string>
 #include <vector>
@@ -26,27 +28,113 @@ enum class MetricType {
   Unknown
 };
 
+/// Maximum number of raw points kept for each metric. The buffers
+/// start small and double in size when full, until they reach this
+/// size, after which they are used as circular buffers.
+constexpr size_t METRIC_HISTORY_SIZE = 1024;
+constexpr size_t METRIC_HISTORY_INITIAL_SIZE = 16;
+/// Older points are kept in downsampled tiers, each point of a tier
+/// summarising METRIC_SUMMARY_FACTOR points of the previous one.
+constexpr size_t METRIC_SUMMARY_TIERS = 3;
+constexpr size_t METRIC_SUMMARY_FACTOR = 16;
+constexpr size_t METRIC_SUMMARY_SIZE = 256;
+/// Longest label which can be registered on the binary metrics channel.
+constexpr size_t MAX_BINARY_METRIC_LABEL = 255;
+
 struct MetricInfo {
   enum MetricType type;
   size_t storeIdx; // Index in the actual store
   size_t pos; // Last position in the circular buffer
+  size_t filled = 0; // Number of valid points in the circular buffer
+};
+
+/// Summary of consecutive points of a metric.
+struct MetricSummary {
+  size_t timestamp; // Timestamp of the first point summarised
+  float min;
+  float max;
+  double sum;
+  size_t count; // Number of raw points summarised
+};
+
+/// A downsampled history of a metric. The summaries are a circular
+/// buffer growing on demand up to METRIC_SUMMARY_SIZE, current is the
+/// summary still being accumulated.
+struct MetricSummaryTier {
+  std::vector<MetricSummary> summaries;
+  size_t pos = 0;
+  MetricSummary current = { 0, 0, 0, 0, 0 };
 };
 
 /// This struct hold information about device metrics when running
 /// in standalone mode
 struct DeviceMetricsInfo {
-  std::vector<std::array<int, 1024>> intMetrics;
-  std::vector<std::array<float, 1024>> floatMetrics;
-  std::vector<std::array<size_t, 1024>> timestamps;
+  std::vector<std::vector<int>> intMetrics;
+  std::vector<std::vector<float>> floatMetrics;
+  std::vector<std::vector<size_t>> timestamps;
+  /// Downsampled history of each metric, indexed like timestamps.
+  std::vector<std::array<MetricSummaryTier, METRIC_SUMMARY_TIERS>> summaries;
+  /// Labels of the metrics, sorted, with their index in metrics.
   std::vector<std::pair<std::string, size_t>> metricLabelsIdx;
   std::vector<MetricInfo> metrics;
+  /// Index in metrics of each id registered by the device on the binary
+  /// metrics channel.
+  std::vector<size_t> binaryIdsIdx;
+  /// Bytes received on the binary metrics channel which do not form a
+  /// complete record yet.
+  std::string unprocessedBinary;
+  /// A record with an impossible size was received on the binary metrics
+  /// channel: the records cannot be delimited anymore, so the rest of the
+  /// channel is ignored.
+  bool binaryStreamBroken = false;
+};
+
+/// Records sent by a device to the driver on the binary metrics channel.
+/// A label is registered once with a small id, the values then only
+/// carry the id, so that no parsing is needed on the driver side.
+enum class BinaryMetricKind : uint8_t {
+  Register,
+  Value
+};
+
+struct BinaryMetricHeader {
+  BinaryMetricKind kind;
+  MetricType type;
+  uint16_t id;
+  /// Size of the label for Register records, of the value for Value records
+  uint32_t size;
+};
+
+struct BinaryMetricValue {
+  uint64_t timestamp;
+  union {
+    int32_t intValue;
+    float floatValue;
+  };
 };
 
+/// Appends to @a buffer the record registering @a label with @a id
+void encodeMetricRegistration(std::string &buffer, uint16_t id, MetricType type, const char *label);
+/// Appends to @a buffer the record for a new value of the metric @a id
+void encodeMetricValue(std::string &buffer, uint16_t id, MetricType type, uint64_t timestamp,
+                       BinaryMetricValue value);
 
 bool parseMetric(const std::string &s, std::smatch &match);
 bool processMetric(const std::smatch &match, DeviceMetricsInfo &info);
+/// Processes the complete records in @a info.unprocessedBinary after
+/// appending @a data to it. Returns false if a record was invalid, or if
+/// the channel is broken (see DeviceMetricsInfo::binaryStreamBroken).
+bool processBinaryMetrics(const char *data, size_t size, DeviceMetricsInfo &info);
 size_t metricIdxByName(const std::string &name,
                        const DeviceMetricsInfo &info);
+/// Writes the history of all the metrics of @a info, raw points and
+/// downsampled tiers, as CSV lines in the form
+///
+/// <device>,<metric>,<tier>,<timestamp>,<min>,<max>,<average>,<count>
+///
+/// where tier is "raw" or the index of the downsampled tier.
+void dumpMetricsHistory(std::ostream &out, const std::string &device,
+                        const DeviceMetricsInfo &info);
 
 }
 }
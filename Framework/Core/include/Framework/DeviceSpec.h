@@ -46,6 +46,10 @@ struct DeviceSpec {
   size_t rank; // Id of a parallel processing I am part of
   size_t nSlots; // Total number of parallel units I am part of
   size_t inputTimesliceId;
+  float cpuRequirement = 0.f; // Cores needed, as declared by the DataProcessor
+  float memoryRequirement = 0.f; // MB needed, as declared by the DataProcessor
+  std::vector<int> cpuAffinity; // Cores the device is pinned to, if not empty
+  int numaDomain = -1; // NUMA domain the device was placed on, if any
 };
 
 }
@@ -16,6 +16,8 @@
 ///
 /// \author Piotr Konopka, piotr.jan.konopka@cern.ch
 
+#include <chrono>
+#include <cstdint>
 #include <random>
 
 #include "Framework/DataProcessorSpec.h"
@@ -70,12 +72,24 @@ class Dispatcher
    public:
     BernoulliGenerator(double probabilityOfTrue = 1.0,
                        unsigned int seed = (unsigned int)std::chrono::system_clock::now().time_since_epoch().count())
-      : mGenerator(seed), mDistribution(probabilityOfTrue){};
+      : mGenerator(seed), mDistribution(probabilityOfTrue), mSeed(seed){};
     bool drawLots() { return mDistribution(mGenerator); }
+    /// Draws the lots for a whole timeslice. The result depends only on the seed and on the timeslice, so that
+    /// all the dispatchers of a task, parallel or time pipelined, sample the same timeslices.
+    bool drawLots(uint64_t timeslice) const
+    {
+      // splitmix64 mixing of the timeslice, the 53 upper bits make a uniform double in [0, 1)
+      uint64_t z = mSeed + (timeslice + 1) * 0x9e3779b97f4a7c15ULL;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      z = z ^ (z >> 31);
+      return (z >> 11) * (1.0 / (1ULL << 53)) < mDistribution.p();
+    }
 
    private:
     std::default_random_engine mGenerator;
     std::bernoulli_distribution mDistribution;
+    uint64_t mSeed;
   };
 
   /// Creates dispatcher output specification basing on input specification of the same data. Basically, it adds '_S' at
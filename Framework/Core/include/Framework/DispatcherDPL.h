@@ -16,6 +16,8 @@
 ///
 /// \author Piotr Konopka, piotr.jan.konopka@cern.ch
 
+#include <chrono>
+
 #include "Framework/Dispatcher.h"
 #include "Framework/DataSamplingConfig.h"
 
@@ -44,8 +46,15 @@ class DispatcherDPL : public Dispatcher
                  const std::string& binding) override;
 
  private:
+  /// Bytes sent to the QC tasks since start, posted as a rate about once per second
+  struct SampledBytesCounter {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+  };
+
   /// Dispatcher callback with DPL outputs
-  static void processCallback(ProcessingContext& ctx, Dispatcher::BernoulliGenerator& bernoulliGenerator);
+  static void processCallback(ProcessingContext& ctx, Dispatcher::BernoulliGenerator& bernoulliGenerator,
+                              SampledBytesCounter& counter);
 };
 
 } // namespace framework
@@ -34,6 +34,40 @@ namespace framework {
 
 struct InputSpec;
 
+/// A binding to one of the inputs of a DataProcessor. The binding is
+/// resolved to the position of the input the first time the handle is
+/// used, following lookups are then a direct index rather than a
+/// comparison with all the bindings of the device. Create the handles
+/// once, e.g. in the init callback, and use them for every timeslice:
+///
+///   InputHandle clusters{"clusters"};
+///   return [clusters](ProcessingContext& ctx) {
+///     auto& header = ctx.inputs().get<ClusterHeader>(clusters);
+///   };
+class InputHandle {
+public:
+  InputHandle(std::string binding) : mBinding{std::move(binding)} {}
+  InputHandle(char const* binding) : mBinding{binding} {}
+
+  std::string const& binding() const { return mBinding; }
+
+private:
+  friend class InputRecord;
+  std::string mBinding;
+  // The position the binding was last resolved to
+  mutable int mPos = -1;
+};
+
+/// The types which can refer to an input in InputRecord::get: the binding of
+/// the input, as a C string or a std::string, or an InputHandle.
+template <typename B>
+struct is_input_binding
+  : std::integral_constant<bool, std::is_same<typename std::decay<B>::type, char const*>::value ||
+                                   std::is_same<typename std::decay<B>::type, char*>::value ||
+                                   std::is_same<typename std::decay<B>::type, std::string>::value ||
+                                   std::is_same<typename std::decay<B>::type, InputHandle>::value> {
+};
+
 /// This class holds the inputs which  are being processed by the system while
 /// they are  being processed.  The user can  get an instance  for it  via the
 /// ProcessingContext and can use it to retrieve the inputs, either by name or
@@ -108,6 +142,17 @@ public:
 
   int getPos(const char *name) const;
   int getPos(const std::string &name) const;
+  /// @return the position of the input bound to @a handle. The binding is
+  /// resolved again only if the input at the cached position has another
+  /// one, e.g. when the handle is used with a different schema.
+  int getPos(InputHandle const& handle) const
+  {
+    auto pos = handle.mPos;
+    if (pos < 0 || pos >= mInputsSchema.size() || mInputsSchema[pos].matcher.binding != handle.mBinding) {
+      handle.mPos = getPos(handle.mBinding);
+    }
+    return handle.mPos;
+  }
 
   DataRef getByPos(int pos) const {
     if (pos*2 >= mCache.size() || pos < 0) {
@@ -123,11 +168,11 @@ public:
   // a payload bound by @a binding to a known type. This will
   // not be used if the type is a TObject as extra deserialization
   // needs to happen.
-  template <typename T>
+  template <typename T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<is_messageable<T>::value &&
                           std::is_same<T, DataRef>::value == false &&
                           has_root_dictionary<T>::value == false, T>::type const&
-  get(char const* binding) const
+  get(B const& binding) const
   {
     // TODO: check the serialization type, the cast makes only sense for
     // unserialized objects
@@ -138,51 +183,43 @@ public:
   // is meant for C-style strings. If you want to actually get hold of the buffer,
   // use get<DataRef> (or simply get) as that will give you the size as well.
   // FIXME: check that the string is null terminated.
-  template <typename T>
+  template <typename T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<std::is_same<T, char const *>::value, T>::type
-  get(char const *binding) const {
+  get(B const& binding) const {
     return reinterpret_cast<char const *>(get<DataRef>(binding).payload);
   }
 
   // If we ask for a string, we need to duplicate it because we do not want
   // the buffer to be deleted when it goes out of scope.
   // FIXME: check that the string is null terminated.
-  template <typename T>
+  template <typename T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<std::is_same<T, std::string>::value, T>::type
-  get(char const *binding) const {
+  get(B const& binding) const {
     return std::string(get<DataRef>(binding).payload);
   }
 
   // DataRef is special. Since there is no point in storing one in a payload,
   // what it actually does is to return the DataRef used to hold the 
-  // (header, payload) pair.
-  template <typename T = DataRef>
+  // (header, payload) pair. The binding can be either its name or an
+  // InputHandle.
+  template <typename T = DataRef, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<std::is_same<T, DataRef>::value, T>::type
-  get(const char *binding) const {
+  get(B const& binding) const {
     try {
       return getByPos(getPos(binding));
     } catch(...) {
-      throw std::runtime_error("Unknown argument requested" + std::string(binding));
+      throw std::runtime_error("Unknown argument requested " + bindingName(binding));
     }
   }
 
-  // DataRef is special. Since there is no point in storing one in a payload,
-  // what it actually does is to return the DataRef used to hold the 
-  // (header, payload) pair.
-  template <class T = DataRef>
-  typename std::enable_if<std::is_same<T, DataRef>::value, T>::type
-  get(std::string const &binding) const {
-    return getByPos(getPos(binding));
-  }
-
   // Notice that this will return a copy of the actual contents of
   // the buffer, because the buffer is actually serialised, for this
   // reason we return a unique_ptr<T>.
   // FIXME: does it make more sense to keep ownership of all the deserialised 
   // objects in a single place so that we can avoid duplicate deserializations?
-  template <class T>
+  template <class T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::unique_ptr<typename std::enable_if<has_root_dictionary<T>::value == true && is_messageable<T>::value == false, T>::type const>
-  get(char const* binding) const
+  get(B const& binding) const
   {
     using DataHeader = o2::header::DataHeader;
 
@@ -192,12 +229,12 @@ public:
 
   // substitution for messageable objects with ROOT dictionary
   // the operation depends on the transmitted serialization method
-  template <typename T>
+  template <typename T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<is_messageable<T>::value &&
                           std::is_same<T, DataRef>::value == false &&
                           has_root_dictionary<T>::value,
                           std::unique_ptr<T const, Deleter<T const>>>::type
-  get(char const* binding) const
+  get(B const& binding) const
   {
     using DataHeader = o2::header::DataHeader;
 
@@ -224,12 +261,12 @@ public:
   // the operation depends on the transmitted serialization method
   // FIXME: some of the substitutions can for sure be combined when the return types
   // will be unified in a later refactoring
-  template <typename T>
+  template <typename T, typename B, typename = typename std::enable_if<is_input_binding<B>::value>::type>
   typename std::enable_if<is_messageable<T>::value == false &&
                           std::is_same<T, DataRef>::value == false &&
                           has_root_dictionary<T>::value == false,
                           std::unique_ptr<T const, Deleter<T const>>>::type
-  get(char const* binding) const
+  get(B const& binding) const
   {
     using DataHeader = o2::header::DataHeader;
 
@@ -325,6 +362,10 @@ public:
   }
 
 private:
+  static std::string bindingName(char const* binding) { return binding; }
+  static std::string bindingName(std::string const& binding) { return binding; }
+  static std::string bindingName(InputHandle const& handle) { return handle.binding(); }
+
   std::vector<InputRoute> const &mInputsSchema;
   std::vector<std::unique_ptr<FairMQMessage>> const &mCache;
 };
@@ -14,7 +14,9 @@ namespace o2 {
 namespace framework {
 
 /// Possible Lifetime of objects being exchanged by the DPL.
-/// FIXME: currently only Timeframe behaves as expected.
+/// Timeframe objects are processed once, Condition ones are kept by the
+/// receiving device and used for all the timeslices they are valid for.
+/// FIXME: QA and Transient currently behave as Timeframe.
 enum struct Lifetime {
   Timeframe,
   Condition,
@@ -10,10 +10,12 @@
 #ifndef FRAMEWORK_SIMPLEMETRICSSERVICE_H
 #define FRAMEWORK_SIMPLEMETRICSSERVICE_H
 
+#include "Framework/DeviceMetricsInfo.h"
 #include "Framework/MetricsService.h"
 #include "Framework/Variant.h"
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace o2 {
@@ -21,11 +23,35 @@ namespace framework {
 
 /// A simple metrics service which prints out metrics so tha
 /// they can be collected by the driver process.
+///
+/// When a file descriptor is given, numeric metrics are instead written
+/// in binary form on it (see BinaryMetricHeader), so that the driver does
+/// not have to parse them out of the log. Writes never block: if the
+/// driver is not keeping up, metrics are dropped.
 class SimpleMetricsService : public MetricsService{
 public:
+  SimpleMetricsService(int fd = -1);
   void post(const char *label, float value) final;
   void post(const char *label, int value) final;
   void post(const char *label, const char *value) final;
+private:
+  /// @return the id of @a label on the binary channel, registering it
+  /// with the driver if needed, or -1 if the text fallback must be used.
+  int binaryId(const char *label, MetricType type);
+  bool write(const std::string &record);
+
+  struct BinaryMetric {
+    std::string label;
+    MetricType type;
+    bool registered;
+  };
+  int mFd;
+  std::vector<BinaryMetric> mBinaryMetrics;
+  std::map<std::string, int> mIdsByLabel;
+  /// Labels are mostly string literals, so this avoids the lookup by
+  /// content in the common case.
+  std::unordered_map<const char *, int> mIdsByPointer;
+  std::string mRecord;
 };
 
 } // framework
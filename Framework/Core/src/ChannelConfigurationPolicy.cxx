@@ -19,8 +19,11 @@ std::vector<ChannelConfigurationPolicy> ChannelConfigurationPolicy::createDefaul
 {
   ChannelConfigurationPolicy defaultPolicy;
   defaultPolicy.match = ChannelConfigurationPolicyHelpers::matchAny;
-  defaultPolicy.modifyInput = ChannelConfigurationPolicyHelpers::pullInput;
-  defaultPolicy.modifyOutput = ChannelConfigurationPolicyHelpers::pushOutput;
+  // Devices on the same host talk over ipc rather than loopback tcp
+  defaultPolicy.modifyInput =
+    ChannelConfigurationPolicyHelpers::localInput(ChannelConfigurationPolicyHelpers::pullInput, ChannelProtocol::IPC);
+  defaultPolicy.modifyOutput =
+    ChannelConfigurationPolicyHelpers::localOutput(ChannelConfigurationPolicyHelpers::pushOutput, ChannelProtocol::IPC);
   return { defaultPolicy };
 }
 
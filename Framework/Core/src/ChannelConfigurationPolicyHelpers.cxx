@@ -11,6 +11,7 @@
 #include "Framework/ChannelConfigurationPolicyHelpers.h"
 #include <functional>
 #include <string>
+#include <unistd.h>
 #include "Framework/ChannelSpec.h"
 
 namespace o2
@@ -61,5 +62,36 @@ ChannelConfigurationPolicyHelpers::OutputChannelModifier ChannelConfigurationPol
     channel.type = ChannelType::Push;
   };
 
+bool ChannelConfigurationPolicyHelpers::isLocalHost(std::string const& hostname)
+{
+  if (hostname.empty() || hostname == "localhost" || hostname == "127.0.0.1") {
+    return true;
+  }
+  char localHostname[256];
+  if (gethostname(localHostname, sizeof(localHostname)) != 0) {
+    return false;
+  }
+  localHostname[sizeof(localHostname) - 1] = '\0';
+  return hostname == localHostname;
+}
+
+ChannelConfigurationPolicyHelpers::InputChannelModifier
+  ChannelConfigurationPolicyHelpers::localInput(InputChannelModifier modifier, ChannelProtocol protocol)
+{
+  return [modifier, protocol](InputChannelSpec& channel) {
+    modifier(channel);
+    channel.protocol = isLocalHost(channel.hostname) ? protocol : ChannelProtocol::Network;
+  };
+}
+
+ChannelConfigurationPolicyHelpers::OutputChannelModifier
+  ChannelConfigurationPolicyHelpers::localOutput(OutputChannelModifier modifier, ChannelProtocol protocol)
+{
+  return [modifier, protocol](OutputChannelSpec& channel) {
+    modifier(channel);
+    channel.protocol = isLocalHost(channel.hostname) ? protocol : ChannelProtocol::Network;
+  };
+}
+
 } // namespace framework
 } // namespace o2
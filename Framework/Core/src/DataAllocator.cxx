@@ -32,13 +32,22 @@ DataAllocator::DataAllocator(FairMQDevice *device,
 {
 }
 
-std::string
-DataAllocator::matchDataHeader(const Output& spec, size_t timeslice) {
+namespace {
+// Conditions stay valid until a newer version supersedes them, everything
+// else only for the timeslice it was created in.
+DataProcessingHeader::Duration validityOf(OutputRoute const& route)
+{
+  return route.matcher.lifetime == Lifetime::Condition ? 0 : 1;
+}
+}
+
+OutputRoute const&
+DataAllocator::matchDataRoute(const Output& spec, size_t timeslice) {
   // FIXME: we should take timeframeId into account as well.
   for (auto &output : mAllowedOutputRoutes) {
     if (DataSpecUtils::match(output.matcher, spec.origin, spec.description, spec.subSpec)
         && ((timeslice % output.maxTimeslices) == output.timeslice)) {
-      return output.channel;
+      return output;
     }
   }
   std::ostringstream str;
@@ -51,7 +60,8 @@ DataAllocator::matchDataHeader(const Output& spec, size_t timeslice) {
 
 DataChunk
 DataAllocator::newChunk(const Output& spec, size_t size) {
-  std::string channel = matchDataHeader(spec, mContext->timeslice());
+  auto& route = matchDataRoute(spec, mContext->timeslice());
+  std::string const& channel = route.channel;
 
   DataHeader dh;
   dh.dataOrigin = spec.origin;
@@ -60,7 +70,7 @@ DataAllocator::newChunk(const Output& spec, size_t size) {
   dh.payloadSize = size;
   dh.payloadSerializationMethod = o2::header::gSerializationMethodNone;
 
-  DataProcessingHeader dph{mContext->timeslice(), 1};
+  DataProcessingHeader dph{mContext->timeslice(), validityOf(route)};
   //we have to move the incoming data
   o2::header::Stack headerStack{dh, dph};
   FairMQMessagePtr headerMessage = mDevice->NewMessageFor(channel, 0,
@@ -83,19 +93,21 @@ DataAllocator::newChunk(const Output& spec, size_t size) {
 }
 
 DataChunk
-DataAllocator::adoptChunk(const Output& spec, char *buffer, size_t size, fairmq_free_fn *freefn, void *hint = nullptr) {
+DataAllocator::adoptChunk(const Output& spec, char *buffer, size_t size, fairmq_free_fn *freefn, void *hint,
+                          o2::header::SerializationMethod method) {
   // Find a matching channel, create a new message for it and put it in the
   // queue to be sent at the end of the processing
-  std::string channel = matchDataHeader(spec, mContext->timeslice());
+  auto& route = matchDataRoute(spec, mContext->timeslice());
+  std::string const& channel = route.channel;
 
   DataHeader dh;
   dh.dataOrigin = spec.origin;
   dh.dataDescription = spec.description;
   dh.subSpecification = spec.subSpec;
   dh.payloadSize = size;
-  dh.payloadSerializationMethod = o2::header::gSerializationMethodNone;
+  dh.payloadSerializationMethod = method;
 
-  DataProcessingHeader dph{mContext->timeslice(), 1};
+  DataProcessingHeader dph{mContext->timeslice(), validityOf(route)};
   //we have to move the incoming data
   o2::header::Stack headerStack{dh, dph};
   FairMQMessagePtr headerMessage = mDevice->NewMessageFor(channel, 0,
@@ -118,9 +130,54 @@ DataAllocator::adoptChunk(const Output& spec, char *buffer, size_t size, fairmq_
   return DataChunk{reinterpret_cast<char *>(dataPtr), dataSize};
 }
 
+namespace {
+using SharedMessage = std::shared_ptr<FairMQMessage>;
+
+// Free function for the messages referencing the buffer of a shared input
+void releaseSharedMessage(void*, void* hint)
+{
+  delete static_cast<SharedMessage*>(hint);
+}
+}
+
+DataChunk
+DataAllocator::adoptInput(const Output& spec, DataRef const& input) {
+  if (mInputs == nullptr) {
+    throw std::runtime_error("No inputs being processed");
+  }
+  // Headers and payloads alternate, as in the InputRecord. We look for the
+  // header, since an empty payload might not have a buffer.
+  size_t hi = 0;
+  while (hi < mInputs->size() && ((*mInputs)[hi] == nullptr || (*mInputs)[hi]->GetData() != input.header)) {
+    hi += 2;
+  }
+  if (hi + 1 >= mInputs->size() || (*mInputs)[hi + 1] == nullptr) {
+    throw std::runtime_error("Adopted input is not one of the inputs being processed");
+  }
+  auto dh = o2::header::get<DataHeader*>(input.header);
+
+  // The original message is released with the last message referencing its
+  // buffer. The input record gets one of them in place of the original, so
+  // that its DataRefs stay valid and it can still be forwarded. It is created
+  // for the output channel, so that it uses the same transport.
+  auto& channel = matchDataRoute(spec, mContext->timeslice()).channel;
+  auto& payload = (*mInputs)[hi + 1];
+  SharedMessage shared{std::move(payload)};
+  auto buffer = reinterpret_cast<char*>(shared->GetData());
+  auto size = shared->GetSize();
+  std::unique_ptr<SharedMessage> inputHint{new SharedMessage{shared}};
+  payload = mDevice->NewMessageFor(channel, 0, buffer, size, &releaseSharedMessage, inputHint.get());
+  inputHint.release();
+
+  std::unique_ptr<SharedMessage> hint{new SharedMessage{shared}};
+  auto chunk = adoptChunk(spec, buffer, size, &releaseSharedMessage, hint.get(), dh->payloadSerializationMethod);
+  hint.release();
+  return chunk;
+}
+
 FairMQMessagePtr
 DataAllocator::headerMessageFromOutput(Output const &spec,
-                                       std::string const &channel,
+                                       OutputRoute const &route,
                                        o2::header::SerializationMethod method) {
   DataHeader dh;
   dh.dataOrigin = spec.origin;
@@ -131,10 +188,10 @@ DataAllocator::headerMessageFromOutput(Output const &spec,
   dh.payloadSize = 0;
   dh.payloadSerializationMethod = method;
 
-  DataProcessingHeader dph{mContext->timeslice(), 1};
+  DataProcessingHeader dph{mContext->timeslice(), validityOf(route)};
   //we have to move the incoming data
   o2::header::Stack headerStack{dh, dph};
-  FairMQMessagePtr headerMessage = mDevice->NewMessageFor(channel, 0,
+  FairMQMessagePtr headerMessage = mDevice->NewMessageFor(route.channel, 0,
                                                           headerStack.buffer.get(),
                                                           headerStack.bufferSize,
                                                           &o2::header::Stack::freefn,
@@ -148,8 +205,9 @@ DataAllocator::addPartToContext(FairMQMessagePtr&& payloadMessage,
                                 const Output &spec,
                                 o2::header::SerializationMethod serializationMethod)
 {
-    std::string channel = matchDataHeader(spec, mRootContext->timeslice());
-    auto headerMessage = headerMessageFromOutput(spec, channel, serializationMethod);
+    auto& route = matchDataRoute(spec, mRootContext->timeslice());
+    std::string const& channel = route.channel;
+    auto headerMessage = headerMessageFromOutput(spec, route, serializationMethod);
 
     FairMQParts parts;
 
@@ -166,8 +224,9 @@ DataAllocator::addPartToContext(FairMQMessagePtr&& payloadMessage,
 void
 DataAllocator::adopt(const Output &spec, TObject*ptr) {
   std::unique_ptr<TObject> payload(ptr);
-  std::string channel = matchDataHeader(spec, mRootContext->timeslice());
-  auto header = headerMessageFromOutput(spec, channel, o2::header::gSerializationMethodROOT);
+  auto& route = matchDataRoute(spec, mRootContext->timeslice());
+  std::string const& channel = route.channel;
+  auto header = headerMessageFromOutput(spec, route, o2::header::gSerializationMethodROOT);
   mRootContext->addObject(std::move(header), std::move(payload), channel);
   assert(payload.get() == nullptr);
 }
@@ -21,6 +21,7 @@
 #include <TMessage.h>
 #include <TClonesArray.h>
 
+#include <cstring>
 #include <vector>
 #include <memory>
 
@@ -198,9 +199,11 @@ DataProcessingDevice::HandleData(FairMQParts &iParts, int /*index*/) {
 
   // This is needed to convert from a pair of pointers to an actual DataRef
   // and to make sure the ownership is moved from the cache in the relayer to
-  // the execution.
-  auto fillInputs = [&relayer, &inputsSchema, &currentSetOfInputs](int timeslice) -> InputRecord {
+  // the execution. The allocator gets the inputs as well, so that outputs
+  // can share their payloads rather than copy them.
+  auto fillInputs = [&relayer, &inputsSchema, &currentSetOfInputs, &allocator](int timeslice) -> InputRecord {
     currentSetOfInputs = std::move(relayer.getInputsForTimeslice(timeslice));
+    allocator.setInputs(&currentSetOfInputs);
     InputRecord registry{inputsSchema, currentSetOfInputs};
     return registry;
   };
@@ -263,7 +266,7 @@ DataProcessingDevice::HandleData(FairMQParts &iParts, int /*index*/) {
   // the inputs which are shared between this device and others
   // to the next one in the daisy chain.
   // FIXME: do it in a smarter way than O(N^2)
-  auto forwardInputs = [&reportError, &forwards, &device, &currentSetOfInputs]
+  auto forwardInputs = [&reportError, &forwards, &device, &currentSetOfInputs, &relayer]
                        (int timeslice, InputRecord &record) {
     assert(record.size()*2 == currentSetOfInputs.size());
     LOG(DEBUG) << "FORWARDING:START:" << timeslice;
@@ -281,6 +284,14 @@ DataProcessingDevice::HandleData(FairMQParts &iParts, int /*index*/) {
         continue;
       }
 
+      // Conditions are kept by the relayer for the following timeslices,
+      // and the devices downstream keep them as well, so we forward them
+      // only once.
+      if (relayer.isReusedCondition(ii)) {
+        continue;
+      }
+      bool isCondition = input.spec->lifetime == Lifetime::Condition;
+
       auto &header = currentSetOfInputs[ii*2];
       auto &payload = currentSetOfInputs[ii*2+1];
 
@@ -311,8 +322,19 @@ DataProcessingDevice::HandleData(FairMQParts &iParts, int /*index*/) {
           LOG(DEBUG) << "Forwarded timeslice is " << fdph->startTime;
           LOG(DEBUG) << "Forwarded channel is " << forward.channel;
           FairMQParts forwardedParts;
-          forwardedParts.AddPart(std::move(header));
-          forwardedParts.AddPart(std::move(payload));
+          if (isCondition) {
+            // The relayer needs them back, forward a copy.
+            auto copyMessage = [&device, &forward](std::unique_ptr<FairMQMessage> const &message) {
+              auto copy = device.NewMessageFor(forward.channel, 0, message->GetSize());
+              memcpy(copy->GetData(), message->GetData(), message->GetSize());
+              return copy;
+            };
+            forwardedParts.AddPart(copyMessage(header));
+            forwardedParts.AddPart(copyMessage(payload));
+          } else {
+            forwardedParts.AddPart(std::move(header));
+            forwardedParts.AddPart(std::move(payload));
+          }
           assert(forwardedParts.Size() == 2);
           assert(o2::header::get<DataProcessingHeader*>(forwardedParts.At(0)->GetData()));
           LOG(DEBUG) << o2::header::get<DataProcessingHeader*>(forwardedParts.At(0)->GetData())->startTime;
@@ -349,7 +371,9 @@ DataProcessingDevice::HandleData(FairMQParts &iParts, int /*index*/) {
       errorHandling(e, record);
     }
     forwardInputs(cacheline, record);
+    relayer.recycleConditions(currentSetOfInputs);
   }
+  allocator.setInputs(nullptr);
 
   return true;
 }
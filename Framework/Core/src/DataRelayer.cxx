@@ -15,6 +15,9 @@
 #include "Framework/InputRecord.h"
 #include "fairmq/FairMQLogger.h"
 
+#include <algorithm>
+#include <limits>
+
 using DataHeader = o2::header::DataHeader;
 using DataProcessingHeader = o2::framework::DataProcessingHeader;
 
@@ -40,8 +43,35 @@ DataRelayer::DataRelayer(const std::vector<InputRoute> &inputs,
   mMetrics{metrics}
 {
   setPipelineLength(DEFAULT_PIPELINE_LENGTH);
+  mConditions.resize(mInputs.size());
+  mHandedOutConditions.resize(mInputs.size(), -1);
+  mReusedConditions.resize(mInputs.size(), false);
+  // Conditions are kept aside only if there is something else to trigger the
+  // processing of a timeslice. Otherwise they are treated as any other input.
+  bool hasOtherInputs = std::any_of(mInputs.begin(), mInputs.end(), [](InputRoute const &route) {
+    return route.matcher.lifetime != Lifetime::Condition;
+  });
+  for (auto &input : mInputs) {
+    mIsConditionInput.push_back(hasOtherInputs && input.matcher.lifetime == Lifetime::Condition);
+  }
 }
 
+namespace {
+// Returns the index of the version of the condition which is valid for the
+// given timeslice, or -1 if none.
+template <typename V>
+int findConditionVersion(V const &versions, int64_t timeslice) {
+  for (int vi = versions.size() - 1; vi >= 0; --vi) {
+    auto &version = versions[vi];
+    if (version.validFrom > timeslice) {
+      continue;
+    }
+    return timeslice < version.validUntil ? vi : -1;
+  }
+  return -1;
+}
+} // namespace
+
 size_t
 assignInputSpecId(void *data, std::vector<InputRoute> const &routes) {
   for (size_t ri = 0, re = routes.size(); ri < re; ++ri) {
@@ -163,6 +193,30 @@ DataRelayer::relay(std::unique_ptr<FairMQMessage> &&header,
     assert(header.get() == nullptr && payload.get() == nullptr);
   };
 
+  // A Condition is valid from its timeslice on, for its duration or, if
+  // it has none, until a newer version arrives. We keep a few versions, so
+  // that the timeslices in flight can still find the one they need.
+  auto saveCondition = [&header, &payload, &timeslices, &conditions = mConditions](int64_t timeslice, int input) {
+    const DataProcessingHeader* dph = o2::header::get<DataProcessingHeader*>(header->GetData());
+    auto &versions = conditions[input];
+    auto next = std::find_if(versions.begin(), versions.end(), [timeslice](ConditionVersion const &version) {
+      return version.validFrom >= timeslice;
+    });
+    if (next != versions.end() && next->validFrom == timeslice) {
+      return false;
+    }
+    ConditionVersion version;
+    version.part = PartRef{std::move(header), std::move(payload)};
+    version.validFrom = timeslice;
+    version.validUntil = dph->duration ? timeslice + dph->duration : std::numeric_limits<int64_t>::max();
+    version.handedOut = false;
+    versions.insert(next, std::move(version));
+    if (versions.size() > timeslices.size() + 1) {
+      versions.erase(versions.begin());
+    }
+    return true;
+  };
+
   // OUTER LOOP
   // 
   // This is the actual outer loop processing input as part of a given
@@ -181,6 +235,14 @@ DataRelayer::relay(std::unique_ptr<FairMQMessage> &&header,
     return WillNotRelay;
   }
 
+  if (mIsConditionInput[input]) {
+    if (saveCondition(timeslice, input) == false) {
+      LOG(ERROR) << "Got a condition with the same header and timeslice twice!!";
+      return WillNotRelay;
+    }
+    return WillRelay;
+  }
+
   if (isInputFromObsolete(timeslice)) {
     LOG(ERROR) << "An entry for timeslice " << timeslice << " just arrived but too late to be processed";
     return WillNotRelay;
@@ -208,7 +270,14 @@ DataRelayer::getReadyToProcess() {
   //
   // We use this to bail out early from the check as soon as we find something
   // which we know is not complete.
-  auto theLineWillBeIncomplete = [&cache, &inputs](int li, int ai) -> bool {
+  auto theLineWillBeIncomplete = [&cache, &inputs, &isCondition = mIsConditionInput, &conditions = mConditions,
+                                  &timeslices = mTimeslices](int li, int ai) -> bool {
+    // Conditions are looked up among the versions we have, rather than
+    // in the cache line.
+    if (isCondition[ai]) {
+      auto timeslice = timeslices[li].value;
+      return timeslice == INVALID_TIMESLICE || findConditionVersion(conditions[ai], timeslice) == -1;
+    }
     auto &input = cache[li*inputs.size() + ai];
     if (input.header == nullptr || input.payload == nullptr) {
       return true;
@@ -289,9 +358,32 @@ DataRelayer::getInputsForTimeslice(size_t timeslice) {
     timeslices[ti % timeslices.size()] = INVALID_TIMESLICE_ID;
   };
 
+  // Conditions are lent to the processing, recycleConditions gives them
+  // back. We remember which version was used, and if it was already used
+  // before, so that it does not get forwarded twice.
+  auto moveConditionToOutput = [&messages, &conditions = mConditions, &handedOut = mHandedOutConditions,
+                                &reused = mReusedConditions](int64_t timesliceId, size_t arg) {
+    auto &versions = conditions[arg];
+    int vi = findConditionVersion(versions, timesliceId);
+    assert(vi != -1);
+    auto &version = versions[vi];
+    messages.emplace_back(std::move(version.part.header));
+    messages.emplace_back(std::move(version.part.payload));
+    handedOut[arg] = vi;
+    reused[arg] = version.handedOut;
+    version.handedOut = true;
+  };
+
   // Outer loop here.
   jumpToCacheEntryAssociatedWith(timeslice);
+  auto timesliceId = timeslices[timeslice].value;
   for (size_t ai = 0, ae = inputs.size(); ai != ae;  ++ai) {
+    if (mIsConditionInput[ai]) {
+      moveConditionToOutput(timesliceId, ai);
+      continue;
+    }
+    mHandedOutConditions[ai] = -1;
+    mReusedConditions[ai] = false;
     moveHeaderPayloadToOutput(timeslice, ai);
   }
   invalidateCacheFor(timeslice);
@@ -299,6 +391,31 @@ DataRelayer::getInputsForTimeslice(size_t timeslice) {
   return std::move(messages);
 }
 
+void
+DataRelayer::recycleConditions(std::vector<std::unique_ptr<FairMQMessage>> &inputs) {
+  assert(inputs.size() == mInputs.size() * 2);
+  for (size_t ai = 0; ai < mInputs.size(); ++ai) {
+    if (mHandedOutConditions[ai] == -1) {
+      continue;
+    }
+    auto &versions = mConditions[ai];
+    auto &version = versions[mHandedOutConditions[ai]];
+    mHandedOutConditions[ai] = -1;
+    // If someone took ownership of the messages we cannot reuse them.
+    if (inputs[ai * 2].get() == nullptr || inputs[ai * 2 + 1].get() == nullptr) {
+      versions.erase(versions.begin() + (&version - versions.data()));
+      continue;
+    }
+    version.part.header = std::move(inputs[ai * 2]);
+    version.part.payload = std::move(inputs[ai * 2 + 1]);
+  }
+}
+
+bool
+DataRelayer::isReusedCondition(size_t pos) const {
+  return pos < mReusedConditions.size() && mReusedConditions[pos];
+}
+
 size_t
 DataRelayer::getParallelTimeslices() const {
   return mCache.size() / mInputs.size();
@@ -12,8 +12,10 @@
 #include <cassert>
 #include <cinttypes>
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
+#include <ostream>
 #include <regex>
 #include <tuple>
 
@@ -25,10 +27,134 @@ namespace framework {
 //
 // METRIC:<type>:<name>:<timestamp>:<value>
 bool parseMetric(const std::string &s, std::smatch &match) {
+  // Most of the log lines are not metrics, avoid running the regex on them.
+  if (s.find("METRIC:") == std::string::npos) {
+    return false;
+  }
   const static std::regex metricsRE(".*METRIC:(int|float|string):([a-zA-Z0-9/_-]+):([0-9]+):(.*)");
   return std::regex_match(s, match, metricsRE);
 }
 
+namespace {
+// Finds the metric with the given label, creating it if not found.
+// Returns -1 if the metric cannot be created.
+size_t findOrCreateMetric(const std::string &name, MetricType metricType, DeviceMetricsInfo &info)
+{
+  // Find the metric based on the label. Create it if not found.
+  using IndexElement = std::pair<std::string, size_t>;
+  auto cmpFn = [](const IndexElement &a, const IndexElement &b) -> bool {
+    return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+  };
+  IndexElement metricLabelIdx = std::make_pair(name, 0);
+  auto mi = std::lower_bound(info.metricLabelsIdx.begin(),
+                             info.metricLabelsIdx.end(),
+                             metricLabelIdx,
+                             cmpFn);
+
+  if (mi != info.metricLabelsIdx.end()
+      && mi->first == metricLabelIdx.first) {
+    return mi->second;
+  }
+  // We could not find the metric, lets insert a new one.
+  MetricInfo metricInfo;
+  metricInfo.pos = 0;
+  metricInfo.type = metricType;
+  // Add a new empty buffer for it of the correct kind
+  switch(metricType) {
+    case MetricType::Int:
+      metricInfo.storeIdx = info.intMetrics.size();
+      info.intMetrics.emplace_back(METRIC_HISTORY_INITIAL_SIZE, 0);
+      break;
+    case MetricType::Float:
+      metricInfo.storeIdx = info.floatMetrics.size();
+      info.floatMetrics.emplace_back(METRIC_HISTORY_INITIAL_SIZE, 0);
+      break;
+    default:
+      return -1;
+  };
+  // Add the timestamp buffer and the downsampled history for it
+  info.timestamps.emplace_back(METRIC_HISTORY_INITIAL_SIZE, 0);
+  info.summaries.emplace_back();
+
+  // Add the index by name in the correct position
+  // this will require moving the tail of the index,
+  // but inserting should happen only once for each metric,
+  // so who cares.
+  metricLabelIdx.second = info.metrics.size();
+  info.metricLabelsIdx.insert(mi, metricLabelIdx);
+  // Add the the actual Metric info to the store
+  info.metrics.push_back(metricInfo);
+  return metricLabelIdx.second;
+}
+
+// Adds a summary of count points to the tiers, starting from the given
+// one, closing the current summary of a tier when it is complete.
+void summarise(std::array<MetricSummaryTier, METRIC_SUMMARY_TIERS> &tiers, size_t tierIdx,
+               const MetricSummary &summary)
+{
+  size_t tierCount = METRIC_SUMMARY_FACTOR;
+  for (size_t ti = 0; ti < tierIdx; ++ti) {
+    tierCount *= METRIC_SUMMARY_FACTOR;
+  }
+  auto &tier = tiers[tierIdx];
+  auto &current = tier.current;
+  if (current.count == 0) {
+    current = summary;
+  } else {
+    current.min = std::min(current.min, summary.min);
+    current.max = std::max(current.max, summary.max);
+    current.sum += summary.sum;
+    current.count += summary.count;
+  }
+  if (current.count < tierCount) {
+    return;
+  }
+  if (tier.summaries.size() < METRIC_SUMMARY_SIZE) {
+    tier.summaries.push_back(current);
+  } else {
+    tier.summaries[tier.pos] = current;
+  }
+  tier.pos = (tier.pos + 1) % METRIC_SUMMARY_SIZE;
+  if (tierIdx + 1 < tiers.size()) {
+    summarise(tiers, tierIdx + 1, current);
+  }
+  current.count = 0;
+}
+
+// Saves the timestamp for the metric at metricIndex, once its value
+// has been stored, and moves to the next position in the circular buffer,
+// growing the buffers if they are not at their final size yet.
+void advanceMetric(size_t metricIndex, size_t timestamp, float value, DeviceMetricsInfo &info)
+{
+  MetricInfo &metricInfo = info.metrics[metricIndex];
+  auto &timestamps = info.timestamps[metricIndex];
+  timestamps[metricInfo.pos] = timestamp;
+  summarise(info.summaries[metricIndex], 0, MetricSummary{ timestamp, value, value, value, 1 });
+
+  metricInfo.filled = std::min(metricInfo.filled + 1, METRIC_HISTORY_SIZE);
+  metricInfo.pos++;
+  if (metricInfo.pos < timestamps.size()) {
+    return;
+  }
+  if (timestamps.size() == METRIC_HISTORY_SIZE) {
+    metricInfo.pos = 0;
+    return;
+  }
+  auto newSize = std::min(timestamps.size() * 2, METRIC_HISTORY_SIZE);
+  timestamps.resize(newSize, 0);
+  switch (metricInfo.type) {
+    case MetricType::Int:
+      info.intMetrics[metricInfo.storeIdx].resize(newSize, 0);
+      break;
+    case MetricType::Float:
+      info.floatMetrics[metricInfo.storeIdx].resize(newSize, 0);
+      break;
+    default:
+      break;
+  }
+}
+} // namespace
+
 // and fills the appropriatate DeviceInfo plot accordingly.
 //
 // @matches is the regexp_matches from the metric identifying regex
@@ -44,8 +170,6 @@ bool processMetric(const std::smatch &match,
   }
   auto stringValue = match[4];
 
-  size_t metricIndex = -1;
-
   auto metricType = MetricType::Unknown;
   if (type.str() == "int") {
     metricType = MetricType::Int;
@@ -53,59 +177,15 @@ bool processMetric(const std::smatch &match,
     metricType = MetricType::Float;
   }
 
-  // Find the metric based on the label. Create it if not found.
-  using IndexElement = std::pair<std::string, size_t>;
-  auto cmpFn = [](const IndexElement &a, const IndexElement &b) -> bool {
-    return std::tie(a.first, a.second) < std::tie(b.first, b.second);
-  };
-  IndexElement metricLabelIdx = std::make_pair(name.str(), 0);
-  auto mi = std::lower_bound(info.metricLabelsIdx.begin(),
-                             info.metricLabelsIdx.end(),
-                             metricLabelIdx,
-                             cmpFn);
-
-  // We could not find the metric, lets insert a new one.
-  if (mi == info.metricLabelsIdx.end()
-      || mi->first != metricLabelIdx.first) {
-    // Create a new metric
-    MetricInfo metricInfo;
-    metricInfo.pos = 0;
-    metricInfo.type = metricType;
-    // Add a new empty buffer for it of the correct kind
-    switch(metricType) {
-      case MetricType::Int:
-        metricInfo.storeIdx = info.intMetrics.size();
-        info.intMetrics.emplace_back(std::array<int, 1024>{});
-        break;
-      case MetricType::Float:
-        metricInfo.storeIdx = info.floatMetrics.size();
-        info.floatMetrics.emplace_back(std::array<float, 1024>{});
-        break;
-      default:
-        return false;
-    };
-    // Add the timestamp buffer for it
-    info.timestamps.emplace_back(std::array<size_t, 1024>{});
-
-    // Add the index by name in the correct position
-    // this will require moving the tail of the index,
-    // but inserting should happen only once for each metric,
-    // so who cares.
-    metricLabelIdx.second = info.metrics.size();
-    info.metricLabelsIdx.insert(mi, metricLabelIdx);
-    // Add the the actual Metric info to the store
-    metricIndex = info.metrics.size();
-    info.metrics.push_back(metricInfo);
-  } else {
-    metricIndex = mi->second;
+  size_t metricIndex = findOrCreateMetric(name.str(), metricType, info);
+  if (metricIndex == size_t(-1)) {
+    return false;
   }
-  assert(metricIndex != -1);
   // We are now guaranteed our metric is present at metricIndex.
   MetricInfo &metricInfo = info.metrics[metricIndex];
 
   int intValue = 0;
   float floatValue = 0;
-  auto mod = info.timestamps[metricIndex].size();
 
   switch(metricInfo.type) {
     case MetricType::Int:
@@ -114,6 +194,7 @@ bool processMetric(const std::smatch &match,
         return false;
       }
       info.intMetrics[metricInfo.storeIdx][metricInfo.pos] = intValue;
+      floatValue = intValue;
       break;
     case MetricType::Float:
       floatValue = strtof(stringValue.str().c_str(), &ep);
@@ -129,23 +210,163 @@ bool processMetric(const std::smatch &match,
 
   // Save the timestamp for the current metric we do it here
   // so that we do not update timestamps for broken metrics
-  info.timestamps[metricIndex][metricInfo.pos] = timestamp;
-  // Update the position where to write the next metric
-  metricInfo.pos = (metricInfo.pos + 1) % mod;
+  advanceMetric(metricIndex, timestamp, floatValue, info);
   return true;
 }
 
+void encodeMetricRegistration(std::string &buffer, uint16_t id, MetricType type, const char *label)
+{
+  BinaryMetricHeader header;
+  header.kind = BinaryMetricKind::Register;
+  header.type = type;
+  header.id = id;
+  header.size = strlen(label);
+  buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  buffer.append(label, header.size);
+}
+
+void encodeMetricValue(std::string &buffer, uint16_t id, MetricType type, uint64_t timestamp,
+                       BinaryMetricValue value)
+{
+  BinaryMetricHeader header;
+  header.kind = BinaryMetricKind::Value;
+  header.type = type;
+  header.id = id;
+  header.size = sizeof(value);
+  value.timestamp = timestamp;
+  buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Decodes the records sent on the binary metrics channel. Since the
+// channel is a pipe, a read can end in the middle of a record, so
+// whatever is left is kept for the next call.
+bool processBinaryMetrics(const char *data, size_t size, DeviceMetricsInfo &info)
+{
+  if (info.binaryStreamBroken) {
+    return false;
+  }
+  auto &buffer = info.unprocessedBinary;
+  buffer.append(data, size);
+  size_t offset = 0;
+  bool valid = true;
+  while (buffer.size() - offset >= sizeof(BinaryMetricHeader)) {
+    BinaryMetricHeader header;
+    memcpy(&header, buffer.data() + offset, sizeof(header));
+    // A corrupted header cannot be skipped, since its size cannot be
+    // trusted, and waiting for its payload would buffer without limit.
+    bool validRegister = header.kind == BinaryMetricKind::Register && header.size <= MAX_BINARY_METRIC_LABEL;
+    bool validValue = header.kind == BinaryMetricKind::Value && header.size == sizeof(BinaryMetricValue);
+    if (validRegister == false && validValue == false) {
+      info.binaryStreamBroken = true;
+      buffer.clear();
+      return false;
+    }
+    if (buffer.size() - offset - sizeof(header) < header.size) {
+      break;
+    }
+    const char *payload = buffer.data() + offset + sizeof(header);
+    offset += sizeof(header) + header.size;
+
+    if (header.kind == BinaryMetricKind::Register) {
+      size_t metricIndex = findOrCreateMetric(std::string(payload, header.size), header.type, info);
+      if (metricIndex == size_t(-1)) {
+        valid = false;
+        continue;
+      }
+      if (info.binaryIdsIdx.size() <= header.id) {
+        info.binaryIdsIdx.resize(header.id + 1, -1);
+      }
+      info.binaryIdsIdx[header.id] = metricIndex;
+      continue;
+    }
+
+    if (header.id >= info.binaryIdsIdx.size() || info.binaryIdsIdx[header.id] == size_t(-1)) {
+      valid = false;
+      continue;
+    }
+    BinaryMetricValue value;
+    memcpy(&value, payload, sizeof(value));
+    size_t metricIndex = info.binaryIdsIdx[header.id];
+    MetricInfo &metricInfo = info.metrics[metricIndex];
+    if (metricInfo.type != header.type) {
+      valid = false;
+      continue;
+    }
+    float summaryValue = 0;
+    switch (metricInfo.type) {
+      case MetricType::Int:
+        info.intMetrics[metricInfo.storeIdx][metricInfo.pos] = value.intValue;
+        summaryValue = value.intValue;
+        break;
+      case MetricType::Float:
+        info.floatMetrics[metricInfo.storeIdx][metricInfo.pos] = value.floatValue;
+        summaryValue = value.floatValue;
+        break;
+      default:
+        valid = false;
+        continue;
+    }
+    advanceMetric(metricIndex, value.timestamp, summaryValue, info);
+  }
+  buffer.erase(0, offset);
+  return valid;
+}
+
 size_t
 metricIdxByName(const std::string &name, const DeviceMetricsInfo &info) {
-  size_t i = 0;
-  while (i < info.metricLabelsIdx.size()) {
-    auto &metricName = info.metricLabelsIdx[i];
-    if (metricName.first == name) {
-      return metricName.second;
+  // metricLabelsIdx is sorted by label, so we can bisect.
+  auto mi = std::lower_bound(info.metricLabelsIdx.begin(),
+                             info.metricLabelsIdx.end(),
+                             name,
+                             [](const std::pair<std::string, size_t> &a, const std::string &b) {
+                               return a.first < b;
+                             });
+  if (mi == info.metricLabelsIdx.end() || mi->first != name) {
+    return info.metricLabelsIdx.size();
+  }
+  return mi->second;
+}
+
+void dumpMetricsHistory(std::ostream &out, const std::string &device,
+                        const DeviceMetricsInfo &info)
+{
+  for (auto &labelIdx : info.metricLabelsIdx) {
+    auto &metricInfo = info.metrics[labelIdx.second];
+    auto &timestamps = info.timestamps[labelIdx.second];
+    auto &tiers = info.summaries[labelIdx.second];
+    // The downsampled tiers first, as they go further back in time.
+    for (size_t ti = tiers.size(); ti > 0; --ti) {
+      auto &tier = tiers[ti - 1];
+      size_t size = tier.summaries.size();
+      size_t first = size < METRIC_SUMMARY_SIZE ? 0 : tier.pos;
+      for (size_t si = 0; si < size; ++si) {
+        auto &summary = tier.summaries[(first + si) % size];
+        out << device << "," << labelIdx.first << "," << ti - 1 << ","
+            << summary.timestamp << "," << summary.min << "," << summary.max << ","
+            << summary.sum / summary.count << "," << summary.count << "\n";
+      }
+    }
+    size_t size = timestamps.size();
+    size_t first = metricInfo.filled < size ? 0 : metricInfo.pos;
+    for (size_t pi = 0; pi < metricInfo.filled; ++pi) {
+      size_t pos = (first + pi) % size;
+      out << device << "," << labelIdx.first << ",raw," << timestamps[pos] << ",";
+      switch (metricInfo.type) {
+        case MetricType::Int: {
+          auto value = info.intMetrics[metricInfo.storeIdx][pos];
+          out << value << "," << value << "," << value;
+        } break;
+        case MetricType::Float: {
+          auto value = info.floatMetrics[metricInfo.storeIdx][pos];
+          out << value << "," << value << "," << value;
+        } break;
+        default:
+          break;
+      }
+      out << ",1\n";
     }
-    ++i;
   }
-  return i;
 }
 
 } // namespace framework
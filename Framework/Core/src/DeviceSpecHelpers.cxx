@@ -14,6 +14,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <unistd.h>
 #include <unordered_set>
 #include <vector>
 #include "Framework/ChannelConfigurationPolicy.h"
@@ -52,34 +53,46 @@ char const* channelTypeFromEnum(enum ChannelType type)
   }
 }
 
+/// The address of a channel. Local channels use an ipc endpoint named after
+/// the port, so that ports stay the unique identifier of a channel.
+std::string channelAddress(enum ChannelMethod method, enum ChannelProtocol protocol, std::string const& hostname,
+                           unsigned short port)
+{
+  if (protocol != ChannelProtocol::Network) {
+    return "ipc://" + DeviceSpecHelpers::ipcChannelPath(port);
+  }
+  if (method == Bind) {
+    return "tcp://*:" + std::to_string(port);
+  }
+  bool isLocal = ChannelConfigurationPolicyHelpers::isLocalHost(hostname);
+  return "tcp://" + (isLocal ? std::string("127.0.0.1") : hostname) + ":" + std::to_string(port);
+}
+
 /// This creates a string to configure channels of a FairMQDevice
-/// FIXME: support shared memory
-std::string inputChannel2String(const InputChannelSpec& channel)
+std::string channel2String(std::string const& name, enum ChannelType type, enum ChannelMethod method,
+                           enum ChannelProtocol protocol, std::string const& hostname, unsigned short port)
 {
   std::string result;
-  char buffer[32];
-  auto addressFormat = (channel.method == Bind ? "tcp://*:%d" : "tcp://127.0.0.1:%d");
 
-  result += "name=" + channel.name + ",";
-  result += std::string("type=") + channelTypeFromEnum(channel.type) + ",";
-  result += std::string("method=") + (channel.method == Bind ? "bind" : "connect") + ",";
-  result += std::string("address=") + (snprintf(buffer, 32, addressFormat, channel.port), buffer);
+  result += "name=" + name + ",";
+  result += std::string("type=") + channelTypeFromEnum(type) + ",";
+  result += std::string("method=") + (method == Bind ? "bind" : "connect") + ",";
+  result += std::string("address=") + channelAddress(method, protocol, hostname, port);
+  if (protocol == ChannelProtocol::SharedMemory) {
+    result += ",transport=shmem";
+  }
 
   return result;
 }
 
-std::string outputChannel2String(const OutputChannelSpec& channel)
+std::string inputChannel2String(const InputChannelSpec& channel)
 {
-  std::string result;
-  char buffer[32];
-  auto addressFormat = (channel.method == Bind ? "tcp://*:%d" : "tcp://127.0.0.1:%d");
-
-  result += "name=" + channel.name + ",";
-  result += std::string("type=") + channelTypeFromEnum(channel.type) + ",";
-  result += std::string("method=") + (channel.method == Bind ? "bind" : "connect") + ",";
-  result += std::string("address=") + (snprintf(buffer, 32, addressFormat, channel.port), buffer);
+  return channel2String(channel.name, channel.type, channel.method, channel.protocol, channel.hostname, channel.port);
+}
 
-  return result;
+std::string outputChannel2String(const OutputChannelSpec& channel)
+{
+  return channel2String(channel.name, channel.type, channel.method, channel.protocol, channel.hostname, channel.port);
 }
 
 void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices, std::vector<DeviceId>& deviceIndex,
@@ -117,13 +130,16 @@ void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices,
     device.options = processor.options;
     device.rank = processor.rank;
     device.nSlots = processor.nSlots;
+    device.cpuRequirement = processor.cpuRequirement;
+    device.memoryRequirement = processor.memoryRequirement;
     device.inputTimesliceId = edge.timeIndex;
     devices.push_back(device);
     return devices.size() - 1;
   };
 
-  auto channelFromDeviceEdgeAndPort = [&workflow, &channelPolicies](const DeviceSpec& device,
-                                                                    const DeviceConnectionEdge& edge, short port) {
+  auto channelFromDeviceEdgeAndResource = [&workflow, &channelPolicies](const DeviceSpec& device,
+                                                                        const DeviceConnectionEdge& edge,
+                                                                        const ComputingResource& resource) {
     OutputChannelSpec channel;
     auto& consumer = workflow[edge.consumer];
     std::string consumerDeviceId = consumer.name;
@@ -131,7 +147,8 @@ void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices,
       consumerDeviceId += "_t" + std::to_string(edge.timeIndex);
     }
     channel.name = "from_" + device.id + "_to_" + consumerDeviceId;
-    channel.port = port;
+    channel.port = resource.port;
+    channel.hostname = resource.hostname;
     for (auto& policy : channelPolicies) {
       if (policy.match(device.id, consumerDeviceId)) {
         policy.modifyOutput(channel);
@@ -154,7 +171,7 @@ void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices,
   // alredy there) and create a new channel only if it connects two new
   // devices. Whether or not this is the case was previously computed
   // in the action.requiresNewChannel field.
-  auto createChannelForDeviceEdge = [&devices, &logicalEdges, &resources, &channelFromDeviceEdgeAndPort,
+  auto createChannelForDeviceEdge = [&devices, &logicalEdges, &resources, &channelFromDeviceEdgeAndResource,
                                      &connectionIdFromEdgeAndPort, &outputsMatchers, &deviceIndex,
                                      &workflow](size_t di, size_t ei) {
     auto& device = devices[di];
@@ -162,7 +179,7 @@ void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices,
 
     deviceIndex.emplace_back(DeviceId{ edge.producer, edge.producerTimeIndex, di });
 
-    OutputChannelSpec channel = channelFromDeviceEdgeAndPort(device, edge, resources.back().port);
+    OutputChannelSpec channel = channelFromDeviceEdgeAndResource(device, edge, resources.back());
     const DeviceConnectionId& id = connectionIdFromEdgeAndPort(edge, resources.back().port);
     resources.pop_back();
 
@@ -294,6 +311,8 @@ void DeviceSpecHelpers::processInEdgeActions(std::vector<DeviceSpec>& devices,
     device.options = processor.options;
     device.rank = processor.rank;
     device.nSlots = processor.nSlots;
+    device.cpuRequirement = processor.cpuRequirement;
+    device.memoryRequirement = processor.memoryRequirement;
     device.inputTimesliceId = edge.timeIndex;
     // FIXME: maybe I should use an std::map in the end
     //        but this is really not performance critical
@@ -337,6 +356,13 @@ void DeviceSpecHelpers::processInEdgeActions(std::vector<DeviceSpec>& devices,
     InputChannelSpec channel;
     channel.name = "from_" + producerDevice.id + "_to_" + consumerDevice.id;
     channel.port = port;
+    // The host is the one where the producer binds the matching output channel
+    for (auto const& outputChannel : producerDevice.outputChannels) {
+      if (outputChannel.name == channel.name) {
+        channel.hostname = outputChannel.hostname;
+        break;
+      }
+    }
     for (auto& policy : channelPolicies) {
       if (policy.match(producerDevice.id, consumerDevice.id)) {
         policy.modifyInput(channel);
@@ -577,6 +603,30 @@ void DeviceSpecHelpers::prepareArguments(int argc, char** argv, bool defaultQuie
   }
 }
 
+std::string DeviceSpecHelpers::ipcChannelPath(unsigned short port)
+{
+  // The devices are forked by the driver, so they all see the same value,
+  // which is computed before the first fork.
+  static pid_t driverPid = getpid();
+  return "/tmp/o2-dpl-" + std::to_string(driverPid) + "-" + std::to_string(port);
+}
+
+void DeviceSpecHelpers::removeIpcChannels(std::vector<DeviceSpec> const& devices)
+{
+  for (auto& device : devices) {
+    for (auto& channel : device.outputChannels) {
+      if (channel.protocol != ChannelProtocol::Network && channel.method == Bind) {
+        unlink(ipcChannelPath(channel.port).c_str());
+      }
+    }
+    for (auto& channel : device.inputChannels) {
+      if (channel.protocol != ChannelProtocol::Network && channel.method == Bind) {
+        unlink(ipcChannelPath(channel.port).c_str());
+      }
+    }
+  }
+}
+
 boost::program_options::options_description DeviceSpecHelpers::getForwardedDeviceOptions()
 {
   bpo::options_description forwardedDeviceOptions;
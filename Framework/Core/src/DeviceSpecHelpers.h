@@ -89,6 +89,15 @@ struct DeviceSpecHelpers {
   /// return a description of all options to be forwarded to the device
   /// by default
   static boost::program_options::options_description getForwardedDeviceOptions();
+
+  /// The filesystem path of the ipc endpoint of a local channel. It contains
+  /// the pid of the driver, so that two workflows running on the same host
+  /// do not bind the same endpoints.
+  static std::string ipcChannelPath(unsigned short port);
+
+  /// Remove the ipc endpoints of the local channels of the devices,
+  /// to be called by the driver once all the devices are gone.
+  static void removeIpcChannels(std::vector<DeviceSpec> const &devices);
 };
 
 }
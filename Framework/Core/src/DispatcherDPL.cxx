@@ -14,6 +14,11 @@
 /// \author Piotr Konopka, piotr.jan.konopka@cern.ch
 
 #include "Framework/DispatcherDPL.h"
+#include "Framework/DataProcessingHeader.h"
+#include "Framework/MetricsService.h"
+
+#include <chrono>
+#include <functional>
 
 namespace o2
 {
@@ -24,40 +29,42 @@ DispatcherDPL::DispatcherDPL(const SubSpecificationType dispatcherSubSpec, const
                              const InfrastructureConfig& cfg)
   : Dispatcher(dispatcherSubSpec, task, cfg)
 {
-  mDataProcessorSpec.algorithm = AlgorithmSpec{[gen = Dispatcher::BernoulliGenerator(task.fractionOfDataToSample)](
-    ProcessingContext & ctx) mutable { processCallback(ctx, gen);
-}
-};
+  // The seed depends only on the task, so that all its dispatchers sample the same timeslices
+  auto gen = Dispatcher::BernoulliGenerator(task.fractionOfDataToSample, (unsigned int)std::hash<std::string>{}(task.name));
+  mDataProcessorSpec.algorithm = AlgorithmSpec{ [gen, counter = SampledBytesCounter{}](ProcessingContext & ctx) mutable {
+    processCallback(ctx, gen, counter);
+  } };
 }
 
 DispatcherDPL::~DispatcherDPL() {}
 
-void DispatcherDPL::processCallback(ProcessingContext& ctx, BernoulliGenerator& bernoulliGenerator)
+void DispatcherDPL::processCallback(ProcessingContext& ctx, BernoulliGenerator& bernoulliGenerator,
+                                    SampledBytesCounter& counter)
 {
   InputRecord& inputs = ctx.inputs();
+  if (inputs.size() == 0) {
+    return;
+  }
 
-  if (bernoulliGenerator.drawLots()) {
+  // All the inputs belong to the same timeslice, which is sampled or not as a whole
+  const auto* dph = header::get<DataProcessingHeader*>(inputs.getByPos(0).header);
+  if (dph && bernoulliGenerator.drawLots(dph->startTime)) {
     for (auto& input : inputs) {
-
       Output output = createDispatcherOutput(*input.spec);
-
-      const auto* inputHeader = header::get<header::DataHeader*>(input.header);
-
-      /*if (inputHeader->payloadSerializationMethod == header::gSerializationMethodInvalid) {
-        LOG(ERROR) << "DataSampling::dispatcherCallback: input of origin'" << inputHeader->dataOrigin.str
-                   << "', description '" << inputHeader->dataDescription.str
-                   << "' has gSerializationMethodInvalid.";
-      } else*/ if (inputHeader->payloadSerializationMethod == header::gSerializationMethodROOT) {
-        ctx.outputs().adopt(output, DataRefUtils::as<TObject>(input).release());
-      } else { // POD
-        // todo: use API for that when it is available
-        ctx.outputs().adoptChunk(output, const_cast<char*>(input.payload), inputHeader->payloadSize,
-                                 &header::Stack::freefn, nullptr);
-      }
+      // The payload is shared with the input, ROOT objects are sent as they were serialized
+      counter.bytes += ctx.outputs().adoptInput(output, input).size;
 
       LOG(DEBUG) << "DataSampler sends data from subspec " << input.spec->subSpec;
     }
   }
+
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - counter.start).count();
+  if (elapsed >= 1.) {
+    ctx.services().get<MetricsService>().post("dispatcher/sampled_bytes_per_s",
+                                              static_cast<float>(counter.bytes / elapsed));
+    counter = SampledBytesCounter{};
+  }
 }
 
 void DispatcherDPL::addSource(const DataProcessorSpec& externalDataProcessor, const OutputSpec& externalOutput,
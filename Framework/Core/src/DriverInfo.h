@@ -14,6 +14,7 @@
 #include <chrono>
 #include <cstddef>
 #include <map>
+#include <string>
 #include <vector>
 
 #include <csignal>
@@ -81,6 +82,9 @@ struct DriverInfo {
   // Mapping between various pipes and the actual device information.
   // Key is the file description, value is index in the previous vector.
   std::map<int, size_t> socket2DeviceInfo;
+  // Same as above, for the pipes on which the devices send their metrics
+  // in binary form.
+  std::map<int, size_t> metricsSocket2DeviceInfo;
   /// The first unused file descriptor
   int maxFd;
   fd_set childFdset;
@@ -110,6 +114,11 @@ struct DriverInfo {
   unsigned short startPort;
   /// The size of the port range to consider allocated
   unsigned short portRange;
+  /// The NUMA domains of the node to place the devices on, see
+  /// NumaResourceManager. Empty if devices should not be placed.
+  std::string nodeDescription;
+  /// The file where to dump the history of the metrics on exit, if any.
+  std::string metricsDumpFile;
 };
 
 } // namespace framework
@@ -216,7 +216,7 @@ void historyBar(DeviceGUIState& state, const DeviceSpec& spec, const DeviceMetri
       auto getter = [](void* hData, int idx) -> float {
         auto histoData = reinterpret_cast<HistoData<int>*>(hData);
         size_t pos = (histoData->first + static_cast<size_t>(idx)) % histoData->mod;
-        assert(pos >= 0 && pos < 1024);
+        assert(pos >= 0 && pos < METRIC_HISTORY_SIZE);
         return histoData->points[pos];
       };
       ImGui::PlotLines(currentMetricName.c_str(), getter, &data, data.size);
@@ -232,7 +232,7 @@ void historyBar(DeviceGUIState& state, const DeviceSpec& spec, const DeviceMetri
       auto getter = [](void* hData, int idx) -> float {
         auto histoData = reinterpret_cast<HistoData<float>*>(hData);
         size_t pos = (histoData->first + static_cast<size_t>(idx)) % histoData->mod;
-        assert(pos >= 0 && pos < 1024);
+        assert(pos >= 0 && pos < METRIC_HISTORY_SIZE);
         return histoData->points[pos];
       };
       ImGui::PlotLines(currentMetricName.c_str(), getter, &data, data.size);
@@ -287,9 +287,12 @@ void displayDeviceHistograms(const std::vector<DeviceInfo>& infos, const std::ve
         continue;
       }
       auto& metric = metricInfo.metrics[mi];
-      size_t minRangePos = metric.pos % metricInfo.timestamps.size();
-      size_t maxRangePos = (size_t)(metric.pos) - 1 % metricInfo.timestamps.size();
       auto& timestamps = metricInfo.timestamps[mi];
+      if (metric.filled == 0) {
+        continue;
+      }
+      size_t minRangePos = metric.filled < timestamps.size() ? 0 : metric.pos;
+      size_t maxRangePos = (metric.pos + timestamps.size() - 1) % timestamps.size();
       size_t curMinTime = timestamps[minRangePos];
       size_t curMaxTime = timestamps[maxRangePos];
       minTime = minTime < curMinTime ? minTime : curMinTime;
@@ -0,0 +1,187 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "NumaResourceManager.h"
+#include "Framework/DeviceSpec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace o2
+{
+namespace framework
+{
+
+namespace
+{
+/// Parses a cpu list, e.g. "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string& list)
+{
+  std::vector<int> cores;
+  std::istringstream in(list);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    char* ep = nullptr;
+    long first = strtol(range.c_str(), &ep, 10);
+    long last = first;
+    if (ep == range.c_str()) {
+      throw std::runtime_error("Invalid cpu list " + list);
+    }
+    if (*ep == '-') {
+      const char* lastStart = ep + 1;
+      last = strtol(lastStart, &ep, 10);
+      if (ep == lastStart) {
+        throw std::runtime_error("Invalid cpu list " + list);
+      }
+    }
+    if (*ep != '\0' && *ep != '\n') {
+      throw std::runtime_error("Invalid cpu list " + list);
+    }
+    if (first < 0 || last < first) {
+      throw std::runtime_error("Invalid cpu list " + list);
+    }
+    for (long core = first; core <= last; ++core) {
+      cores.push_back(core);
+    }
+  }
+  return cores;
+}
+} // namespace
+
+NodeDescription NumaResourceManager::parseNodeDescription(const std::string& description)
+{
+  NodeDescription node;
+  std::istringstream in(description);
+  std::string domain;
+  while (std::getline(in, domain, ';')) {
+    auto colon = domain.find(':');
+    if (colon == std::string::npos) {
+      throw std::runtime_error("Invalid NUMA domain description " + domain + ", expecting <cpu list>:<memory>");
+    }
+    char* ep = nullptr;
+    auto memoryString = domain.substr(colon + 1);
+    float memory = strtof(memoryString.c_str(), &ep);
+    if (ep == memoryString.c_str() || *ep != '\0' || memory < 0) {
+      throw std::runtime_error("Invalid memory for NUMA domain " + domain);
+    }
+    node.domains.push_back(NumaDomain{ parseCpuList(domain.substr(0, colon)), memory });
+  }
+  if (node.domains.empty()) {
+    throw std::runtime_error("Empty node description");
+  }
+  return node;
+}
+
+NodeDescription NumaResourceManager::systemNodeDescription()
+{
+  NodeDescription node;
+  for (int ni = 0;; ++ni) {
+    std::string nodePath = "/sys/devices/system/node/node" + std::to_string(ni);
+    std::ifstream cpuList(nodePath + "/cpulist");
+    if (!cpuList) {
+      break;
+    }
+    std::string list;
+    std::getline(cpuList, list);
+    // Lines are in the form "Node 0 MemTotal:       16318632 kB"
+    float memory = 0;
+    std::ifstream memInfo(nodePath + "/meminfo");
+    std::string line;
+    while (std::getline(memInfo, line)) {
+      auto pos = line.find("MemTotal:");
+      if (pos != std::string::npos) {
+        memory = strtof(line.c_str() + pos + strlen("MemTotal:"), nullptr) / 1024.f;
+        break;
+      }
+    }
+    node.domains.push_back(NumaDomain{ parseCpuList(list), memory });
+  }
+  if (node.domains.empty() == false) {
+    return node;
+  }
+  // No NUMA information, consider the whole machine as a single domain.
+  NumaDomain domain;
+  domain.cores.resize(std::max(1u, std::thread::hardware_concurrency()));
+  std::iota(domain.cores.begin(), domain.cores.end(), 0);
+  domain.memory = static_cast<float>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE) / (1024.f * 1024.f);
+  node.domains.push_back(domain);
+  return node;
+}
+
+void NumaResourceManager::placeDevices(std::vector<DeviceSpec>& devices)
+{
+  struct DomainState {
+    std::vector<int> freeCores;
+    float freeMemory;
+  };
+  std::vector<DomainState> domains;
+  for (auto& domain : mNode.domains) {
+    domains.push_back(DomainState{ domain.cores, domain.memory });
+  }
+
+  // Place the biggest devices first, so that they get dedicated cores.
+  std::vector<size_t> order;
+  for (size_t di = 0; di < devices.size(); ++di) {
+    devices[di].cpuAffinity.clear();
+    devices[di].numaDomain = -1;
+    if (devices[di].cpuRequirement > 0.f || devices[di].memoryRequirement > 0.f) {
+      order.push_back(di);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&devices](size_t a, size_t b) {
+    return devices[a].cpuRequirement > devices[b].cpuRequirement;
+  });
+
+  for (auto di : order) {
+    auto& device = devices[di];
+    size_t neededCores = std::max<size_t>(1, std::ceil(device.cpuRequirement));
+    // Among the domains which can host the device, pick the least used one.
+    int best = -1;
+    for (size_t ni = 0; ni < domains.size(); ++ni) {
+      auto& domain = domains[ni];
+      if (domain.freeCores.size() < neededCores || domain.freeMemory < device.memoryRequirement) {
+        continue;
+      }
+      if (best == -1 || domain.freeCores.size() > domains[best].freeCores.size()) {
+        best = ni;
+      }
+    }
+    if (best != -1) {
+      auto& freeCores = domains[best].freeCores;
+      device.cpuAffinity.assign(freeCores.begin(), freeCores.begin() + neededCores);
+      freeCores.erase(freeCores.begin(), freeCores.begin() + neededCores);
+    } else {
+      // The node is overcommitted. Share the cores of the domain with the
+      // most memory left, so that at least the memory stays local.
+      best = 0;
+      for (size_t ni = 1; ni < domains.size(); ++ni) {
+        if (domains[ni].freeMemory > domains[best].freeMemory) {
+          best = ni;
+        }
+      }
+      device.cpuAffinity = mNode.domains[best].cores;
+    }
+    domains[best].freeMemory -= device.memoryRequirement;
+    device.numaDomain = best;
+  }
+}
+
+} // namespace framework
+} // namespace o2
@@ -0,0 +1,67 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef FRAMEWORK_NUMARESOURCEMANAGER_H
+#define FRAMEWORK_NUMARESOURCEMANAGER_H
+
+#include "SimpleResourceManager.h"
+
+#include <string>
+#include <vector>
+
+namespace o2
+{
+namespace framework
+{
+
+/// The cores and the memory (in MB) local to a NUMA domain.
+struct NumaDomain {
+  std::vector<int> cores;
+  float memory;
+};
+
+/// Description of the node the devices are deployed on.
+struct NodeDescription {
+  std::vector<NumaDomain> domains;
+};
+
+/// A resource manager which allocates ports as the SimpleResourceManager
+/// does, but also places the devices on the NUMA domains of the node,
+/// based on the cpu and memory requirements declared by their
+/// DataProcessors. Devices with requirements are pinned to dedicated
+/// cores of a single domain, biggest first, so that heavy devices do not
+/// share cores and their memory stays local. Devices without requirements
+/// are left to the OS scheduler.
+class NumaResourceManager : public SimpleResourceManager {
+public:
+  NumaResourceManager(NodeDescription node, short initialPort, short maxPorts = 1000)
+  : SimpleResourceManager{initialPort, maxPorts},
+    mNode{std::move(node)}
+  {}
+  void placeDevices(std::vector<DeviceSpec>& devices) override;
+
+  /// Parses a node description in the form
+  ///
+  /// <cpu list>:<memory in MB>[;<cpu list>:<memory in MB>...]
+  ///
+  /// with one entry per NUMA domain and the cpu list in the same format
+  /// as the kernel one, e.g. "0-3,8-11:16384;4-7,12-15:16384".
+  static NodeDescription parseNodeDescription(const std::string& description);
+  /// Describes the node we are running on, from the kernel NUMA topology
+  /// when available.
+  static NodeDescription systemNodeDescription();
+
+private:
+  NodeDescription mNode;
+};
+
+} // namespace framework
+} // namespace o2
+
+#endif // FRAMEWORK_NUMARESOURCEMANAGER_H
@@ -18,9 +18,15 @@ namespace o2
 namespace framework
 {
 
+struct DeviceSpec;
+
 class ResourceManager {
 public:
+  virtual ~ResourceManager() = default;
   virtual std::vector<ComputingResource> getAvailableResources() = 0;
+  /// Decides where the @a devices should run, e.g. the cores they are
+  /// pinned to. By default devices are left where the OS puts them.
+  virtual void placeDevices(std::vector<DeviceSpec>& devices) {}
 };
 
 } // namespace framework
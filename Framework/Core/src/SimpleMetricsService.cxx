@@ -13,27 +13,115 @@
 #include <chrono>
 
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
 
 namespace o2 {
 namespace framework {
 
+namespace {
+// Labels are registered with a 16 bit id and kept short, anything else
+// goes through the text output.
+constexpr size_t MAX_BINARY_METRICS = 1 << 16;
+// Labels built at runtime have a new address every time, the pointers
+// cache is restarted rather than growing with them.
+constexpr size_t MAX_LABEL_POINTERS = 4096;
+
+uint64_t now()
+{
+  auto now = std::chrono::system_clock::now();
+  return std::chrono::system_clock::to_time_t(now);
+}
+} // namespace
+
+SimpleMetricsService::SimpleMetricsService(int fd)
+  : mFd{ fd }
+{
+}
+
+bool SimpleMetricsService::write(const std::string &record)
+{
+  // Records are smaller than PIPE_BUF, so they are written atomically
+  // or not at all.
+  ssize_t written;
+  do {
+    written = ::write(mFd, record.data(), record.size());
+  } while (written < 0 && errno == EINTR);
+  return written == static_cast<ssize_t>(record.size());
+}
+
+int SimpleMetricsService::binaryId(const char *label, MetricType type)
+{
+  if (mFd < 0) {
+    return -1;
+  }
+  int id = -1;
+  auto pi = mIdsByPointer.find(label);
+  if (pi != mIdsByPointer.end() && mBinaryMetrics[pi->second].label == label) {
+    id = pi->second;
+  } else {
+    auto li = mIdsByLabel.find(label);
+    if (li != mIdsByLabel.end()) {
+      id = li->second;
+    } else {
+      if (mBinaryMetrics.size() >= MAX_BINARY_METRICS || strlen(label) > MAX_BINARY_METRIC_LABEL) {
+        return -1;
+      }
+      id = mBinaryMetrics.size();
+      mBinaryMetrics.push_back(BinaryMetric{ label, type, false });
+      mIdsByLabel.emplace(label, id);
+    }
+    if (mIdsByPointer.size() >= MAX_LABEL_POINTERS) {
+      mIdsByPointer.clear();
+    }
+    mIdsByPointer[label] = id;
+  }
+
+  auto &metric = mBinaryMetrics[id];
+  if (metric.type != type) {
+    return -1;
+  }
+  if (metric.registered == false) {
+    mRecord.clear();
+    encodeMetricRegistration(mRecord, id, type, label);
+    metric.registered = write(mRecord);
+    if (metric.registered == false) {
+      return -1;
+    }
+  }
+  return id;
+}
+
 // All we do is to printout
 void SimpleMetricsService::post(const char *label, float value) {
-  auto now = std::chrono::system_clock::now();
-  auto now_c = std::chrono::system_clock::to_time_t(now);
-  LOG(DEBUG) << "METRIC:float:" << label << ":" << now_c << ":" << value;
+  int id = binaryId(label, MetricType::Float);
+  if (id >= 0) {
+    BinaryMetricValue binaryValue;
+    binaryValue.floatValue = value;
+    mRecord.clear();
+    encodeMetricValue(mRecord, id, MetricType::Float, now(), binaryValue);
+    write(mRecord);
+    return;
+  }
+  LOG(DEBUG) << "METRIC:float:" << label << ":" << now() << ":" << value;
 }
 
 void SimpleMetricsService::post(char const*label, int value) {
-  auto now = std::chrono::system_clock::now();
-  auto now_c = std::chrono::system_clock::to_time_t(now);
-  LOG(DEBUG) << "METRIC:int:" << label << ":" << now_c << ":" << value;
+  int id = binaryId(label, MetricType::Int);
+  if (id >= 0) {
+    BinaryMetricValue binaryValue;
+    binaryValue.intValue = value;
+    mRecord.clear();
+    encodeMetricValue(mRecord, id, MetricType::Int, now(), binaryValue);
+    write(mRecord);
+    return;
+  }
+  LOG(DEBUG) << "METRIC:int:" << label << ":" << now() << ":" << value;
 }
 
 void SimpleMetricsService::post(const char *label, const char *value) {
-  auto now = std::chrono::system_clock::now();
-  auto now_c = std::chrono::system_clock::to_time_t(now);
-  LOG(DEBUG) << "METRIC:string:" << label << ":" << now_c << ":" << value;
+  LOG(DEBUG) << "METRIC:string:" << label << ":" << now() << ":" << value;
 }
 
 } // framework
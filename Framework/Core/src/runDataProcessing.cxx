@@ -35,6 +35,7 @@
 #include "DriverControl.h"
 #include "DriverInfo.h"
 #include "GraphvizHelpers.h"
+#include "NumaResourceManager.h"
 #include "SimpleResourceManager.h"
 
 #include "options/FairMQProgOptions.h"
@@ -44,6 +45,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <regex>
@@ -59,6 +62,7 @@
 #include <sys/types.h>
 #include <sys/un.h>
 #include <sys/wait.h>
+#include <sched.h>
 #include <unistd.h>
 #include <boost/program_options.hpp>
 #include <csignal>
@@ -273,14 +277,17 @@ static void handle_sigchld(int) { sigchld_requested = true; }
 
 /// This will start a new device by forking and executing a
 /// new child
-void spawnDevice(DeviceSpec const& spec, std::map<int, size_t>& socket2DeviceInfo, DeviceControl& control,
+void spawnDevice(DeviceSpec const& spec, std::map<int, size_t>& socket2DeviceInfo,
+                 std::map<int, size_t>& metricsSocket2DeviceInfo, DeviceControl& control,
                  DeviceExecution& execution, std::vector<DeviceInfo>& deviceInfos, int& maxFd, fd_set& childFdset)
 {
   int childstdout[2];
   int childstderr[2];
+  int childmetrics[2];
 
   maxFd = createPipes(maxFd, childstdout);
   maxFd = createPipes(maxFd, childstderr);
+  maxFd = createPipes(maxFd, childmetrics);
 
   // If we have a framework id, it means we have already been respawned
   // and that we are in a child. If not, we need to fork and re-exec, adding
@@ -301,10 +308,36 @@ void spawnDevice(DeviceSpec const& spec, std::map<int, size_t>& socket2DeviceInf
     // and dup2 the write part of the pipe on it. Then we can restart.
     close(childstdout[0]);
     close(childstderr[0]);
+    close(childmetrics[0]);
     close(STDOUT_FILENO);
     close(STDERR_FILENO);
     dup2(childstdout[1], STDOUT_FILENO);
     dup2(childstderr[1], STDERR_FILENO);
+    // The metrics pipe is passed to the SimpleMetricsService of the
+    // device. Posting a metric must never block the processing, so
+    // the device drops metrics rather than waiting for the driver.
+    fcntl(childmetrics[1], F_SETFL, fcntl(childmetrics[1], F_GETFL) | O_NONBLOCK);
+    setenv("O2_DPL_METRICS_FD", std::to_string(childmetrics[1]).c_str(), 1);
+#ifdef __linux__
+    // Pin the device to the cores it was placed on by the ResourceManager.
+    // Memory is then allocated on the local NUMA domain on first touch.
+    if (spec.cpuAffinity.empty() == false) {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      bool validAffinity = true;
+      for (auto core : spec.cpuAffinity) {
+        if (core < 0 || core >= CPU_SETSIZE) {
+          std::cerr << "Core " << core << " is not a valid core, the device affinity is not set" << std::endl;
+          validAffinity = false;
+          break;
+        }
+        CPU_SET(core, &cpuSet);
+      }
+      if (validAffinity && sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == -1) {
+        perror("Unable to set the device affinity");
+      }
+    }
+#endif
     execvp(execution.args[0], execution.args.data());
   }
 
@@ -331,14 +364,47 @@ void spawnDevice(DeviceSpec const& spec, std::map<int, size_t>& socket2DeviceInf
 
   socket2DeviceInfo.insert(std::make_pair(childstdout[0], deviceInfos.size()));
   socket2DeviceInfo.insert(std::make_pair(childstderr[0], deviceInfos.size()));
+  metricsSocket2DeviceInfo.insert(std::make_pair(childmetrics[0], deviceInfos.size()));
   deviceInfos.emplace_back(info);
   // Let's add also metrics information for the given device
   gDeviceMetricsInfos.emplace_back(DeviceMetricsInfo{});
 
   close(childstdout[1]);
   close(childstderr[1]);
+  close(childmetrics[1]);
   FD_SET(childstdout[0], &childFdset);
   FD_SET(childstderr[0], &childFdset);
+  FD_SET(childmetrics[0], &childFdset);
+}
+
+/// Reads the binary metrics sent by a device on its metrics pipe.
+/// @return false if the pipe was closed.
+bool getChildMetrics(int infd, DeviceMetricsInfo& metrics)
+{
+  char buffer[1024 * 16];
+  ssize_t bytes_read;
+  do {
+    bytes_read = read(infd, buffer, sizeof(buffer));
+  } while (bytes_read < 0 && errno == EINTR);
+  if (bytes_read == -1 && errno == EAGAIN) {
+    return true;
+  }
+  if (bytes_read <= 0) {
+    return false;
+  }
+  if (metrics.binaryStreamBroken) {
+    // Keep draining the pipe, so that the device does not block or get a
+    // SIGPIPE, until it exits.
+    return true;
+  }
+  if (processBinaryMetrics(buffer, bytes_read, metrics) == false) {
+    if (metrics.binaryStreamBroken) {
+      LOG(ERROR) << "Corrupted metrics received on fd " << infd << ", ignoring the further metrics of the device";
+    } else {
+      LOG(ERROR) << "Invalid metric received on fd " << infd;
+    }
+  }
+  return true;
 }
 
 void processChildrenOutput(DriverInfo& driverInfo, DeviceInfos& infos, DeviceSpecs const& specs,
@@ -357,6 +423,15 @@ void processChildrenOutput(DriverInfo& driverInfo, DeviceInfos& infos, DeviceSpe
   }
   for (int si = 0; si < driverInfo.maxFd; ++si) {
     if (FD_ISSET(si, &fdset)) {
+      auto mi = driverInfo.metricsSocket2DeviceInfo.find(si);
+      if (mi != driverInfo.metricsSocket2DeviceInfo.end()) {
+        if (!getChildMetrics(si, metricsInfos[mi->second])) {
+          close(si);
+          FD_CLR(si, &driverInfo.childFdset);
+        }
+        --numFd;
+        continue;
+      }
       assert(driverInfo.socket2DeviceInfo.find(si) != driverInfo.socket2DeviceInfo.end());
       auto& info = infos[driverInfo.socket2DeviceInfo[si]];
 
@@ -455,6 +530,23 @@ void processChildrenOutput(DriverInfo& driverInfo, DeviceInfos& infos, DeviceSpe
   //        passed.
 }
 
+/// Writes the metrics history of all the devices to @a filename, for
+/// offline analysis.
+void dumpMetrics(std::string const& filename, DeviceSpecs const& specs,
+                 std::vector<DeviceMetricsInfo> const& metricsInfos)
+{
+  std::ofstream out(filename);
+  if (!out) {
+    LOG(ERROR) << "Unable to open " << filename << " to dump the metrics";
+    return;
+  }
+  out << "device,metric,tier,timestamp,min,max,average,count\n";
+  for (size_t di = 0; di < specs.size() && di < metricsInfos.size(); ++di) {
+    dumpMetricsHistory(out, specs[di].id, metricsInfos[di]);
+  }
+  LOG(INFO) << "Metrics dumped to " << filename;
+}
+
 // Process all the sigchld which are pending
 void processSigChild(DeviceInfos& infos)
 {
@@ -539,7 +631,11 @@ int doChild(int argc, char** argv, const o2::framework::DeviceSpec& spec)
     // We initialise this in the driver, because different drivers might have
     // different versions of the service
     ServiceRegistry serviceRegistry;
-    serviceRegistry.registerService<MetricsService>(new SimpleMetricsService());
+    // The driver passes the pipe on which to send the metrics in the
+    // environment. Without it, e.g. when started by hand, the metrics are
+    // printed out.
+    const char* metricsFd = getenv("O2_DPL_METRICS_FD");
+    serviceRegistry.registerService<MetricsService>(new SimpleMetricsService(metricsFd ? atoi(metricsFd) : -1));
     serviceRegistry.registerService<RootFileService>(new LocalRootFileService());
     serviceRegistry.registerService<ControlService>(new TextControlService());
     serviceRegistry.registerService<ParallelContext>(new ParallelContext(spec.rank, spec.nSlots));
@@ -590,7 +686,20 @@ int runStateMachine(DataProcessorSpecs const& workflow, DriverControl& driverCon
   DeviceInfos infos;
   DeviceControls controls;
   DeviceExecutions deviceExecutions;
-  auto resourceManager = std::make_unique<SimpleResourceManager>(driverInfo.startPort, driverInfo.portRange);
+  std::unique_ptr<ResourceManager> resourceManager;
+  if (driverInfo.nodeDescription.empty()) {
+    resourceManager = std::make_unique<SimpleResourceManager>(driverInfo.startPort, driverInfo.portRange);
+  } else {
+    try {
+      auto node = driverInfo.nodeDescription == "auto"
+                    ? NumaResourceManager::systemNodeDescription()
+                    : NumaResourceManager::parseNodeDescription(driverInfo.nodeDescription);
+      resourceManager = std::make_unique<NumaResourceManager>(node, driverInfo.startPort, driverInfo.portRange);
+    } catch (std::runtime_error& e) {
+      std::cerr << "Invalid node description: " << e.what() << std::endl;
+      return 1;
+    }
+  }
 
   void* window = nullptr;
   decltype(getGUIDebugger(infos, deviceSpecs, metricsInfos, driverInfo, controls, driverControl)) debugGUICallback;
@@ -674,6 +783,7 @@ int runStateMachine(DataProcessorSpecs const& workflow, DriverControl& driverCon
         try {
           std::vector<ComputingResource> resources = resourceManager->getAvailableResources();
           DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, driverInfo.channelPolicies, deviceSpecs, resources);
+          resourceManager->placeDevices(deviceSpecs);
           // This should expand nodes so that we can build a consistent DAG.
         } catch (std::runtime_error& e) {
           std::cerr << "Invalid workflow: " << e.what() << std::endl;
@@ -710,8 +820,8 @@ int runStateMachine(DataProcessorSpecs const& workflow, DriverControl& driverCon
         DeviceSpecHelpers::prepareArguments(driverInfo.argc, driverInfo.argv, driverControl.defaultQuiet,
                                             driverControl.defaultStopped, deviceSpecs, deviceExecutions, controls);
         for (size_t di = 0; di < deviceSpecs.size(); ++di) {
-          spawnDevice(deviceSpecs[di], driverInfo.socket2DeviceInfo, controls[di], deviceExecutions[di], infos,
-                      driverInfo.maxFd, driverInfo.childFdset);
+          spawnDevice(deviceSpecs[di], driverInfo.socket2DeviceInfo, driverInfo.metricsSocket2DeviceInfo, controls[di],
+                      deviceExecutions[di], infos, driverInfo.maxFd, driverInfo.childFdset);
         }
         driverInfo.maxFd += 1;
         assert(infos.empty() == false);
@@ -784,6 +894,11 @@ int runStateMachine(DataProcessorSpecs const& workflow, DriverControl& driverCon
         }
         break;
       case DriverState::EXIT:
+        if (driverInfo.metricsDumpFile.empty() == false) {
+          dumpMetrics(driverInfo.metricsDumpFile, deviceSpecs, metricsInfos);
+        }
+        // The devices are gone, nobody is using their ipc endpoints any longer
+        DeviceSpecHelpers::removeIpcChannels(deviceSpecs);
         return calculateExitCode(infos);
       case DriverState::PERFORM_CALLBACKS:
         for (auto& callback : driverControl.callbacks) {
@@ -877,11 +992,14 @@ int doMain(int argc, char** argv, const o2::framework::WorkflowSpec& workflow,
     ("batch,b", bpo::value<bool>()->zero_tokens()->default_value(false), "batch processing mode")           //
     ("start-port,p", bpo::value<unsigned short>()->default_value(22000), "start port to allocate")          //
     ("port-range,pr", bpo::value<unsigned short>()->default_value(1000), "ports in range")                  //
+    ("node-description", bpo::value<std::string>()->default_value(""),                                       //
+     "NUMA domains to place the devices on, as <cpu list>:<memory MB>[;...], or auto")                      //
     ("completion-policy,c", bpo::value<CompletionPolicy>(&policy)->default_value(CompletionPolicy::QUIT),   //
      "what to do when processing is finished")                                                      //
     ("graphviz,g", bpo::value<bool>()->zero_tokens()->default_value(false), "produce graph output") //
     ("timeout,t", bpo::value<double>()->default_value(0), "timeout after which to exit")            //
-    ("dds,D", bpo::value<bool>()->zero_tokens()->default_value(false), "create DDS configuration");
+    ("dds,D", bpo::value<bool>()->zero_tokens()->default_value(false), "create DDS configuration")  //
+    ("dump-metrics", bpo::value<std::string>()->default_value(""), "file where to dump the metrics on exit");
   // some of the options must be forwarded by default to the device
   executorOptions.add(DeviceSpecHelpers::getForwardedDeviceOptions());
 
@@ -937,6 +1055,8 @@ int doMain(int argc, char** argv, const o2::framework::WorkflowSpec& workflow,
   driverInfo.timeout = varmap["timeout"].as<double>();
   driverInfo.startPort = varmap["start-port"].as<unsigned short>();
   driverInfo.portRange = varmap["port-range"].as<unsigned short>();
+  driverInfo.nodeDescription = varmap["node-description"].as<std::string>();
+  driverInfo.metricsDumpFile = varmap["dump-metrics"].as<std::string>();
 
   std::string frameworkId;
   // If the id is set, this means this is a device,
@@ -0,0 +1,106 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "Framework/WorkflowSpec.h"
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/runDataProcessing.h"
+#include "Framework/DataAllocator.h"
+#include "Framework/InputRecord.h"
+#include "Framework/InputSpec.h"
+#include "Framework/OutputSpec.h"
+#include "Framework/ControlService.h"
+#include "FairMQLogger.h"
+
+using namespace o2::framework;
+
+#define ASSERT_ERROR(condition)                                   \
+  if ((condition) == false) {                                     \
+    LOG(ERROR) << R"(Test condition ")" #condition R"(" failed)"; \
+  }
+
+DataProcessorSpec getTimeoutSpec()
+{
+  // a timer process to terminate the workflow after a timeout
+  auto processingFct = [](ProcessingContext& pc) {
+    static int counter = 0;
+    pc.outputs().snapshot(Output{ "TST", "TIMER", 0, Lifetime::Timeframe }, counter);
+
+    sleep(1);
+    if (counter++ > 10) {
+      LOG(ERROR) << "Timeout reached, the workflow seems to be broken";
+      pc.services().get<ControlService>().readyToQuit(true);
+    }
+  };
+
+  return DataProcessorSpec{ "timer",  // name of the processor
+                            Inputs{}, // inputs empty
+                            { OutputSpec{ "TST", "TIMER", 0, Lifetime::Timeframe } },
+                            AlgorithmSpec(processingFct) };
+}
+
+// The condition is sent only once, it has to stay valid for all the
+// timeslices which follow.
+DataProcessorSpec getConditionSpec()
+{
+  auto processingFct = [](ProcessingContext& pc) {
+    static bool sent = false;
+    if (sent) {
+      return;
+    }
+    pc.outputs().snapshot(Output{ "TST", "COND", 0, Lifetime::Condition }, 42);
+    sent = true;
+  };
+
+  return DataProcessorSpec{ "condition",
+                            Inputs{},
+                            { OutputSpec{ "TST", "COND", 0, Lifetime::Condition } },
+                            AlgorithmSpec(processingFct) };
+}
+
+DataProcessorSpec getSourceSpec()
+{
+  auto processingFct = [](ProcessingContext& pc) {
+    static int counter = 0;
+    pc.outputs().snapshot(Output{ "TST", "DATA", 0, Lifetime::Timeframe }, counter++);
+  };
+
+  return DataProcessorSpec{ "source",
+                            { InputSpec{ "timer", "TST", "TIMER", 0, Lifetime::Timeframe } },
+                            { OutputSpec{ "TST", "DATA", 0, Lifetime::Timeframe } },
+                            AlgorithmSpec(processingFct) };
+}
+
+DataProcessorSpec getSinkSpec()
+{
+  auto processingFct = [](ProcessingContext& pc) {
+    static int counter = 0;
+    auto data = pc.inputs().get<int>("data");
+    auto condition = pc.inputs().get<int>("condition");
+    LOG(INFO) << "data " << data << " with condition " << condition;
+    ASSERT_ERROR(condition == 42);
+    if (++counter == 5) {
+      pc.services().get<ControlService>().readyToQuit(true);
+    }
+  };
+
+  return DataProcessorSpec{ "sink",
+                            { InputSpec{ "data", "TST", "DATA", 0, Lifetime::Timeframe },
+                              InputSpec{ "condition", "TST", "COND", 0, Lifetime::Condition } },
+                            Outputs{},
+                            AlgorithmSpec(processingFct) };
+}
+
+void defineDataProcessing(WorkflowSpec& specs)
+{
+  specs.emplace_back(getTimeoutSpec());
+  specs.emplace_back(getConditionSpec());
+  specs.emplace_back(getSourceSpec());
+  specs.emplace_back(getSinkSpec());
+}
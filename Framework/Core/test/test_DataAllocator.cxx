@@ -123,7 +123,17 @@ DataProcessorSpec getSinkSpec()
     ASSERT_ERROR((*object6.get())[0] == o2::test::Polymorphic(0xaffe));
     ASSERT_ERROR((*object6.get())[1] == o2::test::Polymorphic(0xd00f));
 
-    pc.services().get<ControlService>().readyToQuit(true);
+    // the adopted inputs are sent without copy, and stay valid in the input record
+    auto ref1 = pc.inputs().get("input1");
+    auto chunk1 = pc.outputs().adoptInput(Output{ "TST", "ADOPTED", 0, Lifetime::Timeframe }, ref1);
+    ASSERT_ERROR(chunk1.data == ref1.payload);
+    ASSERT_ERROR(pc.inputs().get("input1").payload == ref1.payload);
+    auto object1again = pc.inputs().get<o2::test::TriviallyCopyable>("input1");
+    ASSERT_ERROR(*object1again == o2::test::TriviallyCopyable(42, 23, 0xdead));
+
+    auto ref4 = pc.inputs().get("input4");
+    auto chunk4 = pc.outputs().adoptInput(Output{ "TST", "ADOPTEDROOT", 0, Lifetime::Timeframe }, ref4);
+    ASSERT_ERROR(chunk4.data == ref4.payload);
   };
 
   return DataProcessorSpec{ "sink", // name of the processor
@@ -133,6 +143,31 @@ DataProcessorSpec getSinkSpec()
                               InputSpec{ "input4", "TST", "ROOTVECTOR", 0, Lifetime::Timeframe },
                               InputSpec{ "input5", "TST", "ROOTSERLZDVEC", 0, Lifetime::Timeframe },
                               InputSpec{ "input6", "TST", "ROOTSERLZDVEC2", 0, Lifetime::Timeframe } },
+                            { OutputSpec{ "TST", "ADOPTED", 0, Lifetime::Timeframe },
+                              OutputSpec{ "TST", "ADOPTEDROOT", 0, Lifetime::Timeframe } },
+                            AlgorithmSpec(processingFct) };
+}
+
+DataProcessorSpec getAdoptedSinkSpec()
+{
+  // the adopted inputs are received after the input record of the sink is gone
+  auto processingFct = [](ProcessingContext& pc) {
+    auto object1 = pc.inputs().get<o2::test::TriviallyCopyable>("adopted");
+    ASSERT_ERROR(*object1 == o2::test::TriviallyCopyable(42, 23, 0xdead));
+
+    // the serialization method of the input is kept
+    auto object4 = pc.inputs().get<std::vector<o2::test::Polymorphic>>("adoptedroot");
+    ASSERT_ERROR(object4 != nullptr);
+    ASSERT_ERROR(object4->size() == 2);
+    ASSERT_ERROR((*object4.get())[0] == o2::test::Polymorphic(0xaffe));
+    ASSERT_ERROR((*object4.get())[1] == o2::test::Polymorphic(0xd00f));
+
+    pc.services().get<ControlService>().readyToQuit(true);
+  };
+
+  return DataProcessorSpec{ "adoptedsink", // name of the processor
+                            { InputSpec{ "adopted", "TST", "ADOPTED", 0, Lifetime::Timeframe },
+                              InputSpec{ "adoptedroot", "TST", "ADOPTEDROOT", 0, Lifetime::Timeframe } },
                             Outputs{},
                             AlgorithmSpec(processingFct) };
 }
@@ -142,4 +177,5 @@ void defineDataProcessing(WorkflowSpec& specs)
   specs.emplace_back(getTimeoutSpec());
   specs.emplace_back(getSourceSpec());
   specs.emplace_back(getSinkSpec());
+  specs.emplace_back(getAdoptedSinkSpec());
 }
@@ -202,3 +202,109 @@ BOOST_AUTO_TEST_CASE(TestCache) {
   BOOST_REQUIRE_EQUAL(result1.size(),2);
   BOOST_REQUIRE_EQUAL(result2.size(),2);
 }
+
+// Conditions are sent only once, and then reused for all the
+// timeslices they are valid for.
+BOOST_AUTO_TEST_CASE(TestConditions) {
+  DummyMetricsService metrics;
+  InputSpec spec1;
+  spec1.binding = "clusters";
+  spec1.description = "CLUSTERS";
+  spec1.origin = "TPC";
+  spec1.subSpec = 0;
+  spec1.lifetime = Lifetime::Timeframe;
+
+  InputSpec spec2;
+  spec2.binding = "pedestals";
+  spec2.description = "PEDESTALS";
+  spec2.origin = "TPC";
+  spec2.subSpec = 0;
+  spec2.lifetime = Lifetime::Condition;
+
+  InputRoute route1;
+  route1.sourceChannel = "Fake";
+  route1.matcher = spec1;
+
+  InputRoute route2;
+  route2.sourceChannel = "Fake";
+  route2.matcher = spec2;
+
+  std::vector<InputRoute> inputs = { route1, route2 };
+  std::vector<ForwardRoute> forwards;
+
+  DataRelayer relayer(inputs, forwards, metrics);
+
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+
+  DataHeader dh1;
+  dh1.dataDescription = "CLUSTERS";
+  dh1.dataOrigin = "TPC";
+  dh1.subSpecification = 0;
+
+  DataHeader dh2;
+  dh2.dataDescription = "PEDESTALS";
+  dh2.dataOrigin = "TPC";
+  dh2.subSpecification = 0;
+
+  auto createMessage = [&transport, &relayer](DataHeader& dh, DataProcessingHeader dph, char value) {
+    Stack stack{ dh, dph };
+    FairMQMessagePtr header = transport->CreateMessage(stack.size());
+    FairMQMessagePtr payload = transport->CreateMessage(1000);
+    memcpy(header->GetData(), stack.data(), stack.size());
+    memset(payload->GetData(), value, 1000);
+    return relayer.relay(std::move(header), std::move(payload));
+  };
+
+  // Process a timeslice, giving back the conditions as the device does.
+  // Returns the first byte of the condition payload.
+  auto process = [&relayer](int cacheline, bool expectReused) -> char {
+    auto result = relayer.getInputsForTimeslice(cacheline);
+    BOOST_REQUIRE_EQUAL(result.size(), 4);
+    BOOST_CHECK(result[2].get() != nullptr);
+    BOOST_CHECK(result[3].get() != nullptr);
+    BOOST_CHECK_EQUAL(relayer.isReusedCondition(0), false);
+    BOOST_CHECK_EQUAL(relayer.isReusedCondition(1), expectReused);
+    char value = static_cast<char*>(result[3]->GetData())[0];
+    relayer.recycleConditions(result);
+    return value;
+  };
+
+  // Without a condition, the timeslice cannot be processed
+  createMessage(dh1, DataProcessingHeader{ 0, 1 }, 0);
+  BOOST_CHECK_EQUAL(relayer.getReadyToProcess().size(), 0);
+
+  // The condition is valid until a newer one arrives
+  BOOST_CHECK_EQUAL(createMessage(dh2, DataProcessingHeader{ 0, 0 }, 1), DataRelayer::WillRelay);
+  auto ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 1);
+  BOOST_CHECK_EQUAL(process(ready[0], false), 1);
+
+  // Following timeslices reuse it, without it being sent again
+  for (size_t ti = 1; ti < 10; ++ti) {
+    createMessage(dh1, DataProcessingHeader{ ti, 1 }, 0);
+    ready = relayer.getReadyToProcess();
+    BOOST_REQUIRE_EQUAL(ready.size(), 1);
+    BOOST_CHECK_EQUAL(process(ready[0], true), 1);
+  }
+
+  // A newer version replaces it from its timeslice on, the timeslices in
+  // flight still use the previous one.
+  createMessage(dh1, DataProcessingHeader{ 10, 1 }, 0);
+  createMessage(dh1, DataProcessingHeader{ 11, 1 }, 0);
+  BOOST_CHECK_EQUAL(createMessage(dh2, DataProcessingHeader{ 11, 2 }, 2), DataRelayer::WillRelay);
+  BOOST_CHECK_EQUAL(createMessage(dh2, DataProcessingHeader{ 11, 2 }, 2), DataRelayer::WillNotRelay);
+  ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 2);
+  for (auto cacheline : ready) {
+    auto timeslice = relayer.getTimesliceForCacheline(cacheline);
+    BOOST_CHECK_EQUAL(process(cacheline, timeslice == 10), timeslice == 10 ? 1 : 2);
+  }
+
+  // The new version is valid for two timeslices only
+  createMessage(dh1, DataProcessingHeader{ 12, 1 }, 0);
+  ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 1);
+  BOOST_CHECK_EQUAL(process(ready[0], true), 2);
+  createMessage(dh1, DataProcessingHeader{ 13, 1 }, 0);
+  BOOST_CHECK_EQUAL(relayer.getReadyToProcess().size(), 0);
+}
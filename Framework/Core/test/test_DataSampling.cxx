@@ -313,3 +313,38 @@ BOOST_AUTO_TEST_CASE(DataSamplingFairMq)
   BOOST_REQUIRE(channelConfig != disp->options.end());
 }
 
+
+// Gives access to the random generator of the dispatchers
+class TestDispatcher : public Dispatcher
+{
+ public:
+  using Dispatcher::BernoulliGenerator;
+};
+
+BOOST_AUTO_TEST_CASE(DataSamplingTimesliceLots)
+{
+  TestDispatcher::BernoulliGenerator generator(0.3, 12345);
+  TestDispatcher::BernoulliGenerator sameSeed(0.3, 12345);
+  TestDispatcher::BernoulliGenerator otherSeed(0.3, 54321);
+
+  // The lots of a timeslice depend only on the seed, all the dispatchers of a task agree
+  size_t sampled = 0, agreeingWithOtherSeed = 0;
+  const size_t timeslices = 100000;
+  for (uint64_t timeslice = 0; timeslice < timeslices; ++timeslice) {
+    bool lots = generator.drawLots(timeslice);
+    BOOST_REQUIRE_EQUAL(lots, generator.drawLots(timeslice));
+    BOOST_REQUIRE_EQUAL(lots, sameSeed.drawLots(timeslice));
+    sampled += lots;
+    agreeingWithOtherSeed += (lots == otherSeed.drawLots(timeslice));
+  }
+  // 0.3 of the timeslices, within about 5 standard deviations
+  BOOST_CHECK_CLOSE(double(sampled) / timeslices, 0.3, 2.5);
+  BOOST_CHECK(agreeingWithOtherSeed < timeslices);
+
+  TestDispatcher::BernoulliGenerator all(1.0, 12345);
+  TestDispatcher::BernoulliGenerator none(0.0, 12345);
+  for (uint64_t timeslice = 0; timeslice < 1000; ++timeslice) {
+    BOOST_CHECK(all.drawLots(timeslice));
+    BOOST_CHECK(!none.drawLots(timeslice));
+  }
+}
@@ -13,8 +13,10 @@
 
 #include "Framework/DeviceMetricsInfo.h"
 #include <boost/test/unit_test.hpp>
+#include <cstring>
 #include <iostream>
 #include <regex>
+#include <sstream>
 
 
 BOOST_AUTO_TEST_CASE(TestDeviceMetricsInfo) {
@@ -118,3 +120,144 @@ BOOST_AUTO_TEST_CASE(TestDeviceMetricsInfo) {
   BOOST_CHECK(metricIdxByName("bkey", info) == 0);
   BOOST_CHECK(metricIdxByName("key3", info) == 2);
 }
+
+BOOST_AUTO_TEST_CASE(TestBinaryMetrics) {
+  using namespace o2::framework;
+  DeviceMetricsInfo info;
+  std::string buffer;
+  BinaryMetricValue value;
+
+  encodeMetricRegistration(buffer, 0, MetricType::Int, "bkey");
+  value.intValue = 12;
+  encodeMetricValue(buffer, 0, MetricType::Int, 1789372894, value);
+  encodeMetricRegistration(buffer, 1, MetricType::Float, "akey");
+  value.floatValue = 16.0;
+  encodeMetricValue(buffer, 1, MetricType::Float, 1789372895, value);
+  value.intValue = 13;
+  encodeMetricValue(buffer, 0, MetricType::Int, 1789372896, value);
+
+  // Feed the records one byte at the time, as if the pipe was
+  // returning partial reads.
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    BOOST_CHECK(processBinaryMetrics(buffer.data() + i, 1, info) == true);
+  }
+  BOOST_CHECK(info.unprocessedBinary.empty());
+  BOOST_CHECK(info.metricLabelsIdx.size() == 2);
+  BOOST_CHECK(info.metrics.size() == 2);
+  BOOST_CHECK(metricIdxByName("bkey", info) == 0);
+  BOOST_CHECK(metricIdxByName("akey", info) == 1);
+  BOOST_CHECK(info.metrics[0].type == MetricType::Int);
+  BOOST_CHECK(info.metrics[0].pos == 2);
+  BOOST_CHECK(info.intMetrics[0][0] == 12);
+  BOOST_CHECK(info.intMetrics[0][1] == 13);
+  BOOST_CHECK(info.timestamps[0][0] == 1789372894);
+  BOOST_CHECK(info.timestamps[0][1] == 1789372896);
+  BOOST_CHECK(info.metrics[1].type == MetricType::Float);
+  BOOST_CHECK(info.metrics[1].pos == 1);
+  BOOST_CHECK(info.floatMetrics[0][0] == 16.0);
+  BOOST_CHECK(info.timestamps[1][0] == 1789372895);
+
+  // The same label as a text metric ends up in the same store
+  std::smatch match;
+  std::string metric = "cjadnjca:METRIC:int:bkey:1789372897:14";
+  BOOST_CHECK(parseMetric(metric, match) == true);
+  BOOST_CHECK(processMetric(match, info) == true);
+  BOOST_CHECK(info.metrics.size() == 2);
+  BOOST_CHECK(info.intMetrics[0][2] == 14);
+
+  // A value for an id which was never registered is rejected
+  buffer.clear();
+  encodeMetricValue(buffer, 5, MetricType::Int, 1789372898, value);
+  BOOST_CHECK(processBinaryMetrics(buffer.data(), buffer.size(), info) == false);
+  BOOST_CHECK(info.unprocessedBinary.empty());
+  BOOST_CHECK(info.metrics[0].pos == 3);
+  BOOST_CHECK(info.binaryStreamBroken == false);
+
+  // A header with an impossible size breaks the channel, rather than
+  // waiting for its payload
+  BinaryMetricHeader header;
+  header.kind = BinaryMetricKind::Value;
+  header.type = MetricType::Int;
+  header.id = 0;
+  header.size = 1 << 30;
+  buffer.assign(reinterpret_cast<const char *>(&header), sizeof(header));
+  BOOST_CHECK(processBinaryMetrics(buffer.data(), buffer.size(), info) == false);
+  BOOST_CHECK(info.binaryStreamBroken == true);
+  BOOST_CHECK(info.unprocessedBinary.empty());
+
+  // and nothing else is processed after that
+  buffer.clear();
+  encodeMetricValue(buffer, 0, MetricType::Int, 1789372899, value);
+  BOOST_CHECK(processBinaryMetrics(buffer.data(), buffer.size(), info) == false);
+  BOOST_CHECK(info.unprocessedBinary.empty());
+  BOOST_CHECK(info.metrics[0].pos == 3);
+}
+
+BOOST_AUTO_TEST_CASE(TestMetricsHistory) {
+  using namespace o2::framework;
+  DeviceMetricsInfo info;
+  std::string buffer;
+  BinaryMetricValue value;
+
+  encodeMetricRegistration(buffer, 0, MetricType::Int, "counter");
+  size_t nPoints = 2 * METRIC_HISTORY_SIZE + 5;
+  for (size_t i = 0; i < nPoints; ++i) {
+    value.intValue = i;
+    encodeMetricValue(buffer, 0, MetricType::Int, 1000 + i, value);
+  }
+  // Only the registration, no value, yet
+  BOOST_CHECK(processBinaryMetrics(buffer.data(), 0, info) == true);
+  size_t registrationSize = sizeof(BinaryMetricHeader) + strlen("counter");
+  BOOST_CHECK(processBinaryMetrics(buffer.data(), registrationSize, info) == true);
+  BOOST_CHECK(info.metrics.size() == 1);
+  BOOST_CHECK(info.timestamps[0].size() == METRIC_HISTORY_INITIAL_SIZE);
+  BOOST_CHECK(info.intMetrics[0].size() == METRIC_HISTORY_INITIAL_SIZE);
+
+  // The buffers grow up to their maximum size, then wrap around
+  size_t valueSize = sizeof(BinaryMetricHeader) + sizeof(BinaryMetricValue);
+  BOOST_CHECK(processBinaryMetrics(buffer.data() + registrationSize, 100 * valueSize, info) == true);
+  BOOST_CHECK(info.timestamps[0].size() == 128);
+  BOOST_CHECK(info.metrics[0].pos == 100);
+  BOOST_CHECK(info.metrics[0].filled == 100);
+  BOOST_CHECK(processBinaryMetrics(buffer.data() + registrationSize + 100 * valueSize,
+                                   buffer.size() - registrationSize - 100 * valueSize, info) == true);
+  BOOST_CHECK(info.timestamps[0].size() == METRIC_HISTORY_SIZE);
+  BOOST_CHECK(info.intMetrics[0].size() == METRIC_HISTORY_SIZE);
+  BOOST_CHECK(info.metrics[0].pos == 5);
+  BOOST_CHECK(info.metrics[0].filled == METRIC_HISTORY_SIZE);
+  BOOST_CHECK(info.intMetrics[0][4] == nPoints - 1);
+  BOOST_CHECK(info.timestamps[0][4] == 1000 + nPoints - 1);
+
+  // Older points are still available in the downsampled tiers
+  auto& tiers = info.summaries[0];
+  BOOST_CHECK(tiers[0].summaries.size() == nPoints / METRIC_SUMMARY_FACTOR);
+  BOOST_CHECK(tiers[0].current.count == nPoints % METRIC_SUMMARY_FACTOR);
+  BOOST_CHECK(tiers[0].summaries[0].timestamp == 1000);
+  BOOST_CHECK(tiers[0].summaries[0].min == 0);
+  BOOST_CHECK(tiers[0].summaries[0].max == METRIC_SUMMARY_FACTOR - 1);
+  BOOST_CHECK(tiers[0].summaries[0].count == METRIC_SUMMARY_FACTOR);
+  size_t tier1Count = METRIC_SUMMARY_FACTOR * METRIC_SUMMARY_FACTOR;
+  BOOST_CHECK(tiers[1].summaries.size() == nPoints / tier1Count);
+  BOOST_CHECK(tiers[1].summaries[1].timestamp == 1000 + tier1Count);
+  BOOST_CHECK(tiers[1].summaries[1].min == tier1Count);
+  BOOST_CHECK(tiers[1].summaries[1].max == 2 * tier1Count - 1);
+  BOOST_CHECK(tiers[1].summaries[1].sum / tier1Count == tier1Count + (tier1Count - 1) / 2.);
+  BOOST_CHECK(tiers[2].summaries.empty());
+
+  std::ostringstream out;
+  dumpMetricsHistory(out, "dev", info);
+  std::istringstream in(out.str());
+  std::string line;
+  size_t lines = 0;
+  std::string firstLine;
+  std::string lastLine;
+  while (std::getline(in, line)) {
+    if (lines++ == 0) {
+      firstLine = line;
+    }
+    lastLine = line;
+  }
+  BOOST_CHECK(lines == tiers[0].summaries.size() + tiers[1].summaries.size() + METRIC_HISTORY_SIZE);
+  BOOST_CHECK(firstLine == "dev,counter,1,1000,0,255,127.5,256");
+  BOOST_CHECK(lastLine == "dev,counter,raw,3052,2052,2052,2052,1");
+}
@@ -19,6 +19,7 @@
 #include "Framework/WorkflowSpec.h"
 #include "../src/SimpleResourceManager.h"
 #include "test_HelperMacros.h"
+#include <unistd.h>
 
 using namespace o2::framework;
 
@@ -61,6 +62,53 @@ BOOST_AUTO_TEST_CASE(TestDeviceSpec1)
   BOOST_CHECK_EQUAL(devices[1].inputs[0].sourceChannel, "from_A_to_B");
 }
 
+// Same as before, checking that the default policy uses ipc
+// for local channels and the network for remote ones.
+BOOST_AUTO_TEST_CASE(TestDeviceSpec1Protocol)
+{
+  auto workflow = defineDataProcessing1();
+  auto channelPolicies = ChannelConfigurationPolicy::createDefaultPolicies();
+  std::vector<DeviceSpec> devices;
+  SimpleResourceManager rm(22000, 1000);
+  auto resources = rm.getAvailableResources();
+  DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, channelPolicies, devices, resources);
+  BOOST_REQUIRE_EQUAL(devices.size(), 2);
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].hostname, "localhost");
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].protocol, IPC);
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].hostname, "localhost");
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].protocol, IPC);
+  // ipc endpoints are private to this driver process
+  auto ipcPath = DeviceSpecHelpers::ipcChannelPath(devices[0].outputChannels[0].port);
+  BOOST_CHECK(ipcPath.find(std::to_string(getpid())) != std::string::npos);
+  BOOST_CHECK(ipcPath != DeviceSpecHelpers::ipcChannelPath(devices[0].outputChannels[0].port + 1));
+
+  devices.clear();
+  std::vector<ComputingResource> remoteResources{ ComputingResource{ 1.0, 1.0, "some.remote.host", 22000 } };
+  DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, channelPolicies, devices, remoteResources);
+  BOOST_REQUIRE_EQUAL(devices.size(), 2);
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].hostname, "some.remote.host");
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].protocol, Network);
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].hostname, "some.remote.host");
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].protocol, Network);
+
+  // Shared memory has to be requested explicitly
+  ChannelConfigurationPolicy shmPolicy;
+  shmPolicy.match = ChannelConfigurationPolicyHelpers::matchAny;
+  shmPolicy.modifyInput =
+    ChannelConfigurationPolicyHelpers::localInput(ChannelConfigurationPolicyHelpers::pullInput, SharedMemory);
+  shmPolicy.modifyOutput =
+    ChannelConfigurationPolicyHelpers::localOutput(ChannelConfigurationPolicyHelpers::pushOutput, SharedMemory);
+  std::vector<ChannelConfigurationPolicy> shmPolicies{ shmPolicy };
+  devices.clear();
+  resources = rm.getAvailableResources();
+  DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, shmPolicies, devices, resources);
+  BOOST_REQUIRE_EQUAL(devices.size(), 2);
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].protocol, SharedMemory);
+  BOOST_CHECK_EQUAL(devices[0].outputChannels[0].type, Push);
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].protocol, SharedMemory);
+  BOOST_CHECK_EQUAL(devices[1].inputChannels[0].type, Pull);
+}
+
 // Same as before, but using PUSH/PULL as policy
 BOOST_AUTO_TEST_CASE(TestDeviceSpec1PushPull)
 {
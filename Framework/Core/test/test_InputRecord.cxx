@@ -115,4 +115,42 @@ BOOST_AUTO_TEST_CASE(TestInputRecord) {
   // A few more time just to make sure we are not stateful..
   BOOST_CHECK_EQUAL(registry.get<int>("x"),1);
   BOOST_CHECK_EQUAL(registry.get<int>("x"),1);
+
+  // Handles are resolved on first use and then give the same inputs
+  InputHandle handleX{"x"};
+  const InputHandle handleY{"y"};
+  InputHandle handleZ{"z"};
+  BOOST_CHECK_EQUAL(registry.getPos(handleX), 0);
+  BOOST_CHECK_EQUAL(registry.getPos(handleY), 1);
+  BOOST_CHECK_EQUAL(registry.get<int>(handleX), 1);
+  BOOST_CHECK_EQUAL(registry.get<int>(handleY), 2);
+  BOOST_CHECK_EQUAL(registry.get(handleY).payload, ref10.payload);
+  BOOST_CHECK_EXCEPTION(registry.get(handleZ), std::exception, any_exception);
+
+  // The same handle used with a different schema is resolved again
+  std::vector<InputRoute> reversedSchema = {
+    createRoute("y_source", spec2),
+    createRoute("x_source", spec1)
+  };
+  InputRecord reversedRegistry(reversedSchema, inputs);
+  BOOST_CHECK_EQUAL(reversedRegistry.getPos(handleX), 1);
+  BOOST_CHECK_EQUAL(reversedRegistry.get<int>(handleX), 2);
+  BOOST_CHECK_EQUAL(registry.get<int>(handleX), 1);
+
+  // even when the other schema is at the same address
+  std::swap(reversedSchema[0], reversedSchema[1]);
+  InputRecord reusedRegistry(reversedSchema, inputs);
+  BOOST_CHECK_EQUAL(reusedRegistry.get<int>(handleY), 2);
+  std::swap(reversedSchema[0], reversedSchema[1]);
+  BOOST_CHECK_EQUAL(reusedRegistry.get<int>(handleY), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestInputBindingTypes) {
+  // Only bindings and handles select the get overloads
+  static_assert(is_input_binding<char[2]>::value, "string literals are bindings");
+  static_assert(is_input_binding<char const*>::value, "C strings are bindings");
+  static_assert(is_input_binding<std::string>::value, "strings are bindings");
+  static_assert(is_input_binding<InputHandle>::value, "handles are bindings");
+  static_assert(is_input_binding<int>::value == false, "positions are not bindings");
+  static_assert(is_input_binding<DataRef>::value == false, "DataRefs are not bindings");
 }
@@ -0,0 +1,75 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#define BOOST_TEST_MODULE Test Framework NumaResourceManager
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "../src/NumaResourceManager.h"
+#include "Framework/DeviceSpec.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace o2::framework;
+
+BOOST_AUTO_TEST_CASE(TestParseNodeDescription)
+{
+  auto node = NumaResourceManager::parseNodeDescription("0-3,8-11:16384;4-7,12-15:8192");
+  BOOST_REQUIRE_EQUAL(node.domains.size(), 2);
+  BOOST_CHECK((node.domains[0].cores == std::vector<int>{ 0, 1, 2, 3, 8, 9, 10, 11 }));
+  BOOST_CHECK((node.domains[1].cores == std::vector<int>{ 4, 5, 6, 7, 12, 13, 14, 15 }));
+  BOOST_CHECK_EQUAL(node.domains[0].memory, 16384);
+  BOOST_CHECK_EQUAL(node.domains[1].memory, 8192);
+
+  BOOST_CHECK_THROW(NumaResourceManager::parseNodeDescription(""), std::runtime_error);
+  BOOST_CHECK_THROW(NumaResourceManager::parseNodeDescription("0-3"), std::runtime_error);
+  BOOST_CHECK_THROW(NumaResourceManager::parseNodeDescription("0-a:1024"), std::runtime_error);
+  BOOST_CHECK_THROW(NumaResourceManager::parseNodeDescription("3-0:1024"), std::runtime_error);
+  BOOST_CHECK_THROW(NumaResourceManager::parseNodeDescription("0-3:lots"), std::runtime_error);
+
+  auto system = NumaResourceManager::systemNodeDescription();
+  BOOST_CHECK(system.domains.empty() == false);
+  BOOST_CHECK(system.domains[0].cores.empty() == false);
+}
+
+BOOST_AUTO_TEST_CASE(TestPlaceDevices)
+{
+  NumaResourceManager manager{ NumaResourceManager::parseNodeDescription("0-3:4096;4-7:4096"), 22000 };
+  std::vector<DeviceSpec> devices(5);
+  devices[0].cpuRequirement = 2;
+  devices[1].cpuRequirement = 4;
+  devices[2].cpuRequirement = 0.5;
+  devices[2].memoryRequirement = 1024;
+  // devices[3] has no requirements
+  devices[4].cpuRequirement = 3;
+  manager.placeDevices(devices);
+
+  // Biggest first, each on the least used domain
+  BOOST_CHECK_EQUAL(devices[1].numaDomain, 0);
+  BOOST_CHECK((devices[1].cpuAffinity == std::vector<int>{ 0, 1, 2, 3 }));
+  BOOST_CHECK_EQUAL(devices[4].numaDomain, 1);
+  BOOST_CHECK((devices[4].cpuAffinity == std::vector<int>{ 4, 5, 6 }));
+  // No room left for two cores, share the domain with most memory left
+  BOOST_CHECK_EQUAL(devices[0].numaDomain, 0);
+  BOOST_CHECK((devices[0].cpuAffinity == std::vector<int>{ 0, 1, 2, 3 }));
+  BOOST_CHECK_EQUAL(devices[2].numaDomain, 1);
+  BOOST_CHECK((devices[2].cpuAffinity == std::vector<int>{ 7 }));
+  BOOST_CHECK_EQUAL(devices[3].numaDomain, -1);
+  BOOST_CHECK(devices[3].cpuAffinity.empty());
+
+  // Memory is taken into account as well
+  std::vector<DeviceSpec> bigDevices(2);
+  bigDevices[0].memoryRequirement = 3072;
+  bigDevices[1].memoryRequirement = 3072;
+  manager.placeDevices(bigDevices);
+  BOOST_CHECK_EQUAL(bigDevices[0].numaDomain, 0);
+  BOOST_CHECK_EQUAL(bigDevices[1].numaDomain, 1);
+}
@@ -0,0 +1,108 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// Measures the throughput of a producer / consumer pair running on the same
+// host, for the different channel protocols. The protocol is selected with
+// the O2_DPL_BENCHMARK_PROTOCOL environment variable, which can be "tcp",
+// "ipc" (the default) or "shmem", e.g.:
+//
+//   O2_DPL_BENCHMARK_PROTOCOL=tcp o2ChannelThroughputBenchmark -b
+//   O2_DPL_BENCHMARK_PROTOCOL=ipc o2ChannelThroughputBenchmark -b
+//
+// The consumer prints the throughput every report-interval messages.
+
+#include "Framework/ChannelConfigurationPolicy.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace o2::framework;
+
+// Needs to be declared before including runDataProcessing.h
+void customize(std::vector<ChannelConfigurationPolicy>& policies)
+{
+  const char* protocolName = getenv("O2_DPL_BENCHMARK_PROTOCOL");
+  ChannelProtocol protocol = ChannelProtocol::IPC;
+  if (protocolName && strcmp(protocolName, "tcp") == 0) {
+    protocol = ChannelProtocol::Network;
+  } else if (protocolName && strcmp(protocolName, "shmem") == 0) {
+    protocol = ChannelProtocol::SharedMemory;
+  }
+
+  ChannelConfigurationPolicy policy;
+  policy.match = ChannelConfigurationPolicyHelpers::matchAny;
+  policy.modifyInput =
+    ChannelConfigurationPolicyHelpers::localInput(ChannelConfigurationPolicyHelpers::pullInput, protocol);
+  policy.modifyOutput =
+    ChannelConfigurationPolicyHelpers::localOutput(ChannelConfigurationPolicyHelpers::pushOutput, protocol);
+  policies.push_back(policy);
+}
+
+#include "Framework/DataRefUtils.h"
+#include "Framework/MetricsService.h"
+#include "Framework/runDataProcessing.h"
+#include "FairMQLogger.h"
+
+using DataHeader = o2::header::DataHeader;
+
+struct ThroughputCounter {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  size_t messages = 0;
+  size_t bytes = 0;
+};
+
+void defineDataProcessing(WorkflowSpec& specs)
+{
+  DataProcessorSpec producer{
+    "producer",
+    Inputs{},
+    { OutputSpec{ { "payload" }, "TST", "PAYLOAD" } },
+    AlgorithmSpec{ [](InitContext& setup) {
+      size_t messageSize = static_cast<size_t>(setup.options().get<int>("message-size")) * 1024 * 1024;
+      return [messageSize](ProcessingContext& ctx) {
+        auto payload = ctx.outputs().make<char>(OutputRef{ "payload" }, messageSize);
+        // Touch the pages, as a real producer would
+        memset(payload.data(), 0, messageSize);
+      };
+    } },
+    { ConfigParamSpec{ "message-size", VariantType::Int, 64, { "size of the messages in MB" } } }
+  };
+
+  DataProcessorSpec consumer{
+    "consumer",
+    { InputSpec{ "payload", "TST", "PAYLOAD" } },
+    Outputs{},
+    AlgorithmSpec{ [](InitContext& setup) {
+      auto counter = std::make_shared<ThroughputCounter>();
+      size_t reportInterval = setup.options().get<int>("report-interval");
+      return [counter, reportInterval](ProcessingContext& ctx) {
+        counter->bytes += DataRefUtils::getPayloadSize(ctx.inputs().get("payload"));
+        if (++counter->messages < reportInterval) {
+          return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - counter->start).count();
+        double throughput = counter->bytes / (1024. * 1024.) / elapsed;
+        LOG(INFO) << "Received " << counter->messages << " messages in " << elapsed << " s: " << throughput
+                  << " MB/s";
+        ctx.services().get<MetricsService>().post("consumer/throughput_mb_per_s", static_cast<float>(throughput));
+        *counter = ThroughputCounter{};
+      };
+    } },
+    { ConfigParamSpec{ "report-interval", VariantType::Int, 100, { "messages between two throughput reports" } } }
+  };
+
+  specs.push_back(producer);
+  specs.push_back(consumer);
+}
@@ -15,14 +15,20 @@
 #include "Framework/ControlService.h"
 #include "Framework/Lifetime.h"
 #include "Headers/DataHeader.h"
+#include "Framework/TMessageSerializer.h"
 #include "Steer/HitProcessingManager.h"
+#include "TPCBase/Sector.h"
+#include "TPCSimulation/Point.h"
 #include <FairMQLogger.h>
 #include <TMessage.h> // object serialization
 #include <memory>     // std::unique_ptr
 #include <cstring>    // memcpy
 #include <string>     // std::string
 #include <cassert>
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <sstream>
 #include <thread>
 
 using namespace o2::framework;
@@ -31,25 +37,97 @@ namespace o2
 {
 namespace steer
 {
-DataProcessorSpec getSimReaderSpec(int fanoutsize)
+// release the reference on a serialized hit buffer held by an outgoing message
+void freeSharedHitBuffer(void* data, void* hint) { delete static_cast<std::shared_ptr<FairTMessage>*>(hint); }
+
+std::string getTPCHitsBranchName(int sector)
+{
+  std::stringstream branchname;
+  branchname << "TPCHitsShiftedSector" << sector;
+  return branchname.str();
+}
+
+DataProcessorSpec getSimReaderSpec(int fanoutsize, const std::vector<int>& tpcsectors)
 {
-  auto doit = [fanoutsize](ProcessingContext& pc) {
+  // the hit branches to be read and, for each, the outputs to which they are sent
+  std::map<int, std::vector<Output>> tpcbranches;
+  for (int subchannel = 0; subchannel < tpcsectors.size(); ++subchannel) {
+    auto sector = tpcsectors[subchannel];
+    auto left = int(o2::TPC::Sector::getLeft(o2::TPC::Sector(sector)));
+    tpcbranches[left].emplace_back(
+      Output{ "TPC", "HITSLEFT", static_cast<SubSpecificationType>(subchannel), Lifetime::Timeframe });
+    tpcbranches[sector].emplace_back(
+      Output{ "TPC", "HITSRIGHT", static_cast<SubSpecificationType>(subchannel), Lifetime::Timeframe });
+  }
+  int ntpcchannels = tpcsectors.size();
+
+  auto doit = [fanoutsize, tpcbranches, ntpcchannels](ProcessingContext& pc) {
     auto& mgr = steer::HitProcessingManager::instance();
-    auto eventrecords = mgr.getRunContext().getEventRecords();
     const auto& context = mgr.getRunContext();
+    const auto& eventrecords = context.getEventRecords();
 
-    // counter to make sure we are sending the data only once
+    // the events are sent in the order of their collision time
+    static std::vector<int> order;
     static int counter = 0;
-    if (counter++ == 0) {
-      // sleep(10);
-      LOG(INFO) << "SENDING " << eventrecords.size() << " records";
+    if (counter == 0) {
+      order.resize(eventrecords.size());
+      for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+      }
+      std::stable_sort(order.begin(), order.end(),
+                       [&eventrecords](int a, int b) { return eventrecords[a].timeNS < eventrecords[b].timeNS; });
 
-      for (int subchannel = 0; subchannel < fanoutsize; ++subchannel) {
+      LOG(INFO) << "SENDING " << eventrecords.size() << " records";
+      for (int subchannel = ntpcchannels; subchannel < fanoutsize; ++subchannel) {
         pc.outputs().snapshot(
           Output{ "SIM", "EVENTTIMES", static_cast<SubSpecificationType>(subchannel), Lifetime::Timeframe }, context);
       }
+    }
+    if (ntpcchannels == 0 || order.empty()) {
+      // nothing to stream, the run context was all
+      if (counter++ == 0) {
+        pc.services().get<ControlService>().readyToQuit(false);
+      }
+      return;
+    }
+    if (counter >= order.size()) {
+      return;
+    }
+
+    auto entry = order[counter++];
+    SimEventInfo info;
+    info.record = eventrecords[entry];
+    info.entry = entry;
+    info.nEvents = order.size();
+    for (int subchannel = 0; subchannel < ntpcchannels; ++subchannel) {
+      pc.outputs().snapshot(
+        Output{ "SIM", "EVENTINFO", static_cast<SubSpecificationType>(subchannel), Lifetime::Timeframe }, info);
+    }
+
+    // one read and one serialization per branch, the buffer is shared by all the outputs
+    static auto hitclass = TClass::GetClass("std::vector<o2::TPC::HitGroup>");
+    for (const auto& branchoutputs : tpcbranches) {
+      auto br = context.getBranch(getTPCHitsBranchName(branchoutputs.first));
+      std::vector<o2::TPC::HitGroup>* hits = nullptr;
+      if (br) {
+        br->SetAddress(&hits);
+        br->GetEntry(entry);
+        br->ResetAddress();
+      } else {
+        LOG(ERROR) << "No branch " << getTPCHitsBranchName(branchoutputs.first) << " found";
+      }
+      std::unique_ptr<std::vector<o2::TPC::HitGroup>> owner(hits ? hits : new std::vector<o2::TPC::HitGroup>());
 
-      // do this only one
+      auto buffer = std::make_shared<FairTMessage>();
+      TMessageSerializer::serialize(*buffer, owner.get(), hitclass);
+      for (const auto& output : branchoutputs.second) {
+        pc.outputs().adoptChunk(output, buffer->Buffer(), buffer->BufferSize(), freeSharedHitBuffer,
+                                new std::shared_ptr<FairTMessage>(buffer), o2::header::gSerializationMethodROOT);
+      }
+    }
+
+    if (counter == order.size()) {
+      // all events sent
       pc.services().get<ControlService>().readyToQuit(false);
     }
   };
@@ -66,7 +144,13 @@ DataProcessorSpec getSimReaderSpec(int fanoutsize)
   };
 
   std::vector<OutputSpec> outputs;
-  for (int subchannel = 0; subchannel < fanoutsize; ++subchannel) {
+  for (int subchannel = 0; subchannel < ntpcchannels; ++subchannel) {
+    auto channel = static_cast<SubSpecificationType>(subchannel);
+    outputs.emplace_back(OutputSpec{ "SIM", "EVENTINFO", channel, Lifetime::Timeframe });
+    outputs.emplace_back(OutputSpec{ "TPC", "HITSLEFT", channel, Lifetime::Timeframe });
+    outputs.emplace_back(OutputSpec{ "TPC", "HITSRIGHT", channel, Lifetime::Timeframe });
+  }
+  for (int subchannel = ntpcchannels; subchannel < fanoutsize; ++subchannel) {
     outputs.emplace_back(
       OutputSpec{ "SIM", "EVENTTIMES", static_cast<SubSpecificationType>(subchannel), Lifetime::Timeframe });
   }
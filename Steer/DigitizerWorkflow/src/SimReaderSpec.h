@@ -12,12 +12,27 @@
 #define O2_STEER_SIMREADERSPEC_H
 
 #include "Framework/DataProcessorSpec.h"
+#include "SimulationDataFormat/MCInteractionRecord.h"
+#include <vector>
 
 namespace o2
 {
 namespace steer
 {
-o2::framework::DataProcessorSpec getSimReaderSpec(int fanoutsize);
+/// information on the event whose hits are sent in a timeslice by the SimReader
+struct SimEventInfo {
+  o2::MCInteractionRecord record; ///< collision time of the event
+  int entry = 0;                  ///< entry of the event in the simulation chain
+  int nEvents = 0;                ///< total number of events sent by the reader
+};
+
+/// The reader sends the events one by one (one timeslice per event) in the order of their collision
+/// time. The TPC digitizers of the given sectors, on the subchannels 0 ... tpcsectors.size() - 1, receive
+/// the event info and the hits of their sector and of its left neighbour; the hits of each sector are
+/// read and serialized only once and the same buffer is sent to all the digitizers needing them.
+/// The other subchannels (up to fanoutsize) receive the run context with all the collision times in the
+/// first timeslice.
+o2::framework::DataProcessorSpec getSimReaderSpec(int fanoutsize, const std::vector<int>& tpcsectors = {});
 }
 }
 
@@ -30,11 +30,13 @@ void defineDataProcessing(WorkflowSpec& specs)
   //
   // specs.emplace_back(o2::steer::getCollisionTimePrinter(fanoutsize++));
 
-  // parallely processing the first 6 TPC sectors
+  // parallely processing the first 6 TPC sectors, the hits are streamed to them by the reader
+  std::vector<int> tpcsectors;
   for (int s = 0; s < 6; ++s) {
     // probably a parallel construct can be used here
     specs.emplace_back(o2::steer::getTPCDriftTimeDigitizer(s, fanoutsize++));
+    tpcsectors.emplace_back(s);
   }
 
-  specs.emplace_back(o2::steer::getSimReaderSpec(fanoutsize));
+  specs.emplace_back(o2::steer::getSimReaderSpec(fanoutsize, tpcsectors));
 }
@@ -9,6 +9,7 @@
 // or submit itself to any jurisdiction.
 
 #include "TPCDriftTimeDigitizerSpec.h"
+#include "SimReaderSpec.h"
 #include <FairMQLogger.h>
 #include <TMessage.h> // object serialization
 #include <cassert>
@@ -31,6 +32,7 @@
 #include "TStopwatch.h"
 #include <sstream>
 #include <algorithm>
+#include <deque>
 
 using namespace o2::framework;
 using SubSpecificationType = o2::framework::DataAllocator::SubSpecificationType;
@@ -39,16 +41,34 @@ namespace o2
 namespace steer
 {
 
-DataProcessorSpec getTPCDriftTimeDigitizer(int sector, int channel, bool cachehits)
+namespace
 {
-  TChain* simChain = new TChain("o2sim");
-  std::stringstream branchnamestreamleft;
-  branchnamestreamleft << "TPCHitsShiftedSector" << int(o2::TPC::Sector::getLeft(o2::TPC::Sector(sector)));
-  std::string branchnameleft = branchnamestreamleft.str();
-  std::stringstream branchnamestreamright;
-  branchnamestreamright << "TPCHitsShiftedSector" << sector;
-  std::string branchnameright = branchnamestreamright.str();
+// state of a TPC digitizer receiving the events one by one
+struct TPCStreamingState {
+  o2::steer::RunContext context;                               // collision times of the received events
+  std::vector<std::vector<o2::TPC::HitGroup>*> hitvectorsleft;  // "TPCHitVector"
+  std::vector<std::vector<o2::TPC::HitGroup>*> hitvectorsright; // "TPCHitVector"
+  std::vector<o2::TPC::TPCHitGroupID> hitidsleft;               // "TPCHitIDs"
+  std::vector<o2::TPC::TPCHitGroupID> hitidsright;              // "TPCHitIDs"
+  std::deque<int> inmemory; // entries of the events in memory, in time order
+  int nreceived = 0;
+  int drift = 1; // next drift time window to digitize
+  std::unique_ptr<TFile> file;
+  std::unique_ptr<TTree> outtree;
+  TStopwatch timer;
+
+  void release(int entry)
+  {
+    delete hitvectorsleft[entry];
+    hitvectorsleft[entry] = nullptr;
+    delete hitvectorsright[entry];
+    hitvectorsright[entry] = nullptr;
+  }
+};
+}
 
+DataProcessorSpec getTPCDriftTimeDigitizer(int sector, int channel, bool cachehits)
+{
   auto digitizertask = std::make_shared<o2::TPC::DigitizerTask>();
   digitizertask->Init2();
   // the task takes the ownership of digit array + mc truth array
@@ -58,106 +78,132 @@ DataProcessorSpec getTPCDriftTimeDigitizer(int sector, int channel, bool cachehi
   auto mcTruthArray = std::make_shared<o2::dataformats::MCTruthContainer<o2::MCCompLabel>>();
   digitizertask->setOutputData(digitArray.get(), mcTruthArray.get());
 
-  auto doit = [simChain, branchnameleft, branchnameright, sector, digitizertask, digitArray,
-               mcTruthArray](ProcessingContext& pc) {
+  // detect number of possible drift times (remember that a drift
+  // time is convenient unit for digit pileup), any multiple of this
+  // unit should also be ok
+  const auto TPCDRIFT = 100000;
+
+  auto state = std::make_shared<TPCStreamingState>();
+
+  // digitize the drift time window of the given index with the events in memory
+  auto digitizeWindow = [sector, digitizertask, state, TPCDRIFT](int drift) {
+    auto starttime = (drift - 1) * TPCDRIFT;
+    auto endtime = drift * TPCDRIFT;
+    LOG(DEBUG) << "STARTTIME " << starttime << " ENDTIME " << endtime;
+    digitizertask->setStartTime(starttime);
+    digitizertask->setEndTime(endtime);
+
+    // the events whose electrons all arrived before this window are not needed anymore
+    while (!state->inmemory.empty() &&
+           o2::TPC::calcDriftTime(state->context.getEventRecords()[state->inmemory.front()].timeNS, 0, 0) < starttime) {
+      state->release(state->inmemory.front());
+      state->inmemory.pop_front();
+    }
+
+    // obtain candidate hit(ids) for this time range
+    state->hitidsleft.clear();
+    state->hitidsright.clear();
+    for (auto entry : state->inmemory) {
+      auto eventtime = state->context.getEventRecords()[entry].timeNS;
+      if (o2::TPC::calcDriftTime(eventtime, 0, 250) > endtime) {
+        break;
+      }
+      o2::TPC::selectHitGroups(*state->hitvectorsleft[entry], entry, eventtime, state->hitidsleft, starttime, endtime,
+                               o2::TPC::calcDriftTime);
+      o2::TPC::selectHitGroups(*state->hitvectorsright[entry], entry, eventtime, state->hitidsright, starttime,
+                               endtime, o2::TPC::calcDriftTime);
+    }
+
+    LOG(DEBUG) << "DRIFTTIME " << drift << " SECTOR " << sector << " : SELECTED LEFT " << state->hitidsleft.size()
+               << " IDs"
+               << " SELECTED RIGHT " << state->hitidsright.size();
+
+    // invoke digitizer if anything to digitize within this drift interval
+    if (state->hitidsleft.size() > 0 || state->hitidsright.size() > 0) {
+      digitizertask->setData(&state->hitvectorsleft, &state->hitvectorsright, &state->hitidsleft,
+                             &state->hitidsright, &state->context);
+      digitizertask->setupSector(sector);
+      digitizertask->Exec2("");
+
+      // write digits + MC truth
+      state->outtree->Fill();
+    }
+  };
+
+  auto doit = [sector, digitArray, mcTruthArray, state, digitizeWindow, TPCDRIFT](ProcessingContext& pc) {
     static int callcounter = 0;
-    callcounter++;
-
-    // ===| open file and register branches |=====================================
-    // this is done at the moment for each worker function invocation
-    // TODO: make this nicer or let the write service be handled outside
-    auto file = std::make_unique<TFile>(Form("tpc_digi_%i_instance%i.root", sector, callcounter), "recreate");
-    auto outtree = std::make_unique<TTree>("o2sim", "TPC digits");
-    outtree->SetDirectory(file.get());
-    auto digitArrayRaw = digitArray.get();
-    auto mcTruthArrayRaw = mcTruthArray.get();
-    auto digitBranch = outtree->Branch(Form("TPCDigit_%i", sector), &digitArrayRaw);
-    auto mcTruthBranch = outtree->Branch(Form("TPCDigitMCTruth_%i", sector), &mcTruthArrayRaw);
-
-    // obtain collision contexts
-    auto dataref = pc.inputs().get("timeinput");
-    auto header = o2::header::get<const o2::header::DataHeader*>(dataref.header);
-
-    auto context = pc.inputs().get<o2::steer::RunContext>("timeinput");
-    auto timesview = context->getEventRecords();
-    LOG(DEBUG) << "GOT " << timesview.size() << " COLLISSION TIMES";
-
-    // if there is nothing ... return
-    if (timesview.size() == 0) {
-      return;
+
+    // the events are received one by one, in the order of their collision time
+    auto& info = pc.inputs().get<o2::steer::SimEventInfo>("eventinfo");
+    if (state->nreceived == 0) {
+      callcounter++;
+      // ===| open file and register branches |=====================================
+      // TODO: make this nicer or let the write service be handled outside
+      state->file = std::make_unique<TFile>(Form("tpc_digi_%i_instance%i.root", sector, callcounter), "recreate");
+      state->outtree = std::make_unique<TTree>("o2sim", "TPC digits");
+      state->outtree->SetDirectory(state->file.get());
+      auto digitArrayRaw = digitArray.get();
+      auto mcTruthArrayRaw = mcTruthArray.get();
+      state->outtree->Branch(Form("TPCDigit_%i", sector), &digitArrayRaw);
+      state->outtree->Branch(Form("TPCDigitMCTruth_%i", sector), &mcTruthArrayRaw);
+
+      state->hitvectorsleft.resize(info.nEvents, nullptr);
+      state->hitvectorsright.resize(info.nEvents, nullptr);
+      state->drift = 1;
+      state->timer.Start();
+    }
+    state->nreceived++;
+    state->context.setEventRecord(info.entry, info.record);
+    auto eventtime = info.record.timeNS;
+
+    // the windows ending before the first electrons of this event can't receive any more hits
+    while (state->drift * TPCDRIFT < o2::TPC::calcDriftTime(eventtime, 0, 250)) {
+      digitizeWindow(state->drift++);
     }
 
-    TStopwatch timer;
-    timer.Start();
+    // take the ownership of the hits of this event (deserialized from the shared reader buffer)
+    using HitGroupVector = std::vector<o2::TPC::HitGroup>;
+    state->hitvectorsleft[info.entry] = DataRefUtils::as<HitGroupVector>(pc.inputs().get("hitsleft")).release();
+    state->hitvectorsright[info.entry] = DataRefUtils::as<HitGroupVector>(pc.inputs().get("hitsright")).release();
+    state->inmemory.push_back(info.entry);
 
-    // detect number of possible drift times (remember that a drift
-    // time is convenient unit for digit pileup), any multiple of this
-    // unit should also be ok
-    const auto TPCDRIFT = 100000;
-    double maxtime = 0;
-    for (auto e : timesview) {
-      maxtime = std::max(maxtime, e.timeNS);
+    if (state->nreceived < info.nEvents) {
+      return;
     }
 
-    // minimum 2 drifts is a safe bet; an electron might
-    // need 1 full drift and might hence land in the second drift time
-    auto ndrifts = 2 + (int)(maxtime / TPCDRIFT);
-
-    std::vector<std::vector<o2::TPC::HitGroup>*> hitvectorsleft;  // "TPCHitVector"
-    std::vector<o2::TPC::TPCHitGroupID> hitidsleft;               // "TPCHitIDs"
-    std::vector<std::vector<o2::TPC::HitGroup>*> hitvectorsright; // "TPCHitVector"
-    std::vector<o2::TPC::TPCHitGroupID> hitidsright;              // "TPCHitIDs"
-    hitvectorsleft.resize(timesview.size(), nullptr);
-    hitvectorsright.resize(timesview.size(), nullptr);
-
-    // have to do a loop over drift times
-    for (int drift = 1; drift <= ndrifts; ++drift) {
-      auto starttime = (drift - 1) * TPCDRIFT;
-      auto endtime = drift * TPCDRIFT;
-      LOG(DEBUG) << "STARTTIME " << starttime << " ENDTIME " << endtime;
-      digitizertask->setStartTime(starttime);
-      digitizertask->setEndTime(endtime);
-
-      // obtain candidate hit(ids) for this time range --> left
-      o2::TPC::getHits(*simChain, timesview, hitvectorsleft, hitidsleft, branchnameleft.c_str(), starttime, endtime,
-                       o2::TPC::calcDriftTime);
-      // --> right
-      o2::TPC::getHits(*simChain, timesview, hitvectorsright, hitidsright, branchnameright.c_str(), starttime, endtime,
-                       o2::TPC::calcDriftTime);
-
-      LOG(DEBUG) << "DRIFTTIME " << drift << " SECTOR " << sector << " : SELECTED LEFT " << hitidsleft.size() << " IDs"
-                 << " SELECTED RIGHT " << hitidsright.size();
-
-      // invoke digitizer if anything to digitize within this drift interval
-      if (hitidsleft.size() > 0 || hitidsright.size() > 0) {
-        digitizertask->setData(&hitvectorsleft, &hitvectorsright, &hitidsleft, &hitidsright, context.get());
-        digitizertask->setupSector(sector);
-        digitizertask->Exec2("");
-
-        // write digits + MC truth
-        outtree->Fill();
-      }
+    // last event: digitize the remaining windows, an electron might need 1 full drift
+    // and might hence land in the next drift time
+    auto ndrifts = 2 + (int)(eventtime / TPCDRIFT);
+    for (; state->drift <= ndrifts; ++state->drift) {
+      digitizeWindow(state->drift);
+    }
+    for (auto entry : state->inmemory) {
+      state->release(entry);
     }
-    outtree->SetDirectory(file.get());
-    file->Write();
-    timer.Stop();
-    LOG(INFO) << "Digitization took " << timer.CpuTime() << "s";
+    state->inmemory.clear();
+    state->nreceived = 0;
+
+    state->outtree->SetDirectory(state->file.get());
+    state->file->Write();
+    state->outtree.reset();
+    state->file.reset();
+    state->timer.Stop();
+    LOG(INFO) << "Digitization took " << state->timer.CpuTime() << "s";
 
     pc.services().get<ControlService>().readyToQuit(false);
   };
 
   // init function return a lambda taking a ProcessingContext
-  auto initIt = [simChain, doit](InitContext& ctx) {
-    // setup the input chain
-    simChain->AddFile("o2sim.root");
-    return doit;
-  };
+  auto initIt = [doit](InitContext& ctx) { return doit; };
 
   std::stringstream id;
   id << "TPCDigitizer" << sector;
   return DataProcessorSpec{
-    id.str().c_str(), Inputs{ InputSpec{ "timeinput", "SIM", "EVENTTIMES", static_cast<SubSpecificationType>(channel),
-                                         Lifetime::Timeframe } },
+    id.str().c_str(),
+    Inputs{ InputSpec{ "eventinfo", "SIM", "EVENTINFO", static_cast<SubSpecificationType>(channel), Lifetime::Timeframe },
+            InputSpec{ "hitsleft", "TPC", "HITSLEFT", static_cast<SubSpecificationType>(channel), Lifetime::Timeframe },
+            InputSpec{ "hitsright", "TPC", "HITSRIGHT", static_cast<SubSpecificationType>(channel),
+                       Lifetime::Timeframe } },
     Outputs{
       // define channel by triple of (origin, type id of data to be sent on this channel, subspecification)
     },
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <cassert>
 
 #include "TChain.h"
 
@@ -37,11 +38,22 @@ class RunContext
 
   int getNEntries() const { return mNofEntries; }
   const std::vector<o2::MCInteractionRecord>& getEventRecords() const { return mEventRecords; }
+
+  /// set the record of an entry, to rebuild the context in a consumer receiving the events one by one
+  void setEventRecord(int entry, const o2::MCInteractionRecord& record)
+  {
+    if (entry >= (int)mEventRecords.size()) {
+      mEventRecords.resize(entry + 1);
+      mNofEntries = mEventRecords.size();
+    }
+    mEventRecords[entry] = record;
+  }
+
  private:
-  int mNofEntries; //!
+  int mNofEntries = 0; //!
   std::vector<o2::MCInteractionRecord> mEventRecords;
   // std::vector<EventIndices> mEvents; // EventIndices (sourceID, chainID, entry ID)
-  TChain* mChain; //! pointer to input chain
+  TChain* mChain = nullptr; //! pointer to input chain
 
   friend class HitProcessingManager;
   ClassDef(RunContext, 1);
@@ -70,8 +82,17 @@ class HitProcessingManager
   void sampleEventTimes();
   void sampleSignalEvents();
 
+  /// Executes the registered run functions, throws a std::runtime_error if any of them failed
   void run();
 
+  /// Number of registered run functions executed concurrently by run(). Each one is then executed in
+  /// its own process, with its own chain (hence branch readers) over the input files, and with gRandom
+  /// seeded from the function index, so that its output files are independent of the scheduling and of
+  /// the other functions. The functions must hence not depend on each other, have to write their results
+  /// to distinct files and close them: the processes exit without running the static destructors.
+  void setNParallelRunFunctions(int n) { mNParallel = n; }
+  int getNParallelRunFunctions() const { return mNParallel; }
+
   void registerRunFunction(RunFunct_t&& f);
 
   void setupRun();
@@ -88,6 +109,7 @@ class HitProcessingManager
   o2::steer::InteractionSampler mInteractionSampler;
 
   TChain mSimChain; // ("o2sim");
+  int mNParallel = 1; // number of run functions executed concurrently
 
   // ClassDefOverride(HitProcessingManager, 0)
 };
@@ -116,15 +138,6 @@ inline void HitProcessingManager::setupRun()
   sampleEventTimes();
 }
 
-inline void HitProcessingManager::run()
-{
-  setupRun();
-  // sample other stuff
-  for (auto& f : mRegisteredRunFunctions) {
-    f(mRunContext);
-  }
-}
-
 template <typename HitType, typename Task_t>
 std::function<void(const o2::steer::RunContext&)> defaultRunFunction(Task_t& task, std::string_view brname)
 {
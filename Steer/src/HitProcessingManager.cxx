@@ -0,0 +1,103 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "Steer/HitProcessingManager.h"
+#include <FairLogger.h>
+#include <TRandom.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace o2::steer;
+
+//_________________________________________________
+void HitProcessingManager::run()
+{
+  setupRun();
+  // sample other stuff
+  if (mNParallel <= 1 || mRegisteredRunFunctions.size() <= 1) {
+    for (auto& f : mRegisteredRunFunctions) {
+      f(mRunContext);
+    }
+    return;
+  }
+
+  // run each function in a forked process, at most mNParallel at a time
+  std::map<pid_t, size_t> running;
+  std::string failed;
+  auto checkStatus = [&failed](size_t index, int status) {
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      LOG(ERROR) << "Run function " << index << " failed" << FairLogger::endl;
+      failed += " " + std::to_string(index);
+    }
+  };
+  // only our own children are waited for, other ones may belong to the caller
+  auto waitOne = [&running, &checkStatus]() {
+    while (true) {
+      for (auto iter = running.begin(); iter != running.end(); ++iter) {
+        int status = 0;
+        auto pid = waitpid(iter->first, &status, WNOHANG);
+        if (pid == iter->first || pid == -1) {
+          checkStatus(iter->second, pid == -1 ? -1 : status);
+          running.erase(iter);
+          return;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  };
+
+  // the seeds of the functions only depend on the state of gRandom when run() is called
+  UInt_t seed = gRandom->Integer(1 << 30) + 1;
+
+  for (size_t index = 0; index < mRegisteredRunFunctions.size(); ++index) {
+    while (running.size() >= (size_t)mNParallel) {
+      waitOne();
+    }
+    // don't let the children flush what is buffered so far
+    std::fflush(nullptr);
+    auto pid = fork();
+    if (pid == -1) {
+      LOG(ERROR) << "Could not fork, executing run function " << index << " in place" << FairLogger::endl;
+      mRegisteredRunFunctions[index](mRunContext);
+      continue;
+    }
+    if (pid == 0) {
+      int status = EXIT_SUCCESS;
+      try {
+        gRandom->SetSeed(seed + index);
+        // the file descriptors of the parent chain are shared with the other processes, use our own
+        setupChain();
+        mRegisteredRunFunctions[index](mRunContext);
+      } catch (std::exception& e) {
+        LOG(ERROR) << "Run function " << index << " failed: " << e.what() << FairLogger::endl;
+        status = EXIT_FAILURE;
+      }
+      // the static destructors and the ROOT teardown belong to the parent
+      std::fflush(nullptr);
+      _exit(status);
+    }
+    running[pid] = index;
+  }
+  while (!running.empty()) {
+    waitOne();
+  }
+
+  if (!failed.empty()) {
+    throw std::runtime_error("Run functions failed:" + failed);
+  }
+}
@@ -0,0 +1,67 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test HitProcessingManager class
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "Steer/HitProcessingManager.h"
+#include <TRandom.h>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace o2
+{
+BOOST_AUTO_TEST_CASE(ParallelRunFunctions)
+{
+  auto& mgr = o2::steer::HitProcessingManager::instance();
+  const int nfunctions = 4;
+  const int failing = 2;
+  // the functions run in child processes, the file names use the pid of the test
+  auto pid = std::to_string(getpid());
+  auto filename = [pid](int index) {
+    return "testHitProcessingManager_" + pid + "_" + std::to_string(index) + ".txt";
+  };
+
+  for (int index = 0; index < nfunctions; ++index) {
+    // each function runs in its own process, the results are exchanged through files
+    mgr.registerRunFunction([index, filename](const o2::steer::RunContext&) {
+      if (index == failing) {
+        throw std::runtime_error("failing on purpose");
+      }
+      std::ofstream out(filename(index));
+      out << gRandom->Rndm();
+    });
+  }
+  mgr.setNParallelRunFunctions(2);
+  BOOST_CHECK_EQUAL(mgr.getNParallelRunFunctions(), 2);
+
+  // the failure of a function is reported to the caller, once the other ones are done
+  BOOST_CHECK_THROW(mgr.run(), std::runtime_error);
+
+  std::set<std::string> randoms;
+  for (int index = 0; index < nfunctions; ++index) {
+    std::ifstream in(filename(index));
+    BOOST_CHECK_EQUAL(in.good(), index != failing);
+    if (in.good()) {
+      std::string random;
+      in >> random;
+      randoms.insert(random);
+    }
+    std::remove(filename(index).c_str());
+  }
+  // every function has its own random seed
+  BOOST_CHECK_EQUAL(randoms.size(), nfunctions - 1);
+}
+} // namespace o2
@@ -12,22 +12,58 @@
 #define ALICEO2_DEVICES_EPNRECEIVER_H_
 
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <mutex>
 #include <chrono>
 
 #include <FairMQDevice.h>
 
+#include "TimeFrame/TimeFrame.h"
+
 namespace o2 {
 namespace Devices {
 
-/// Container for (sub-)timeframes
+/// Pool of the timeframe index buffers. The buffers are given back to the
+/// pool by the transport once the index message has been sent, so that
+/// assembling a timeframe does not allocate its index.
+
+class TimeframeIndexPool : public std::enable_shared_from_this<TimeframeIndexPool>
+{
+  public:
+    struct Index
+    {
+      std::vector<o2::DataFormat::IndexElement> elements;
+      std::weak_ptr<TimeframeIndexPool> pool;
+    };
+
+    /// Returns an empty index, allocated only when the pool has none left
+    std::unique_ptr<Index> acquire();
 
-struct TFBuffer
+    /// FairMQ free function of the index messages, \p hint is the Index
+    static void release(void* data, void* hint);
+
+  private:
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<Index>> mFreeIndices;
+};
+
+/// Slot of the ring in which a timeframe is assembled
+
+struct TimeframeSlot
 {
+  /// A closed slot (published or discarded) keeps the ID of its timeframe, so that late parts are dropped
+  enum class State { Free, Assembling, Published, Discarded };
+
+  State state = State::Free;
+  uint16_t id = 0;
   FairMQParts parts;
+  std::vector<uint64_t> receivedFLPs; ///< Bitmask of the FLPs whose sub-timeframe was received
+  int numReceivedFLPs = 0;
+  std::unique_ptr<TimeframeIndexPool::Index> index;
   std::chrono::steady_clock::time_point start;
-  std::chrono::steady_clock::time_point end;
+  int previous = -1; ///< Previous assembling slot, in the order of the first received part
+  int next = -1;     ///< Next assembling slot, in the order of the first received part
 };
 
 /// Receives sub-timeframes from the flpSenders and merges these into full timeframes.
@@ -36,11 +72,11 @@ class EPNReceiverDevice : public FairMQDevice
 {
   public:
     EPNReceiverDevice() = default;
-    ~EPNReceiverDevice() final = default;
+    ~EPNReceiverDevice() override = default;
     void InitTask() final;
 
-    /// Prints the contents of the timeframe container
-    void PrintBuffer(const std::unordered_map<uint16_t, TFBuffer> &buffer) const;
+    /// Prints the contents of the timeframe slots
+    void PrintBuffer() const;
 
     /// Discared incomplete timeframes after \p fBufferTimeoutInMs.
     void DiscardIncompleteTimeframes();
@@ -49,11 +85,25 @@ class EPNReceiverDevice : public FairMQDevice
     /// Overloads the Run() method of FairMQDevice
     void Run() override;
 
-    std::unordered_map<uint16_t, TFBuffer> mTimeframeBuffer; ///< Stores (sub-)timeframes
-    std::unordered_set<uint16_t> mDiscardedSet; ///< Set containing IDs of dropped timeframes
+    /// Allocates the ring of \p mNumSlots timeframe slots, rounded to a power of two
+    void InitSlots();
+    /// Returns the slot of the timeframe \p id, opening it if needed, or nullptr if the timeframe
+    /// was already published or discarded, or is older than the timeframe assembled in its slot
+    TimeframeSlot* GetSlot(uint16_t id);
+    /// Stops assembling the timeframe of the slot, which becomes published or discarded
+    void CloseSlot(TimeframeSlot& slot, TimeframeSlot::State state);
+    /// Sends the complete timeframe of the slot with its index
+    void PublishTimeframe(TimeframeSlot& slot);
+
+    std::vector<TimeframeSlot> mTimeframeSlots; ///< Ring of timeframe slots, indexed by the timeframe ID
+    int mOldestSlot = -1; ///< Head of the assembling slots, by time of their first part
+    int mNewestSlot = -1; ///< Tail of the assembling slots, by time of their first part
+    std::shared_ptr<TimeframeIndexPool> mIndexPool;
+    size_t mNumDiscarded = 0; ///< Number of dropped timeframes
 
     int mNumFLPs = 0; ///< Number of flpSenders
     int mBufferTimeoutInMs = 5000; ///< Time after which incomplete timeframes are dropped
+    int mNumSlots = 256; ///< Number of timeframes assembled at the same time
     int mTestMode = 0; ///< Run the device in test mode (only syncSampler+flpSender+epnReceiver)
 
     std::string mInChannelName = "";
@@ -9,8 +9,10 @@
 // or submit itself to any jurisdiction.
 
 #include <cstddef> // size_t
+#include <cassert>
 #include <fstream> // writing to file (DEBUG)
 #include <cstring>
+#include <algorithm>
 
 #include <FairMQLogger.h>
 #include <options/FairMQProgOptions.h>
@@ -30,17 +32,67 @@ using TPCTestPayload = o2::DataFlow::TPCTestPayload;
 using TPCTestCluster = o2::DataFlow::TPCTestCluster;
 using IndexElement = o2::DataFormat::IndexElement;
 
+std::unique_ptr<TimeframeIndexPool::Index> TimeframeIndexPool::acquire()
+{
+  {
+    lock_guard<mutex> lock(mMutex);
+    if (!mFreeIndices.empty()) {
+      unique_ptr<Index> index = move(mFreeIndices.back());
+      mFreeIndices.pop_back();
+      return index;
+    }
+  }
+  unique_ptr<Index> index(new Index());
+  index->pool = shared_from_this();
+  return index;
+}
+
+void TimeframeIndexPool::release(void* /*data*/, void* hint)
+{
+  unique_ptr<Index> index(static_cast<Index*>(hint));
+  // The device, and its pool, may be gone when the transport frees the message
+  if (auto pool = index->pool.lock()) {
+    index->elements.clear();
+    lock_guard<mutex> lock(pool->mMutex);
+    pool->mFreeIndices.push_back(move(index));
+  }
+}
+
 void EPNReceiverDevice::InitTask()
 {
   mNumFLPs = GetConfig()->GetValue<int>("num-flps");
   mBufferTimeoutInMs = GetConfig()->GetValue<int>("buffer-timeout");
+  mNumSlots = GetConfig()->GetValue<int>("buffer-slots");
   mTestMode = GetConfig()->GetValue<int>("test-mode");
   mInChannelName = GetConfig()->GetValue<string>("in-chan-name");
   mOutChannelName = GetConfig()->GetValue<string>("out-chan-name");
   mAckChannelName = GetConfig()->GetValue<string>("ack-chan-name");
+  InitSlots();
+}
+
+void EPNReceiverDevice::InitSlots()
+{
+  // The number of slots is a power of two not above the number of timeframe
+  // IDs, so that the slot of an ID does not change when the IDs wrap around
+  int numSlots = 1;
+  while (numSlots < mNumSlots && numSlots < (1 << 16)) {
+    numSlots <<= 1;
+  }
+  mNumSlots = numSlots;
+
+  mIndexPool = make_shared<TimeframeIndexPool>();
+  mTimeframeSlots.clear();
+  mTimeframeSlots.resize(mNumSlots);
+  for (auto& slot : mTimeframeSlots) {
+    slot.receivedFLPs.resize((mNumFLPs + 63) / 64);
+    slot.index = mIndexPool->acquire();
+  }
+  mOldestSlot = -1;
+  mNewestSlot = -1;
+  mNumDiscarded = 0;
 }
 
-void EPNReceiverDevice::PrintBuffer(const unordered_map<uint16_t, TFBuffer>& buffer) const
+void EPNReceiverDevice::PrintBuffer() const
 {
   string header = "===== ";
 
@@ -52,133 +104,176 @@ void EPNReceiverDevice::PrintBuffer(const unordered_map<uint16_t, TFBuffer>& buf
   }
   LOG(INFO) << header;
 
-  for (auto& it : buffer) {
+  for (int i = mOldestSlot; i != -1; i = mTimeframeSlots[i].next) {
+    const TimeframeSlot& slot = mTimeframeSlots[i];
     string stars = "";
-    for (unsigned int j = 1; j <= (it.second).parts.Size(); ++j) {
-      stars += "*";
+    for (int flp = 0; flp < mNumFLPs; ++flp) {
+      stars += (slot.receivedFLPs[flp / 64] >> (flp % 64)) & 1 ? "*" : " ";
     }
-    LOG(INFO) << setw(4) << it.first << ": " << stars;
+    LOG(INFO) << setw(4) << slot.id << ": " << stars;
+  }
+}
+
+TimeframeSlot* EPNReceiverDevice::GetSlot(uint16_t id)
+{
+  int position = id & (mNumSlots - 1);
+  TimeframeSlot& slot = mTimeframeSlots[position];
+
+  if (slot.state != TimeframeSlot::State::Free && slot.id == id) {
+    return slot.state == TimeframeSlot::State::Assembling ? &slot : nullptr;
+  }
+
+  if (slot.state != TimeframeSlot::State::Free && int16_t(id - slot.id) < 0) {
+    // A late or duplicate part of a timeframe older than the one of the slot,
+    // taking into account the wrap-around of the IDs: it is dropped, rather
+    // than discarding the newer timeframe
+    return nullptr;
+  }
+
+  if (slot.state == TimeframeSlot::State::Assembling) {
+    // A newer timeframe needs the slot: the ring is too small for the
+    // timeframes in flight, the older one cannot be completed anymore
+    LOG(WARN) << "Timeframe #" << slot.id << " incomplete when timeframe #" << id
+              << " arrived in its slot, discarding";
+    CloseSlot(slot, TimeframeSlot::State::Discarded);
+  }
+
+  // if this is the first part with this ID, save the receive time.
+  slot.state = TimeframeSlot::State::Assembling;
+  slot.id = id;
+  slot.start = steady_clock::now();
+  slot.previous = mNewestSlot;
+  slot.next = -1;
+  if (mNewestSlot != -1) {
+    mTimeframeSlots[mNewestSlot].next = position;
+  } else {
+    mOldestSlot = position;
+  }
+  mNewestSlot = position;
+  return &slot;
+}
+
+void EPNReceiverDevice::CloseSlot(TimeframeSlot& slot, TimeframeSlot::State state)
+{
+  if (slot.previous != -1) {
+    mTimeframeSlots[slot.previous].next = slot.next;
+  } else {
+    mOldestSlot = slot.next;
+  }
+  if (slot.next != -1) {
+    mTimeframeSlots[slot.next].previous = slot.previous;
+  } else {
+    mNewestSlot = slot.previous;
+  }
+  slot.previous = -1;
+  slot.next = -1;
+
+  if (state == TimeframeSlot::State::Discarded) {
+    LOG(WARN) << "Number of discarded timeframes: " << ++mNumDiscarded;
+  }
+  slot.state = state;
+  slot.parts.fParts.clear();
+  fill(slot.receivedFLPs.begin(), slot.receivedFLPs.end(), 0);
+  slot.numReceivedFLPs = 0;
+  if (slot.index) {
+    slot.index->elements.clear();
+  } else {
+    slot.index = mIndexPool->acquire();
   }
 }
 
 void EPNReceiverDevice::DiscardIncompleteTimeframes()
 {
-  auto it = mTimeframeBuffer.begin();
-
-  while (it != mTimeframeBuffer.end()) {
-    if (duration_cast<milliseconds>(steady_clock::now() - (it->second).start).count() > mBufferTimeoutInMs) {
-      LOG(WARN) << "Timeframe #" << it->first << " incomplete after " << mBufferTimeoutInMs << " milliseconds, discarding";
-      mDiscardedSet.insert(it->first);
-      mTimeframeBuffer.erase(it++);
-      LOG(WARN) << "Number of discarded timeframes: " << mDiscardedSet.size();
-    } else {
-      // LOG(INFO) << "Timeframe #" << it->first << " within timeout, buffering...";
-      ++it;
+  // The assembling slots are ordered by the time of their first part, only
+  // the oldest ones need to be checked
+  auto now = steady_clock::now();
+  while (mOldestSlot != -1) {
+    TimeframeSlot& slot = mTimeframeSlots[mOldestSlot];
+    if (duration_cast<milliseconds>(now - slot.start).count() <= mBufferTimeoutInMs) {
+      break;
     }
+    LOG(WARN) << "Timeframe #" << slot.id << " incomplete after " << mBufferTimeoutInMs << " milliseconds, discarding";
+    CloseSlot(slot, TimeframeSlot::State::Discarded);
   }
 }
 
-void EPNReceiverDevice::Run()
+void EPNReceiverDevice::PublishTimeframe(TimeframeSlot& slot)
 {
-  uint16_t id = 0; // holds the timeframe id of the currently arrived sub-timeframe.
+  LOG(INFO) << "Timeframe " << slot.id << " complete. Publishing.\n";
+  auto& elements = slot.index->elements;
+
+  o2::header::DataHeader tih;
+  tih.dataDescription = o2::header::DataDescription("TIMEFRAMEINDEX");
+  tih.dataOrigin = o2::header::DataOrigin("EPN");
+  tih.subSpecification = 0;
+  tih.payloadSize = elements.size() * sizeof(IndexElement);
 
-  FairMQChannel& ackOutChannel = fChannels.at(mAckChannelName).at(0);
+  slot.parts.AddPart(NewSimpleMessage(tih));
+  // The index buffer goes back to the pool once sent
+  TimeframeIndexPool::Index* index = slot.index.release();
+  slot.parts.AddPart(NewMessage(elements.data(), tih.payloadSize, &TimeframeIndexPool::release, index));
+  // when all parts are collected send then to the output channel
+  Send(slot.parts, mOutChannelName);
+  LOG(INFO) << "Index count for " << slot.id << " " << tih.payloadSize / sizeof(IndexElement) << "\n";
 
-  // Simple multi timeframe index
-  using TimeframeId = int;
-  using FlpId = int;
-  std::multimap<TimeframeId, IndexElement> index;
-  std::multimap<TimeframeId, FlpId> flpIds;
+  if (mTestMode > 0) {
+    // Send an acknowledgement back to the sampler to measure the round trip time
+    unique_ptr<FairMQMessage> ack(NewMessage(sizeof(uint16_t)));
+    memcpy(ack->GetData(), &slot.id, sizeof(uint16_t));
+
+    if (fChannels.at(mAckChannelName).at(0).Send(ack, 0) <= 0) {
+      LOG(ERROR) << "Could not send acknowledgement without blocking";
+    }
+  }
+
+  CloseSlot(slot, TimeframeSlot::State::Published);
+}
+
+void EPNReceiverDevice::Run()
+{
+  uint16_t id = 0; // holds the timeframe id of the currently arrived sub-timeframe.
 
   while (CheckCurrentState(RUNNING)) {
     FairMQParts subtimeframeParts;
-    if (Receive(subtimeframeParts, mInChannelName, 0, 100) <= 0)
-      continue;
-
-    assert(subtimeframeParts.Size() >= 2);
-
-    const auto* dh = o2::header::get<header::DataHeader*>(subtimeframeParts.At(0)->GetData());
-    assert(strncmp(dh->dataDescription.str, "SUBTIMEFRAMEMD", 16) == 0);
-    SubframeMetadata* sfm = reinterpret_cast<SubframeMetadata*>(subtimeframeParts.At(1)->GetData());
-    id = o2::DataFlow::timeframeIdFromTimestamp(sfm->startTime, sfm->duration);
-    auto flpId = sfm->flpIndex;
-
-    if (mDiscardedSet.find(id) == mDiscardedSet.end())
-    {
-      if (mTimeframeBuffer.find(id) == mTimeframeBuffer.end())
-      {
-        // if this is the first part with this ID, save the receive time.
-        mTimeframeBuffer[id].start = steady_clock::now();
-      }
-      flpIds.insert(std::make_pair(id, flpId));
-      LOG(INFO) << "Timeframe ID " << id << " for startTime " << sfm->startTime  << "\n";
-      // If the received ID has not previously been discarded, store
-      // the data part in the buffer For the moment we just concatenate
-      // the subtimeframes and add an index for their description at
-      // the end. Given every second part is a data header we skip
-      // every two parts to populate the index. Moreover we know that
-      // the SubframeMetadata is always in the second part, so we can
-      // extract the flpId from there.
-      for (size_t i = 0; i < subtimeframeParts.Size(); ++i)
-      {
-        if (i % 2 == 0)
-        {
-          const auto* adh = o2::header::get<header::DataHeader*>(subtimeframeParts.At(i)->GetData());
-          auto ie = std::make_pair(*adh, index.count(id)*2);
-          index.insert(std::make_pair(id, ie));
+    if (Receive(subtimeframeParts, mInChannelName, 0, 100) > 0) {
+      assert(subtimeframeParts.Size() >= 2);
+
+      const auto* dh = o2::header::get<header::DataHeader*>(subtimeframeParts.At(0)->GetData());
+      assert(strncmp(dh->dataDescription.str, "SUBTIMEFRAMEMD", 16) == 0);
+      SubframeMetadata* sfm = reinterpret_cast<SubframeMetadata*>(subtimeframeParts.At(1)->GetData());
+      id = o2::DataFlow::timeframeIdFromTimestamp(sfm->startTime, sfm->duration);
+      auto flpId = sfm->flpIndex;
+
+      TimeframeSlot* slot = GetSlot(id);
+      if (slot == nullptr) {
+        // if received ID has been previously published or discarded, or is older than its slot.
+        LOG(WARN) << "Received part from an already closed timeframe with id " << id;
+      } else if (flpId < 0 || flpId >= mNumFLPs) {
+        LOG(ERROR) << "Received part from FLP " << flpId << " for timeframe " << id << ", only " << mNumFLPs
+                   << " FLPs expected";
+      } else if ((slot->receivedFLPs[flpId / 64] >> (flpId % 64)) & 1) {
+        LOG(WARN) << "Received a second part from FLP " << flpId << " for timeframe " << id << ", ignoring it";
+      } else {
+        slot->receivedFLPs[flpId / 64] |= uint64_t(1) << (flpId % 64);
+        slot->numReceivedFLPs++;
+        LOG(INFO) << "Timeframe ID " << id << " for startTime " << sfm->startTime << "\n";
+        // We just concatenate the subtimeframes and add an index for
+        // their description at the end. Given every second part is a
+        // data header we skip every two parts to populate the index.
+        for (size_t i = 0; i < subtimeframeParts.Size(); ++i) {
+          if (i % 2 == 0) {
+            const auto* adh = o2::header::get<header::DataHeader*>(subtimeframeParts.At(i)->GetData());
+            slot->index->elements.emplace_back(*adh, slot->parts.Size());
+          }
+          slot->parts.AddPart(move(subtimeframeParts.At(i)));
         }
-        mTimeframeBuffer[id].parts.AddPart(move(subtimeframeParts.At(i)));
-      }
-    }
-    else
-    {
-      // if received ID has been previously discarded.
-      LOG(WARN) << "Received part from an already discarded timeframe with id " << id;
-    }
 
-    if (flpIds.count(id) == mNumFLPs) {
-      LOG(INFO) << "Timeframe " << id << " complete. Publishing.\n";
-      o2::header::DataHeader tih;
-      std::vector<IndexElement> flattenedIndex;
-
-      tih.dataDescription = o2::header::DataDescription("TIMEFRAMEINDEX");
-      tih.dataOrigin = o2::header::DataOrigin("EPN");
-      tih.subSpecification = 0;
-      tih.payloadSize = index.count(id) * sizeof(flattenedIndex.front());
-      void *indexData = malloc(tih.payloadSize);
-      auto indexRange = index.equal_range(id);
-      for (auto ie = indexRange.first; ie != indexRange.second; ++ie)
-      {
-        flattenedIndex.push_back(ie->second);
-      }
-      memcpy(indexData, flattenedIndex.data(), tih.payloadSize);
-
-      mTimeframeBuffer[id].parts.AddPart(NewSimpleMessage(tih));
-      mTimeframeBuffer[id].parts.AddPart(NewMessage(indexData, tih.payloadSize,
-                         [](void* data, void* hint){ free(data); }, nullptr));
-      // LOG(INFO) << "Collected all parts for timeframe #" << id;
-      // when all parts are collected send then to the output channel
-      Send(mTimeframeBuffer[id].parts, mOutChannelName);
-      LOG(INFO) << "Index count for " << id << " " << index.count(id) << "\n";
-      index.erase(id);
-      LOG(INFO) << "Index count for " << id << " " << index.count(id) << "\n";
-      flpIds.erase(id);
-
-      if (mTestMode > 0) {
-        // Send an acknowledgement back to the sampler to measure the round trip time
-        unique_ptr<FairMQMessage> ack(NewMessage(sizeof(uint16_t)));
-        memcpy(ack->GetData(), &id, sizeof(uint16_t));
-
-        if (ackOutChannel.Send(ack, 0) <= 0) {
-          LOG(ERROR) << "Could not send acknowledgement without blocking";
+        if (slot->numReceivedFLPs == mNumFLPs) {
+          PublishTimeframe(*slot);
         }
       }
-
-      mTimeframeBuffer.erase(id);
     }
 
-    // LOG(WARN) << "Buffer size: " << fTimeframeBuffer.size();
-
     // Check if any incomplete timeframes in the buffer are older than
     // timeout period, and discard them if they are
     // QUESTION: is this really what we want to do?
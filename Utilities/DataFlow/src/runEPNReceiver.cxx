@@ -26,6 +26,7 @@ void addCustomOptions(bpo::options_description& options)
 {
   options.add_options()
     ("buffer-timeout", bpo::value<int>()->default_value(1000), "Buffer timeout in milliseconds")
+    ("buffer-slots", bpo::value<int>()->default_value(256), "Number of timeframes assembled at once, rounded up to a power of two")
     ("num-flps", bpo::value<int>()->required(), "Number of FLPs")
     ("test-mode", bpo::value<int>()->default_value(0), "Run in test mode")
     ("in-chan-name", bpo::value<std::string>()->default_value("stf2"), "Name of the input channel (sub-time frames)")
@@ -0,0 +1,114 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Utilities DataFlowEPNReceiver
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "DataFlow/EPNReceiverDevice.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace o2::Devices;
+
+// Gives access to the timeframe slots, without running the device
+class TestEPNReceiverDevice : public EPNReceiverDevice
+{
+  public:
+    TestEPNReceiverDevice(int numSlots, int numFLPs)
+    {
+      mNumSlots = numSlots;
+      mNumFLPs = numFLPs;
+      InitSlots();
+    }
+
+    using EPNReceiverDevice::GetSlot;
+    using EPNReceiverDevice::CloseSlot;
+    using EPNReceiverDevice::mNumSlots;
+    using EPNReceiverDevice::mNumDiscarded;
+    using EPNReceiverDevice::mOldestSlot;
+    using EPNReceiverDevice::mNewestSlot;
+};
+
+BOOST_AUTO_TEST_CASE(TimeframeIndexPoolReuse)
+{
+  auto pool = std::make_shared<TimeframeIndexPool>();
+  auto index = pool->acquire();
+  index->elements.resize(10);
+  auto address = index.get();
+  TimeframeIndexPool::release(nullptr, index.release());
+
+  // The released index is handed out again, empty
+  auto reused = pool->acquire();
+  BOOST_CHECK_EQUAL(reused.get(), address);
+  BOOST_CHECK(reused->elements.empty());
+  auto other = pool->acquire();
+  BOOST_CHECK(other.get() != address);
+
+  // An index released after the pool is gone is simply deleted
+  pool.reset();
+  TimeframeIndexPool::release(nullptr, reused.release());
+  TimeframeIndexPool::release(nullptr, other.release());
+}
+
+BOOST_AUTO_TEST_CASE(TimeframeSlotsRing)
+{
+  TestEPNReceiverDevice device(3, 2);
+  BOOST_CHECK_EQUAL(device.mNumSlots, 4);
+
+  TimeframeSlot* slot = device.GetSlot(1);
+  BOOST_REQUIRE(slot != nullptr);
+  BOOST_CHECK(slot->state == TimeframeSlot::State::Assembling);
+  BOOST_CHECK_EQUAL(slot->id, 1);
+  BOOST_CHECK_EQUAL(device.GetSlot(1), slot);
+  BOOST_CHECK_EQUAL(device.mOldestSlot, 1);
+  BOOST_CHECK_EQUAL(device.mNewestSlot, 1);
+
+  // A published timeframe does not get reopened by a duplicate part
+  device.CloseSlot(*slot, TimeframeSlot::State::Published);
+  BOOST_CHECK_EQUAL(device.mOldestSlot, -1);
+  BOOST_CHECK(device.GetSlot(1) == nullptr);
+
+  // A newer timeframe reuses the slot, a late part of the older one is dropped
+  BOOST_CHECK_EQUAL(device.GetSlot(5), slot);
+  BOOST_CHECK(device.GetSlot(1) == nullptr);
+  BOOST_CHECK(slot->state == TimeframeSlot::State::Assembling);
+  BOOST_CHECK_EQUAL(slot->id, 5);
+  BOOST_CHECK_EQUAL(device.mNumDiscarded, 0);
+
+  // An incomplete timeframe is discarded only for a newer one
+  BOOST_CHECK_EQUAL(device.GetSlot(9), slot);
+  BOOST_CHECK_EQUAL(device.mNumDiscarded, 1);
+  BOOST_CHECK_EQUAL(slot->id, 9);
+}
+
+BOOST_AUTO_TEST_CASE(TimeframeSlotsWrapAround)
+{
+  TestEPNReceiverDevice device(4, 1);
+
+  TimeframeSlot* slot = device.GetSlot(0xfffe);
+  BOOST_REQUIRE(slot != nullptr);
+  TimeframeSlot* next = device.GetSlot(0xffff);
+  BOOST_REQUIRE(next != nullptr);
+  BOOST_CHECK_EQUAL(device.mOldestSlot, 2);
+  BOOST_CHECK_EQUAL(device.mNewestSlot, 3);
+
+  // Timeframe 2 follows 0xfffe after the IDs wrapped around
+  BOOST_CHECK_EQUAL(device.GetSlot(2), slot);
+  BOOST_CHECK_EQUAL(slot->id, 2);
+  BOOST_CHECK_EQUAL(device.mNumDiscarded, 1);
+  BOOST_CHECK_EQUAL(device.mOldestSlot, 3);
+  BOOST_CHECK_EQUAL(device.mNewestSlot, 2);
+
+  // and 0xfffe is older than 2
+  BOOST_CHECK(device.GetSlot(0xfffe) == nullptr);
+  BOOST_CHECK_EQUAL(slot->id, 2);
+  BOOST_CHECK(slot->state == TimeframeSlot::State::Assembling);
+  BOOST_CHECK_EQUAL(device.mNumDiscarded, 1);
+}
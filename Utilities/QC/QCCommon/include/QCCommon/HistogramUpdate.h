@@ -0,0 +1,428 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <TArray.h>
+#include <TArrayF.h>
+#include <TH1.h>
+#include <THn.h>
+
+namespace o2
+{
+namespace qc
+{
+/// Partial update of a histogram: the bins which changed and the statistics. It is sent instead of the whole ROOT
+/// serialized histogram once the receiver has a histogram with the same title and binning, and is applied to it in
+/// place. The values of an Add update are added to the bins, e.g. for the objects produced at each cycle which are
+/// merged together, the values of a Replace update replace the bins, e.g. for the merged objects which replace the
+/// previous ones.
+///
+/// The message starts with a HistogramUpdateHeader, followed by the title and by the changed bins: the bin indices,
+/// the contents and, for histograms with errors, the sums of squares of weights. The indices are 64 bit integers
+/// or, when compressed, the differences to the previous index encoded as LEB128 varints. Compressed contents of
+/// histograms stored with floats are sent as floats. TH1 and THn (not THnSparse) histograms can be updated, the THn
+/// updates do not carry the sums of weights used for the statistics.
+enum class HistogramUpdateMode : uint8_t { Add, Replace };
+
+struct HistogramUpdateHeader {
+  enum Flags : uint8_t { Compressed = 1, Errors = 2, FloatContents = 4, Stats = 8 };
+  static constexpr uint32_t MAGIC = 0x55484351; // "QCHU", a TMessage would start with its length
+
+  uint32_t magic;
+  HistogramUpdateMode mode;
+  uint8_t flags;
+  uint16_t titleSize;
+  uint64_t numberOfBins;
+  uint64_t numberOfChangedBins;
+  double entries;
+  double stats[TH1::kNstat];
+};
+
+/// A decoded histogram update
+struct HistogramUpdate {
+  HistogramUpdateMode mode;
+  std::string title;
+  uint64_t numberOfBins;
+  double entries;
+  bool hasStats;
+  double stats[TH1::kNstat];
+  std::vector<uint64_t> bins;
+  std::vector<double> contents;
+  std::vector<double> errors2; // empty for histograms without errors
+};
+
+/// The state of a histogram an update is computed against, i.e. what the receiver already has
+struct HistogramReference {
+  std::vector<double> contents;
+  std::vector<double> errors2;
+  double entries{ 0. };
+  double stats[TH1::kNstat] = { 0. };
+};
+
+/// Uniform access to the bins of the histograms which can be updated
+class HistogramBins
+{
+ public:
+  HistogramBins(TObject* histogram)
+    : mTH1(dynamic_cast<TH1*>(histogram)), mTHn(dynamic_cast<THn*>(histogram)),
+      mTH1Bins(dynamic_cast<TArray*>(histogram))
+  {
+    // the profiles have more per bin arrays
+    if (mTH1 != nullptr && (mTH1->InheritsFrom("TProfile") || mTH1->InheritsFrom("TProfile2D") ||
+                            mTH1->InheritsFrom("TProfile3D"))) {
+      mTH1 = nullptr;
+    }
+  }
+
+  bool valid() const { return (mTH1 != nullptr && mTH1Bins != nullptr) || mTHn != nullptr; }
+  bool hasFloatContents() const
+  {
+    return mTH1 != nullptr ? dynamic_cast<TArrayF*>(mTH1) != nullptr : dynamic_cast<THnF*>(mTHn) != nullptr;
+  }
+  bool hasErrors() const { return mTH1 != nullptr ? mTH1->GetSumw2N() > 0 : mTHn->GetCalculateErrors(); }
+  bool hasStats() const { return mTH1 != nullptr; }
+  uint64_t size() const { return mTH1 != nullptr ? mTH1->GetNcells() : mTHn->GetNbins(); }
+
+  // TArray::SetAt is used rather than TH1::SetBinContent, which counts an entry at each call
+  double content(uint64_t bin) const { return mTH1 != nullptr ? mTH1Bins->GetAt(bin) : mTHn->GetBinContent(bin); }
+  void setContent(uint64_t bin, double content)
+  {
+    if (mTH1 != nullptr) {
+      mTH1Bins->SetAt(content, bin);
+    } else {
+      mTHn->SetBinContent(bin, content);
+    }
+  }
+  double error2(uint64_t bin) const
+  {
+    return mTH1 != nullptr ? mTH1->GetSumw2()->GetArray()[bin] : mTHn->GetBinError2(bin);
+  }
+  void setError2(uint64_t bin, double error2)
+  {
+    if (mTH1 != nullptr) {
+      mTH1->GetSumw2()->GetArray()[bin] = error2;
+    } else {
+      mTHn->SetBinError2(bin, error2);
+    }
+  }
+
+  double entries() const { return mTH1 != nullptr ? mTH1->GetEntries() : mTHn->GetEntries(); }
+  void setEntries(double entries)
+  {
+    if (mTH1 != nullptr) {
+      mTH1->SetEntries(entries);
+    } else {
+      mTHn->SetEntries(entries);
+    }
+  }
+  void getStats(double* stats) const { mTH1->GetStats(stats); }
+  void putStats(double* stats) { mTH1->PutStats(stats); }
+  void reset()
+  {
+    if (mTH1 != nullptr) {
+      mTH1->Reset();
+    } else {
+      mTHn->Reset();
+    }
+  }
+
+ private:
+  TH1* mTH1;
+  THn* mTHn;
+  TArray* mTH1Bins;
+};
+
+/// Free function for messages sending the buffer of encodeHistogramUpdate, given as hint
+inline void deleteHistogramUpdateBuffer(void*, void* hint) { delete static_cast<std::vector<char>*>(hint); }
+
+inline bool canBeUpdated(TObject* histogram) { return HistogramBins(histogram).valid(); }
+
+inline bool isHistogramUpdate(const void* data, size_t size)
+{
+  uint32_t magic = 0;
+  if (size < sizeof(HistogramUpdateHeader)) {
+    return false;
+  }
+  memcpy(&magic, data, sizeof(magic));
+  return magic == HistogramUpdateHeader::MAGIC;
+}
+
+namespace histogram_update_detail
+{
+template <typename T>
+void append(std::vector<char>& buffer, const T& value)
+{
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+inline void appendVarint(std::vector<char>& buffer, uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+class Reader
+{
+ public:
+  Reader(const char* data, size_t size) : mData(data), mEnd(data + size) {}
+
+  template <typename T>
+  T read()
+  {
+    T value;
+    check(sizeof(T));
+    memcpy(&value, mData, sizeof(T));
+    mData += sizeof(T);
+    return value;
+  }
+
+  uint64_t readVarint()
+  {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      check(1);
+      uint8_t byte = *mData++;
+      value |= uint64_t(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw std::runtime_error("Malformed histogram update varint");
+  }
+
+  std::string readString(size_t size)
+  {
+    check(size);
+    std::string value(mData, size);
+    mData += size;
+    return value;
+  }
+
+ private:
+  void check(size_t size) const
+  {
+    if (size > static_cast<size_t>(mEnd - mData)) {
+      throw std::runtime_error("Truncated histogram update");
+    }
+  }
+
+  const char* mData;
+  const char* mEnd;
+};
+}
+
+/// Sets the reference to the current state of the histogram
+inline void setHistogramReference(TObject* histogram, HistogramReference& reference)
+{
+  HistogramBins bins(histogram);
+  const uint64_t size = bins.size();
+  const bool errors = bins.hasErrors();
+  reference.contents.resize(size);
+  reference.errors2.resize(errors ? size : 0);
+  for (uint64_t bin = 0; bin < size; ++bin) {
+    reference.contents[bin] = bins.content(bin);
+    if (errors) {
+      reference.errors2[bin] = bins.error2(bin);
+    }
+  }
+  reference.entries = bins.entries();
+  if (bins.hasStats()) {
+    bins.getStats(reference.stats);
+  }
+}
+
+/// Encodes the bins of @a histogram which differ from @a reference, or from an empty histogram when there is no
+/// reference (or it has another binning). Add updates carry the differences to the reference, Replace updates the
+/// values of the histogram. The reference is left as is, it is up to the caller to set it to the histogram once the
+/// update was delivered.
+inline std::vector<char> encodeHistogramUpdate(TObject* histogram, HistogramUpdateMode mode, bool compress,
+                                               const HistogramReference* reference = nullptr)
+{
+  using namespace histogram_update_detail;
+  HistogramBins bins(histogram);
+  if (!bins.valid()) {
+    throw std::runtime_error(std::string("Histogram updates are not supported for ") + histogram->ClassName());
+  }
+  const uint64_t size = bins.size();
+  const bool errors = bins.hasErrors();
+  const bool floatContents = compress && bins.hasFloatContents();
+  const bool useReference =
+    reference != nullptr && reference->contents.size() == size && reference->errors2.size() == (errors ? size : 0);
+
+  std::vector<uint64_t> changedBins;
+  for (uint64_t bin = 0; bin < size; ++bin) {
+    double previousContent = useReference ? reference->contents[bin] : 0.;
+    double previousError2 = useReference && errors ? reference->errors2[bin] : 0.;
+    if (bins.content(bin) != previousContent || (errors && bins.error2(bin) != previousError2)) {
+      changedBins.push_back(bin);
+    }
+  }
+
+  HistogramUpdateHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = HistogramUpdateHeader::MAGIC;
+  header.mode = mode;
+  header.flags = (compress ? HistogramUpdateHeader::Compressed : 0) | (errors ? HistogramUpdateHeader::Errors : 0) |
+                 (floatContents ? HistogramUpdateHeader::FloatContents : 0) |
+                 (bins.hasStats() ? HistogramUpdateHeader::Stats : 0);
+  std::string title = histogram->GetTitle();
+  header.titleSize = title.size();
+  header.numberOfBins = size;
+  header.numberOfChangedBins = changedBins.size();
+  header.entries = bins.entries();
+  if (bins.hasStats()) {
+    bins.getStats(header.stats);
+  }
+  bool add = mode == HistogramUpdateMode::Add;
+  if (add && useReference) {
+    header.entries -= reference->entries;
+    for (int i = 0; i < TH1::kNstat; ++i) {
+      header.stats[i] -= reference->stats[i];
+    }
+  }
+
+  std::vector<char> buffer;
+  buffer.reserve(sizeof(header) + title.size() + changedBins.size() * (compress ? 6 : 16 + (errors ? 8 : 0)));
+  append(buffer, header);
+  buffer.insert(buffer.end(), title.begin(), title.end());
+  uint64_t previousBin = 0;
+  for (uint64_t bin : changedBins) {
+    if (compress) {
+      appendVarint(buffer, bin - previousBin);
+      previousBin = bin;
+    } else {
+      append(buffer, bin);
+    }
+  }
+  for (uint64_t bin : changedBins) {
+    double content = bins.content(bin) - (add && useReference ? reference->contents[bin] : 0.);
+    if (floatContents) {
+      append(buffer, static_cast<float>(content));
+    } else {
+      append(buffer, content);
+    }
+  }
+  if (errors) {
+    for (uint64_t bin : changedBins) {
+      append(buffer, bins.error2(bin) - (add && useReference ? reference->errors2[bin] : 0.));
+    }
+  }
+
+  return buffer;
+}
+
+inline HistogramUpdate decodeHistogramUpdate(const char* data, size_t size)
+{
+  using namespace histogram_update_detail;
+  Reader reader(data, size);
+  auto header = reader.read<HistogramUpdateHeader>();
+  if (header.magic != HistogramUpdateHeader::MAGIC) {
+    throw std::runtime_error("Not a histogram update");
+  }
+
+  HistogramUpdate update;
+  update.mode = header.mode;
+  update.title = reader.readString(header.titleSize);
+  update.numberOfBins = header.numberOfBins;
+  update.entries = header.entries;
+  update.hasStats = header.flags & HistogramUpdateHeader::Stats;
+  memcpy(update.stats, header.stats, sizeof(update.stats));
+
+  // every changed bin takes at least one byte, which bounds the allocations of malformed messages
+  if (header.numberOfChangedBins > size || header.numberOfChangedBins > header.numberOfBins) {
+    throw std::runtime_error("Malformed histogram update");
+  }
+  update.bins.resize(header.numberOfChangedBins);
+  update.contents.resize(header.numberOfChangedBins);
+  uint64_t bin = 0;
+  for (auto& changedBin : update.bins) {
+    if (header.flags & HistogramUpdateHeader::Compressed) {
+      bin += reader.readVarint();
+      changedBin = bin;
+    } else {
+      changedBin = reader.read<uint64_t>();
+    }
+    if (changedBin >= header.numberOfBins) {
+      throw std::runtime_error("Histogram update bin out of range");
+    }
+  }
+  for (auto& content : update.contents) {
+    content = header.flags & HistogramUpdateHeader::FloatContents ? reader.read<float>() : reader.read<double>();
+  }
+  if (header.flags & HistogramUpdateHeader::Errors) {
+    update.errors2.resize(header.numberOfChangedBins);
+    for (auto& error2 : update.errors2) {
+      error2 = reader.read<double>();
+    }
+  }
+  return update;
+}
+
+/// Applies the update in place, returns false if the histogram can't be updated or has another binning
+inline bool applyHistogramUpdate(TObject* histogram, const HistogramUpdate& update)
+{
+  HistogramBins bins(histogram);
+  if (!bins.valid() || bins.size() != update.numberOfBins || bins.hasStats() != update.hasStats ||
+      update.contents.size() != update.bins.size() ||
+      (!update.errors2.empty() && update.errors2.size() != update.bins.size()) ||
+      (update.errors2.empty() && !update.bins.empty() && bins.hasErrors())) {
+    return false;
+  }
+  for (uint64_t bin : update.bins) {
+    if (bin >= update.numberOfBins) {
+      return false;
+    }
+  }
+  if (!update.errors2.empty() && !bins.hasErrors()) {
+    if (bins.hasStats()) {
+      static_cast<TH1*>(histogram)->Sumw2();
+    } else {
+      return false;
+    }
+  }
+
+  bool add = update.mode == HistogramUpdateMode::Add;
+  double stats[TH1::kNstat];
+  if (update.hasStats) {
+    // the statistics are read before the bins change, since they are computed from the bins when not filled
+    bins.getStats(stats);
+    for (int i = 0; i < TH1::kNstat; ++i) {
+      stats[i] = add ? stats[i] + update.stats[i] : update.stats[i];
+    }
+  }
+  double entries = add ? bins.entries() + update.entries : update.entries;
+
+  for (size_t i = 0; i < update.bins.size(); ++i) {
+    uint64_t bin = update.bins[i];
+    bins.setContent(bin, add ? bins.content(bin) + update.contents[i] : update.contents[i]);
+    if (!update.errors2.empty()) {
+      bins.setError2(bin, add ? bins.error2(bin) + update.errors2[i] : update.errors2[i]);
+    }
+  }
+
+  if (update.hasStats) {
+    bins.putStats(stats);
+  }
+  bins.setEntries(entries);
+  return true;
+}
+}
+}
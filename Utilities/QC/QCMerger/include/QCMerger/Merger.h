@@ -11,34 +11,110 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
-#include <TList.h>
+#include <TObject.h>
+
+#include "QCCommon/HistogramUpdate.h"
 
 namespace o2
 {
 namespace qc
 {
-typedef std::unordered_map<std::string, TList*> TCollectionMap;
+/// Merge latency of one type of objects, in miliseconds
+struct MergeLatency {
+  unsigned int count{ 0 };
+  double total{ 0. };
+  double maximum{ 0. };
+
+  double average() const { return count == 0 ? 0. : total / count; }
+};
 
+/// Merges the objects with the same title. The first object received for a title is the destination, into which the
+/// following ones are merged as soon as they arrive and then deleted. The destination is given back once the objects
+/// of complete data are merged into it. Histograms of the same class and binning are added bin by bin, other objects
+/// are merged with the merge function of their class.
+///
+/// Histograms can also be merged from HistogramUpdates, applied in place to the destination. A destination is then
+/// created from an empty copy of the first histogram received with the title. The updates received before this
+/// histogram (e.g. merged by another thread first, or after a restart of the merger) are held until it arrives, the
+/// objects they complete are then given by takeMergedObjects.
+///
+/// With a number of threads, mergeObjectAsync and mergeUpdateAsync queue the objects for a pool of threads, which
+/// merge the objects with different titles concurrently. The complete objects are then collected with
+/// takeMergedObjects.
 class Merger
 {
  public:
-  Merger(const int numberOfQCOgbjectForCompleteData);
+  Merger(const int numberOfQCOgbjectForCompleteData, const unsigned int numberOfThreads = 0);
   virtual ~Merger();
 
+  /// Merges the object, returns the merged object once complete and nullptr otherwise. Takes the ownership of the
+  /// object and gives the ownership of the returned object.
   TObject* mergeObject(TObject* object);
-  TObject* mergeObjectWithGivenCollection(TObject* object);
-  void addReceivedObjectToMapByName(TObject* receivedObject);
+  /// Merges the histogram update, returns the merged object once complete and nullptr otherwise (also when the
+  /// update is held until a histogram with its title is received).
+  TObject* mergeUpdate(const HistogramUpdate& update);
+  /// Merges the object on the pool of threads, or directly when there are none.
+  void mergeObjectAsync(TObject* object);
+  void mergeUpdateAsync(HistogramUpdate update);
+  /// Returns the complete objects merged by mergeObjectAsync and mergeUpdateAsync, with their ownership.
+  std::vector<TObject*> takeMergedObjects();
   double getMergeTime();
+  std::unordered_map<std::string, MergeLatency> getMergeLatencies();
   void dumpObjectsCollectionToFile(const char* title);
   void eraseCollection(const char* title);
 
  private:
-  TCollectionMap mTitlesToDataObjectsMap;
+  struct Destination {
+    std::mutex mutex;
+    TObject* object{ nullptr };
+    std::unique_ptr<TObject> emptyObject; // to create the destination of updates
+    std::deque<HistogramUpdate> heldUpdates; // received before emptyObject
+    int numberOfMergedObjects{ 0 };
+  };
+
+  struct QueuedObject {
+    TObject* object;
+    std::unique_ptr<HistogramUpdate> update;
+  };
+
+  Destination& getDestination(const char* title);
+  void mergeIntoDestination(TObject* destination, TObject* object);
+  TObject* applyUpdate(Destination& destination, const HistogramUpdate& update);
+  TObject* countMergedObject(Destination& destination);
+  void storeMergedObject(TObject* mergedObject);
+  void recordMergeTime(const char* type, std::chrono::high_resolution_clock::time_point start);
+  void queue(QueuedObject object);
+  void mergeQueuedObject(QueuedObject& object);
+  void runWorker();
+
+  std::mutex mDestinationsMutex;
+  std::unordered_map<std::string, std::unique_ptr<Destination>> mDestinations;
+
+  std::mutex mLatencyMutex;
   std::chrono::microseconds mMergeTime{ 0 };
+  std::unordered_map<std::string, MergeLatency> mMergeLatencies;
+
+  std::mutex mQueueMutex;
+  std::condition_variable mQueueCondition;
+  std::deque<QueuedObject> mQueue;
+  bool mStopping{ false };
+  std::vector<std::thread> mWorkers;
+
+  std::mutex mMergedObjectsMutex;
+  std::vector<TObject*> mMergedObjects;
+
   unsigned int mNumberOfDumpedObjects{ 0 };
   const int NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA;
+  const size_t MAXIMUM_HELD_UPDATES{ 100 }; // per title
 };
 }
-}
\ No newline at end of file
+}
@@ -15,6 +15,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -24,6 +25,7 @@
 #include <dds_intercom.h>
 
 #include "Merger.h"
+#include "QCCommon/HistogramUpdate.h"
 
 namespace o2
 {
@@ -50,7 +52,8 @@ class MergerDevice : public FairMQDevice
   boost::property_tree::ptree createCheckStateResponse(const boost::property_tree::ptree& request);
   boost::property_tree::ptree createGetMetricsResponse(const boost::property_tree::ptree& request);
   void handleReceivedDataObject();
-  TObject* receiveDataObjectFromProducer();
+  void sendMergedObjects();
+  std::unique_ptr<FairMQMessage> receiveMessageFromProducer();
   TMessage* createTMessageForViewer(const TObject* objectToSend) const;
   size_t sendMergedObjectToViewer(TObject* dataObject);
   void sendControlResponse(const boost::property_tree::ptree& response, std::string senderId);
@@ -65,6 +68,13 @@ class MergerDevice : public FairMQDevice
   dds::intercom_api::CIntercomService mService;
   std::unique_ptr<dds::intercom_api::CCustomCmd> ddsCustomCmd;
   std::deque<double> mMergeTimes;
+  // What the viewer has of each histogram, to send the changed bins only. A full object is sent periodically, so
+  // that a restarted viewer gets the histograms again.
+  struct ViewerHistogram {
+    HistogramReference reference;
+    unsigned int updatesSinceFullObject{ 0 };
+  };
+  std::unordered_map<std::string, ViewerHistogram> mViewerHistograms;
 
   std::chrono::high_resolution_clock::time_point lastCpuMeasuredTime;
   std::chrono::high_resolution_clock::time_point mLastNumberOfMergeObjectsTime;
@@ -73,6 +83,7 @@ class MergerDevice : public FairMQDevice
   std::ifstream procSelfStatus;
 
   const unsigned LOGGED_MESSAGES{ 10 };
+  const unsigned UPDATES_BETWEEN_FULL_OBJECTS{ 100 };
   const size_t MESSAGE_MAXIMUM_SIZE = 1000000 * 1000; // Mb
 
   volatile bool mReceiveBufferOverloaded{ false };
@@ -10,14 +10,18 @@
 
 #include <FairMQLogger.h>
 
+#include <TArrayD.h>
+#include <TArrayF.h>
+#include <TClass.h>
 #include <TH1.h>
 #include <TH2.h>
 #include <TH3.h>
-#include <THn.h>
-#include <TTree.h>
+#include <TList.h>
+#include <TROOT.h>
 
 #include "QCMerger/Merger.h"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -26,110 +30,327 @@ namespace o2
 {
 namespace qc
 {
-Merger::Merger(const int numberOfQCOgbjectForCompleteData)
+namespace
+{
+// Histograms whose content is only made of the bins, the sum of squares of weights and the statistics
+bool isBinArrayHistogram(const TClass* histogramClass)
+{
+  return histogramClass == TH1F::Class() || histogramClass == TH2F::Class() || histogramClass == TH3F::Class() ||
+         histogramClass == TH1D::Class() || histogramClass == TH2D::Class() || histogramClass == TH3D::Class();
+}
+
+bool haveSameBinning(const TAxis* first, const TAxis* second)
+{
+  if (first->GetNbins() != second->GetNbins() || first->GetXmin() != second->GetXmin() ||
+      first->GetXmax() != second->GetXmax() || first->GetLabels() != nullptr || second->GetLabels() != nullptr) {
+    return false;
+  }
+  const TArrayD* firstBins = first->GetXbins();
+  const TArrayD* secondBins = second->GetXbins();
+  return firstBins->GetSize() == secondBins->GetSize() &&
+         equal(firstBins->GetArray(), firstBins->GetArray() + firstBins->GetSize(), secondBins->GetArray());
+}
+
+template <typename T>
+void addBins(T* __restrict__ destination, const T* __restrict__ source, int size)
+{
+  for (int i = 0; i < size; ++i) {
+    destination[i] += source[i];
+  }
+}
+
+template <typename Array>
+bool addBinArrays(TH1* destination, TH1* source)
+{
+  auto destinationBins = dynamic_cast<Array*>(destination);
+  auto sourceBins = dynamic_cast<Array*>(source);
+  if (destinationBins == nullptr || sourceBins == nullptr || destinationBins->GetSize() != sourceBins->GetSize()) {
+    return false;
+  }
+  addBins(destinationBins->GetArray(), sourceBins->GetArray(), destinationBins->GetSize());
+  return true;
+}
+
+// Adds the histograms bin by bin, returns false when they don't have the same class and binning
+bool addHistogramBins(TH1* destination, TH1* source)
+{
+  if (destination->IsA() != source->IsA() || !isBinArrayHistogram(destination->IsA()) ||
+      destination->GetBufferLength() > 0 || source->GetBufferLength() > 0 ||
+      destination->GetSumw2N() != source->GetSumw2N() ||
+      !haveSameBinning(destination->GetXaxis(), source->GetXaxis()) ||
+      !haveSameBinning(destination->GetYaxis(), source->GetYaxis()) ||
+      !haveSameBinning(destination->GetZaxis(), source->GetZaxis())) {
+    return false;
+  }
+
+  // The statistics are taken before adding the bins, since they are computed from the bins when not filled
+  Double_t destinationStats[TH1::kNstat] = { 0 };
+  Double_t sourceStats[TH1::kNstat] = { 0 };
+  destination->GetStats(destinationStats);
+  source->GetStats(sourceStats);
+  double entries = destination->GetEntries() + source->GetEntries();
+
+  if (!addBinArrays<TArrayF>(destination, source) && !addBinArrays<TArrayD>(destination, source)) {
+    return false;
+  }
+  if (destination->GetSumw2N() > 0) {
+    addBins(destination->GetSumw2()->GetArray(), source->GetSumw2()->GetArray(), destination->GetSumw2N());
+  }
+
+  for (int i = 0; i < TH1::kNstat; ++i) {
+    destinationStats[i] += sourceStats[i];
+  }
+  destination->PutStats(destinationStats);
+  destination->SetEntries(entries);
+  return true;
+}
+
+// A copy of the histogram which is not attached to the current directory
+TObject* cloneHistogram(TObject* histogram)
+{
+  TObject* clone = histogram->Clone();
+  if (auto clonedTH1 = dynamic_cast<TH1*>(clone)) {
+    clonedTH1->SetDirectory(nullptr);
+  }
+  return clone;
+}
+}
+
+Merger::Merger(const int numberOfQCOgbjectForCompleteData, const unsigned int numberOfThreads)
   : NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA(numberOfQCOgbjectForCompleteData)
 {
+  if (numberOfThreads > 0) {
+    ROOT::EnableThreadSafety();
+  }
+  for (unsigned int i = 0; i < numberOfThreads; ++i) {
+    mWorkers.emplace_back(&Merger::runWorker, this);
+  }
+}
+
+Merger::Destination& Merger::getDestination(const char* title)
+{
+  lock_guard<mutex> lock(mDestinationsMutex);
+  auto& destination = mDestinations[title];
+  if (!destination) {
+    destination.reset(new Destination());
+  }
+  return *destination;
 }
 
 TObject* Merger::mergeObject(TObject* object)
 {
-  auto foundEntry = mTitlesToDataObjectsMap.find(object->GetTitle());
+  Destination& destination = getDestination(object->GetTitle());
+  lock_guard<mutex> lock(destination.mutex);
+
+  if (destination.emptyObject == nullptr && canBeUpdated(object)) {
+    destination.emptyObject.reset(cloneHistogram(object));
+    HistogramBins(destination.emptyObject.get()).reset();
+  }
 
-  if (foundEntry != mTitlesToDataObjectsMap.end() &&
-      foundEntry->second->GetSize() >= NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA - 1) {
-    TObject* output = mergeObjectWithGivenCollection(object);
-    eraseCollection(object->GetTitle());
-    return output;
+  if (destination.object == nullptr) {
+    destination.object = object;
   } else {
-    addReceivedObjectToMapByName(object);
+    mergeIntoDestination(destination.object, object);
+  }
+  TObject* output = countMergedObject(destination);
+
+  if (destination.emptyObject != nullptr) {
+    for (const HistogramUpdate& update : destination.heldUpdates) {
+      if (TObject* completeObject = applyUpdate(destination, update)) {
+        storeMergedObject(completeObject);
+      }
+    }
+    destination.heldUpdates.clear();
+  }
+  return output;
+}
+
+TObject* Merger::mergeUpdate(const HistogramUpdate& update)
+{
+  Destination& destination = getDestination(update.title.c_str());
+  lock_guard<mutex> lock(destination.mutex);
+
+  if (destination.emptyObject == nullptr) {
+    if (destination.heldUpdates.size() >= MAXIMUM_HELD_UPDATES) {
+      LOG(ERROR) << "No histogram received for the updates of " << update.title << ", oldest update dropped.";
+      destination.heldUpdates.pop_front();
+    }
+    destination.heldUpdates.push_back(update);
     return nullptr;
   }
+  return applyUpdate(destination, update);
 }
 
-void Merger::addReceivedObjectToMapByName(TObject* receivedObject)
+TObject* Merger::applyUpdate(Destination& destination, const HistogramUpdate& update)
 {
-  auto foundList = mTitlesToDataObjectsMap.find(receivedObject->GetTitle());
+  if (destination.object == nullptr) {
+    destination.object = cloneHistogram(destination.emptyObject.get());
+  }
 
-  if (foundList != mTitlesToDataObjectsMap.end()) {
-    foundList->second->Add(receivedObject);
-  } else {
-    auto newItemIterator = mTitlesToDataObjectsMap.insert(make_pair(receivedObject->GetTitle(), new TList()));
-    newItemIterator.first->second->Add(receivedObject);
+  auto measureTime = chrono::high_resolution_clock::now();
+  if (!applyHistogramUpdate(destination.object, update)) {
+    LOG(ERROR) << "Update of " << update.title << " does not match the histogram binning, dropped.";
+    return nullptr;
   }
+  recordMergeTime(destination.object->ClassName(), measureTime);
+  return countMergedObject(destination);
 }
 
-void Merger::eraseCollection(const char* title)
+TObject* Merger::countMergedObject(Destination& destination)
 {
-  auto foundCollection = mTitlesToDataObjectsMap.find(title);
-  foundCollection->second->Delete();
-  delete foundCollection->second;
-  mTitlesToDataObjectsMap.erase(foundCollection);
+  if (++destination.numberOfMergedObjects < NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA) {
+    return nullptr;
+  }
+  TObject* output = destination.object;
+  destination.object = nullptr;
+  destination.numberOfMergedObjects = 0;
+  return output;
 }
 
-void Merger::dumpObjectsCollectionToFile(const char* title)
+void Merger::mergeIntoDestination(TObject* destination, TObject* object)
 {
-  auto foundCollection = mTitlesToDataObjectsMap.find(title);
+  auto measureTime = chrono::high_resolution_clock::now();
+
+  auto destinationHistogram = dynamic_cast<TH1*>(destination);
+  auto histogram = dynamic_cast<TH1*>(object);
+  if (destinationHistogram == nullptr || histogram == nullptr || !addHistogramBins(destinationHistogram, histogram)) {
+    ROOT::MergeFunc_t merge = destination->IsA()->GetMerge();
+    if (merge != nullptr) {
+      TList mergeList;
+      mergeList.Add(object);
+      merge(destination, &mergeList, nullptr);
+    } else {
+      LOG(ERROR) << "Object with type " << destination->ClassName() << " is not one of mergable type.";
+    }
+  }
+  delete object;
 
-  ostringstream fileName;
-  fileName << ++mNumberOfDumpedObjects << "_" << title << ".root";
-  foundCollection->second->SaveAs(fileName.str().c_str());
-  foundCollection->second->Delete();
-  delete foundCollection->second;
-  mTitlesToDataObjectsMap.erase(foundCollection);
+  recordMergeTime(destination->ClassName(), measureTime);
 }
 
-TObject* Merger::mergeObjectWithGivenCollection(TObject* mergedObject)
+void Merger::recordMergeTime(const char* type, chrono::high_resolution_clock::time_point start)
 {
-  TCollection* mergeList = mTitlesToDataObjectsMap.find(mergedObject->GetTitle())->second;
+  auto mergeTime = chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - start);
 
-  TObject* result = nullptr;
-  TH1F* histogram1F = nullptr;
-  TH2F* histogram2F = nullptr;
-  TH3F* histogram3F = nullptr;
-  THnF* histogramNF = nullptr;
-  TTree* tree = nullptr;
-  const char* className = mergedObject->ClassName();
+  lock_guard<mutex> lock(mLatencyMutex);
+  mMergeTime = mergeTime;
+  MergeLatency& latency = mMergeLatencies[type];
+  latency.count++;
+  latency.total += mergeTime.count() / 1000.0;
+  latency.maximum = max(latency.maximum, mergeTime.count() / 1000.0);
+}
 
-  auto measureTime = chrono::high_resolution_clock::now();
+void Merger::mergeObjectAsync(TObject* object) { queue(QueuedObject{ object, nullptr }); }
 
-  if (strcmp(className, "TH1F") == 0) {
-    histogram1F = reinterpret_cast<TH1F*>(mergedObject);
-    histogram1F->Merge(mergeList);
-    result = histogram1F;
-  } else if (strcmp(className, "TH2F") == 0) {
-    histogram2F = reinterpret_cast<TH2F*>(mergedObject);
-    histogram2F->Merge(mergeList);
-    result = histogram2F;
-  } else if (strcmp(className, "TH3F") == 0) {
-    histogram3F = reinterpret_cast<TH3F*>(mergedObject);
-    histogram3F->Merge(mergeList);
-    result = histogram3F;
-  } else if (strcmp(className, "THnT<float>") == 0) {
-    histogramNF = reinterpret_cast<THnF*>(mergedObject);
-    histogramNF->Merge(mergeList);
-    result = histogramNF;
-  } else if (strcmp(className, "TTree") == 0) {
-    tree = reinterpret_cast<TTree*>(mergedObject);
-    tree->Merge(mergeList);
-    result = tree;
-  } else {
-    LOG(ERROR) << "Object with type " << className << " is not one of mergable type.";
+void Merger::mergeUpdateAsync(HistogramUpdate update)
+{
+  queue(QueuedObject{ nullptr, unique_ptr<HistogramUpdate>(new HistogramUpdate(move(update))) });
+}
+
+void Merger::queue(QueuedObject object)
+{
+  if (mWorkers.empty()) {
+    mergeQueuedObject(object);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(mQueueMutex);
+    mQueue.push_back(move(object));
+  }
+  mQueueCondition.notify_one();
+}
+
+void Merger::runWorker()
+{
+  while (true) {
+    unique_lock<mutex> lock(mQueueMutex);
+    mQueueCondition.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+    if (mQueue.empty()) {
+      return;
+    }
+    QueuedObject object = move(mQueue.front());
+    mQueue.pop_front();
+    lock.unlock();
+
+    mergeQueuedObject(object);
+  }
+}
+
+void Merger::mergeQueuedObject(QueuedObject& object)
+{
+  TObject* mergedObject = object.update ? mergeUpdate(*object.update) : mergeObject(object.object);
+  if (mergedObject != nullptr) {
+    storeMergedObject(mergedObject);
   }
+}
+
+void Merger::storeMergedObject(TObject* mergedObject)
+{
+  lock_guard<mutex> lock(mMergedObjectsMutex);
+  mMergedObjects.push_back(mergedObject);
+}
+
+vector<TObject*> Merger::takeMergedObjects()
+{
+  vector<TObject*> mergedObjects;
+  lock_guard<mutex> lock(mMergedObjectsMutex);
+  mergedObjects.swap(mMergedObjects);
+  return mergedObjects;
+}
+
+void Merger::eraseCollection(const char* title)
+{
+  Destination& destination = getDestination(title);
+  lock_guard<mutex> lock(destination.mutex);
+  delete destination.object;
+  destination.object = nullptr;
+  destination.numberOfMergedObjects = 0;
+}
 
-  mMergeTime = chrono::duration_cast<std::chrono::microseconds>(chrono::high_resolution_clock::now() - measureTime);
+void Merger::dumpObjectsCollectionToFile(const char* title)
+{
+  Destination& destination = getDestination(title);
+  lock_guard<mutex> lock(destination.mutex);
 
-  return mergedObject;
+  if (destination.object != nullptr) {
+    ostringstream fileName;
+    fileName << ++mNumberOfDumpedObjects << "_" << title << ".root";
+    destination.object->SaveAs(fileName.str().c_str());
+  }
+  delete destination.object;
+  destination.object = nullptr;
+  destination.numberOfMergedObjects = 0;
 }
 
 double Merger::getMergeTime()
 {
+  lock_guard<mutex> lock(mLatencyMutex);
   return mMergeTime.count() / 1000.0; // in miliseconds
 }
 
+unordered_map<string, MergeLatency> Merger::getMergeLatencies()
+{
+  lock_guard<mutex> lock(mLatencyMutex);
+  return mMergeLatencies;
+}
+
 Merger::~Merger()
 {
-  for (auto const& entry : mTitlesToDataObjectsMap) {
-    entry.second->Delete();
+  {
+    lock_guard<mutex> lock(mQueueMutex);
+    mStopping = true;
+  }
+  mQueueCondition.notify_all();
+  for (auto& worker : mWorkers) {
+    worker.join();
+  }
+
+  for (auto const& entry : mDestinations) {
+    delete entry.second->object;
+  }
+  for (TObject* mergedObject : mMergedObjects) {
+    delete mergedObject;
   }
 }
 }
@@ -16,6 +16,7 @@
 #include <boost/property_tree/json_parser.hpp>
 
 #include <FairMQLogger.h>
+#include <TH1.h>
 
 #include <dds_intercom.h>
 
@@ -149,6 +150,14 @@ boost::property_tree::ptree MergerDevice::createGetMetricsResponse(const ptree&
   response.put("cpu_clock", calculateCpuUsage());
   response.put("merged_objects_per_second", calculateNumberOfMergedObjectsPerSecond());
 
+  for (auto const& latency : mMerger->getMergeLatencies()) {
+    ptree typeLatency;
+    typeLatency.put("count", latency.second.count);
+    typeLatency.put("average", latency.second.average());
+    typeLatency.put("maximum", latency.second.maximum);
+    response.put_child("merge_latency." + latency.first, typeLatency);
+  }
+
   mInternalMetricMessageId++;
 
   return response;
@@ -171,17 +180,36 @@ void MergerDevice::Run()
 
 void MergerDevice::handleReceivedDataObject()
 {
-  TObject* receivedObject = receiveDataObjectFromProducer();
+  unique_ptr<FairMQMessage> input = receiveMessageFromProducer();
 
-  if (isObjectNotEmpty(receivedObject)) {
-    TObject* mergedObject = mMerger->mergeObject(receivedObject);
-
-    if (isObjectNotEmpty(mergedObject)) {
-      updateMetrics();
-      size_t messageSize = sendMergedObjectToViewer(mergedObject);
-      delete mergedObject;
+  if (input != nullptr && isHistogramUpdate(input->GetData(), input->GetSize())) {
+    try {
+      mMerger->mergeUpdateAsync(decodeHistogramUpdate(static_cast<char*>(input->GetData()), input->GetSize()));
+    } catch (const runtime_error& error) {
+      LOG(ERROR) << "Invalid histogram update received: " << error.what();
+    }
+  } else if (input != nullptr) {
+    TMessageWrapper message(input->GetData(), input->GetSize());
+    auto receivedObject = reinterpret_cast<TObject*>(message.ReadObject(message.GetClass()));
+    // The objects are deleted by the merge threads, they must not be registered in gDirectory
+    if (auto histogram = dynamic_cast<TH1*>(receivedObject)) {
+      histogram->SetDirectory(nullptr);
+    }
+    if (isObjectNotEmpty(receivedObject)) {
+      mMerger->mergeObjectAsync(receivedObject);
     }
   }
+
+  sendMergedObjects();
+}
+
+void MergerDevice::sendMergedObjects()
+{
+  for (TObject* mergedObject : mMerger->takeMergedObjects()) {
+    updateMetrics();
+    sendMergedObjectToViewer(mergedObject);
+    delete mergedObject;
+  }
 }
 
 bool MergerDevice::isObjectNotEmpty(const TObject* object) const { return object == nullptr ? false : true; }
@@ -203,10 +231,9 @@ TMessage* MergerDevice::createTMessageForViewer(const TObject* objectToSend) con
   return viewerMessage;
 }
 
-TObject* MergerDevice::receiveDataObjectFromProducer()
+unique_ptr<FairMQMessage> MergerDevice::receiveMessageFromProducer()
 {
   int respondeCode;
-  TObject* receivedDataObject;
   unique_ptr<FairMQMessage> input(NewMessage());
 
   if ((respondeCode = fChannels.at("data-in").at(0).ReceiveAsync(input)) == -2) {
@@ -216,6 +243,8 @@ TObject* MergerDevice::receiveDataObjectFromProducer()
       LOG(DEBUG) << "Buffer of data-in channel is full. Waiting for free buffer...";
 
       while ((respondeCode = fChannels.at("data-in").at(0).ReceiveAsync(input)) == -2) {
+        // the objects merged by the threads meanwhile don't wait for the next input
+        sendMergedObjects();
         this_thread::sleep_for(chrono::milliseconds(10));
       }
 
@@ -225,24 +254,36 @@ TObject* MergerDevice::receiveDataObjectFromProducer()
     }
   }
 
-  if (respondeCode >= 0) {
-    TMessage* message = new TMessageWrapper(input->GetData(), input->GetSize());
-    receivedDataObject = reinterpret_cast<TObject*>(message->ReadObject(message->GetClass()));
-    delete message;
-  } else {
+  if (respondeCode < 0) {
     LOG(ERROR) << "Received empty message from producer, nothing to merge";
-    receivedDataObject = nullptr;
+    return nullptr;
   }
 
-  return receivedDataObject;
+  return input;
 }
 
 size_t MergerDevice::sendMergedObjectToViewer(TObject* dataObject)
 {
   int respondeCode;
-  TMessage* viewerMessage = createTMessageForViewer(dataObject);
-  unique_ptr<FairMQMessage> viewerRequest(fTransportFactory->CreateMessage(
-    viewerMessage->Buffer(), viewerMessage->BufferSize(), deleteTMessage, viewerMessage));
+  unique_ptr<FairMQMessage> viewerRequest;
+  const string title = dataObject->GetTitle();
+  const bool updatable = canBeUpdated(dataObject);
+  auto viewerHistogram = updatable ? mViewerHistograms.find(title) : mViewerHistograms.end();
+  const bool sendUpdate = viewerHistogram != mViewerHistograms.end() &&
+                          viewerHistogram->second.updatesSinceFullObject < UPDATES_BETWEEN_FULL_OBJECTS &&
+                          viewerHistogram->second.reference.contents.size() == HistogramBins(dataObject).size();
+
+  if (sendUpdate) {
+    // The viewer has the previous histogram with this title, only the bins which changed are sent
+    auto* update = new vector<char>(
+      encodeHistogramUpdate(dataObject, HistogramUpdateMode::Replace, true, &viewerHistogram->second.reference));
+    viewerRequest = unique_ptr<FairMQMessage>(
+      fTransportFactory->CreateMessage(update->data(), update->size(), deleteHistogramUpdateBuffer, update));
+  } else {
+    TMessage* viewerMessage = createTMessageForViewer(dataObject);
+    viewerRequest = unique_ptr<FairMQMessage>(fTransportFactory->CreateMessage(
+      viewerMessage->Buffer(), viewerMessage->BufferSize(), deleteTMessage, viewerMessage));
+  }
   size_t messageSize = viewerRequest->GetSize();
   if ((respondeCode = fChannels.at("data-out").at(0).SendAsync(viewerRequest)) == -2) {
     if ((respondeCode = fChannels.at("data-out").at(0).SendAsync(viewerRequest)) == -2) {
@@ -260,6 +301,16 @@ size_t MergerDevice::sendMergedObjectToViewer(TObject* dataObject)
     }
   }
 
+  if (respondeCode < 0) {
+    // What the viewer has is not known anymore, the next object with this title is sent whole
+    LOG(ERROR) << "Could not send " << title << " to the viewer";
+    mViewerHistograms.erase(title);
+  } else if (updatable) {
+    ViewerHistogram& sentHistogram = mViewerHistograms[title];
+    sentHistogram.updatesSinceFullObject = sendUpdate ? sentHistogram.updatesSinceFullObject + 1 : 0;
+    setHistogramReference(dataObject, sentHistogram.reference);
+  }
+
   return messageSize;
 }
 
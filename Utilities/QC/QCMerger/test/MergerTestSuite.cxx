@@ -12,7 +12,11 @@
 #define BOOST_TEST_MAIN
 
 #include <TH1F.h>
+#include <TH2D.h>
+#include <TRandom.h>
 #include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -20,6 +24,7 @@
 #include "QCMerger/MergerDevice.h"
 
 using namespace std;
+using namespace o2::qc;
 
 namespace
 {
@@ -31,6 +36,23 @@ const int NUMBER_OF_BINS = 100;
 const int NUMBER_OF_ENTRIES = 100;
 const double X_LOW = -10.0;
 const double X_UP = 10.0;
+const auto MERGE_TIMEOUT = chrono::seconds(10);
+
+// Checks that the histogram merged by the merger is the same as the one computed by TH1::Add
+template <typename Histogram>
+void checkSameAsAdd(const Histogram& merged, const Histogram& expected)
+{
+  BOOST_REQUIRE(merged.GetNcells() == expected.GetNcells());
+  for (int bin = 0; bin < expected.GetNcells(); ++bin) {
+    BOOST_CHECK_CLOSE(merged.GetBinContent(bin), expected.GetBinContent(bin), 1e-6);
+    BOOST_CHECK_CLOSE(merged.GetBinError(bin), expected.GetBinError(bin), 1e-6);
+  }
+  BOOST_CHECK_CLOSE(merged.GetEntries(), expected.GetEntries(), 1e-6);
+  for (int axis = 1; axis <= merged.GetDimension(); ++axis) {
+    BOOST_CHECK_CLOSE(merged.GetMean(axis), expected.GetMean(axis), 1e-6);
+    BOOST_CHECK_CLOSE(merged.GetRMS(axis), expected.GetRMS(axis), 1e-6);
+  }
+}
 }
 
 BOOST_AUTO_TEST_SUITE(MergerTestSuite)
@@ -63,4 +85,246 @@ BOOST_AUTO_TEST_CASE(mergeTenHistograms)
   }
 }
 
+BOOST_AUTO_TEST_CASE(mergeHistogramsOnThreads)
+{
+  const unsigned HISTOGRAMS_TO_TEST = 8;
+  const char* TITLES[] = { "FIRST_TITLE", "SECOND_TITLE" };
+  unique_ptr<Merger> merger(new Merger(NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA, 2));
+
+  for (int i = 0; i < HISTOGRAMS_TO_TEST; ++i) {
+    TH1F* histogram = new TH1F(HISTOGRAM_NAME, TITLES[i % 2], NUMBER_OF_BINS, X_LOW, X_UP);
+    // Deleted by the merge threads, so not registered in gDirectory
+    histogram->SetDirectory(nullptr);
+    histogram->FillRandom(RANDOM_GENERATION_TYPE, NUMBER_OF_ENTRIES);
+    merger->mergeObjectAsync(histogram);
+  }
+
+  vector<TObject*> mergedObjects;
+  auto deadline = chrono::steady_clock::now() + MERGE_TIMEOUT;
+  while (mergedObjects.size() < HISTOGRAMS_TO_TEST / NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA) {
+    BOOST_REQUIRE_MESSAGE(chrono::steady_clock::now() < deadline, "Merged objects not received in time");
+    for (TObject* mergedObject : merger->takeMergedObjects()) {
+      mergedObjects.push_back(mergedObject);
+    }
+  }
+
+  for (TObject* mergedObject : mergedObjects) {
+    BOOST_TEST(reinterpret_cast<TH1F*>(mergedObject)->GetEntries() ==
+               (NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA * NUMBER_OF_ENTRIES));
+    delete mergedObject;
+  }
+  BOOST_TEST(merger->getMergeLatencies().at("TH1F").count ==
+             HISTOGRAMS_TO_TEST / NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA);
+}
+
+BOOST_AUTO_TEST_CASE(mergeHistogramBinsAsAdd)
+{
+  unique_ptr<Merger> merger(new Merger(NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA));
+
+  auto first = new TH1F(HISTOGRAM_NAME, HISTOGRAM_TITLE, NUMBER_OF_BINS, X_LOW, X_UP);
+  auto second = new TH1F(HISTOGRAM_NAME, HISTOGRAM_TITLE, NUMBER_OF_BINS, X_LOW, X_UP);
+  for (auto histogram : { first, second }) {
+    histogram->SetDirectory(nullptr);
+    histogram->Sumw2();
+    for (int i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+      histogram->Fill(gRandom->Gaus(0., 3.), gRandom->Uniform(0.5, 2.));
+    }
+  }
+  TH1F expected(*first);
+  expected.SetDirectory(nullptr);
+  expected.Add(second);
+
+  BOOST_CHECK(merger->mergeObject(first) == nullptr);
+  unique_ptr<TObject> merged(merger->mergeObject(second));
+  BOOST_REQUIRE(merged != nullptr);
+  checkSameAsAdd(dynamic_cast<TH1F&>(*merged), expected);
+}
+
+BOOST_AUTO_TEST_CASE(mergeTwoDimensionalHistogramBinsAsAdd)
+{
+  unique_ptr<Merger> merger(new Merger(NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA));
+
+  auto first = new TH2D(HISTOGRAM_NAME, HISTOGRAM_TITLE, 20, X_LOW, X_UP, 10, X_LOW, X_UP);
+  auto second = new TH2D(HISTOGRAM_NAME, HISTOGRAM_TITLE, 20, X_LOW, X_UP, 10, X_LOW, X_UP);
+  for (auto histogram : { first, second }) {
+    histogram->SetDirectory(nullptr);
+    for (int i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+      histogram->Fill(gRandom->Gaus(0., 3.), gRandom->Gaus(0., 3.));
+    }
+  }
+  TH2D expected(*first);
+  expected.SetDirectory(nullptr);
+  expected.Add(second);
+
+  BOOST_CHECK(merger->mergeObject(first) == nullptr);
+  unique_ptr<TObject> merged(merger->mergeObject(second));
+  BOOST_REQUIRE(merged != nullptr);
+  checkSameAsAdd(dynamic_cast<TH2D&>(*merged), expected);
+}
+
+namespace
+{
+TH1F* createFilledHistogram(int numberOfBins = NUMBER_OF_BINS, int numberOfEntries = NUMBER_OF_ENTRIES)
+{
+  auto histogram = new TH1F(HISTOGRAM_NAME, HISTOGRAM_TITLE, numberOfBins, X_LOW, X_UP);
+  histogram->SetDirectory(nullptr);
+  histogram->Sumw2();
+  for (int i = 0; i < numberOfEntries; ++i) {
+    histogram->Fill(gRandom->Gaus(0., 3.), gRandom->Uniform(0.5, 2.));
+  }
+  return histogram;
+}
+
+TH1F* createEmptyCopy(const TH1F& histogram)
+{
+  auto copy = new TH1F(histogram);
+  copy->SetDirectory(nullptr);
+  copy->Reset();
+  return copy;
+}
+
+void checkSameBins(const TH1F& updated, const TH1F& expected)
+{
+  BOOST_REQUIRE(updated.GetNcells() == expected.GetNcells());
+  for (int bin = 0; bin < expected.GetNcells(); ++bin) {
+    BOOST_CHECK_CLOSE(updated.GetBinContent(bin), expected.GetBinContent(bin), 1e-4);
+    BOOST_CHECK_CLOSE(updated.GetSumw2()->At(bin), expected.GetSumw2()->At(bin), 1e-4);
+  }
+  BOOST_CHECK_EQUAL(updated.GetEntries(), expected.GetEntries());
+  BOOST_CHECK_CLOSE(updated.GetMean(), expected.GetMean(), 1e-6);
+  BOOST_CHECK_CLOSE(updated.GetRMS(), expected.GetRMS(), 1e-6);
+}
+
+HistogramUpdate roundTrip(TH1F* histogram, HistogramUpdateMode mode, bool compress,
+                          const HistogramReference* reference = nullptr)
+{
+  vector<char> buffer = encodeHistogramUpdate(histogram, mode, compress, reference);
+  BOOST_REQUIRE(isHistogramUpdate(buffer.data(), buffer.size()));
+  return decodeHistogramUpdate(buffer.data(), buffer.size());
+}
+}
+
+BOOST_AUTO_TEST_CASE(histogramUpdateRoundTrip)
+{
+  for (bool compress : { false, true }) {
+    BOOST_TEST_CONTEXT("compress " << compress)
+    {
+      unique_ptr<TH1F> previous(createFilledHistogram());
+      HistogramReference reference;
+      setHistogramReference(previous.get(), reference);
+      unique_ptr<TH1F> current(new TH1F(*previous));
+      current->SetDirectory(nullptr);
+      for (int i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+        current->Fill(gRandom->Gaus(0., 3.), gRandom->Uniform(0.5, 2.));
+      }
+
+      // Without reference, the update of an empty histogram gives the histogram
+      unique_ptr<TH1F> fromEmpty(createEmptyCopy(*current));
+      BOOST_CHECK(applyHistogramUpdate(fromEmpty.get(), roundTrip(current.get(), HistogramUpdateMode::Add, compress)));
+      checkSameBins(*fromEmpty, *current);
+
+      // An Add update carries the differences to the reference
+      unique_ptr<TH1F> added(new TH1F(*previous));
+      added->SetDirectory(nullptr);
+      HistogramUpdate addUpdate = roundTrip(current.get(), HistogramUpdateMode::Add, compress, &reference);
+      BOOST_CHECK(applyHistogramUpdate(added.get(), addUpdate));
+      checkSameBins(*added, *current);
+
+      // A Replace update carries the values which changed since the reference
+      unique_ptr<TH1F> replaced(new TH1F(*previous));
+      replaced->SetDirectory(nullptr);
+      HistogramUpdate replaceUpdate = roundTrip(current.get(), HistogramUpdateMode::Replace, compress, &reference);
+      BOOST_CHECK(replaceUpdate.bins.size() < static_cast<size_t>(current->GetNcells()));
+      BOOST_CHECK(applyHistogramUpdate(replaced.get(), replaceUpdate));
+      checkSameBins(*replaced, *current);
+
+      // The encoding leaves the reference to the caller
+      BOOST_CHECK_EQUAL(reference.entries, previous->GetEntries());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogramUpdateOfAnotherBinning)
+{
+  unique_ptr<TH1F> source(createFilledHistogram(NUMBER_OF_BINS));
+  unique_ptr<TH1F> destination(createFilledHistogram(NUMBER_OF_BINS / 2));
+  unique_ptr<TH1F> expected(new TH1F(*destination));
+  expected->SetDirectory(nullptr);
+
+  for (auto mode : { HistogramUpdateMode::Add, HistogramUpdateMode::Replace }) {
+    BOOST_CHECK(!applyHistogramUpdate(destination.get(), roundTrip(source.get(), mode, true)));
+    checkSameBins(*destination, *expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(invalidHistogramUpdates)
+{
+  unique_ptr<TH1F> histogram(createFilledHistogram());
+
+  for (bool compress : { false, true }) {
+    vector<char> buffer = encodeHistogramUpdate(histogram.get(), HistogramUpdateMode::Add, compress);
+
+    // Every truncated buffer is rejected, each one is copied to a buffer of its size to catch reads out of it
+    for (size_t size = 0; size < buffer.size(); ++size) {
+      vector<char> truncated(buffer.begin(), buffer.begin() + size);
+      BOOST_CHECK_THROW(decodeHistogramUpdate(truncated.data(), truncated.size()), runtime_error);
+    }
+
+    vector<char> corrupt(buffer);
+    corrupt[0] ^= 0xff;
+    BOOST_CHECK(!isHistogramUpdate(corrupt.data(), corrupt.size()));
+    BOOST_CHECK_THROW(decodeHistogramUpdate(corrupt.data(), corrupt.size()), runtime_error);
+
+    // More changed bins than the histogram has
+    HistogramUpdateHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    header.numberOfChangedBins = header.numberOfBins + 1;
+    corrupt = buffer;
+    memcpy(corrupt.data(), &header, sizeof(header));
+    BOOST_CHECK_THROW(decodeHistogramUpdate(corrupt.data(), corrupt.size()), runtime_error);
+
+    // A bin index out of the histogram
+    memcpy(&header, buffer.data(), sizeof(header));
+    header.numberOfBins = 1;
+    header.numberOfChangedBins = 1;
+    corrupt = buffer;
+    memcpy(corrupt.data(), &header, sizeof(header));
+    size_t firstIndex = sizeof(header) + header.titleSize;
+    if (compress) {
+      corrupt[firstIndex] = 5;
+    } else {
+      uint64_t bin = 5;
+      memcpy(corrupt.data() + firstIndex, &bin, sizeof(bin));
+    }
+    BOOST_CHECK_THROW(decodeHistogramUpdate(corrupt.data(), corrupt.size()), runtime_error);
+  }
+
+  // An update inconsistent with its number of bins is not applied
+  HistogramUpdate update = roundTrip(histogram.get(), HistogramUpdateMode::Add, true);
+  update.contents.pop_back();
+  unique_ptr<TH1F> destination(createEmptyCopy(*histogram));
+  BOOST_CHECK(!applyHistogramUpdate(destination.get(), update));
+}
+
+BOOST_AUTO_TEST_CASE(mergeUpdateBeforeHistogram)
+{
+  unique_ptr<Merger> merger(new Merger(NUMBER_OF_QC_OBJECTS_FOR_COMPLETE_DATA));
+  TH1F* first = createFilledHistogram();
+  unique_ptr<TH1F> second(createFilledHistogram());
+  TH1F expected(*first);
+  expected.SetDirectory(nullptr);
+  expected.Add(second.get());
+
+  // The update is held until the histogram with its title arrives
+  BOOST_CHECK(merger->mergeUpdate(roundTrip(second.get(), HistogramUpdateMode::Add, true)) == nullptr);
+  BOOST_CHECK(merger->mergeObject(first) == nullptr);
+  vector<TObject*> mergedObjects = merger->takeMergedObjects();
+  BOOST_REQUIRE(mergedObjects.size() == 1);
+  unique_ptr<TObject> merged(mergedObjects.front());
+  BOOST_CHECK_EQUAL(dynamic_cast<TH1F&>(*merged).GetEntries(), expected.GetEntries());
+  for (int bin = 0; bin < expected.GetNcells(); ++bin) {
+    BOOST_CHECK_CLOSE(dynamic_cast<TH1F&>(*merged).GetBinContent(bin), expected.GetBinContent(bin), 1e-4);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
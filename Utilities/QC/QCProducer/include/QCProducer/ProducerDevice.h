@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <FairMQDevice.h>
 
@@ -33,6 +34,15 @@ class ProducerDevice : public FairMQDevice
   void executeRunLoop();
   void establishChannel(std::string type, std::string method, std::string address, std::string channelName,
                         const int bufferSize);
+  /// Once a histogram with the same title was sent, send only its filled bins as a HistogramUpdate, optionally
+  /// compressed. Enabled by default. The whole histogram is still sent after each @a updatesBetweenFullObjects
+  /// updates, so that a restarted merger gets the histograms again.
+  void setHistogramUpdates(bool send, bool compress, unsigned int updatesBetweenFullObjects = 100)
+  {
+    mSendHistogramUpdates = send;
+    mCompressHistogramUpdates = compress;
+    mUpdatesBetweenFullObjects = updatesBetweenFullObjects;
+  }
 
  protected:
   ProducerDevice() = default;
@@ -44,6 +54,11 @@ class ProducerDevice : public FairMQDevice
   std::unique_ptr<dds::intercom_api::CCustomCmd> ddsCustomCmd;
   int mNumberOfEntries;
 
+  bool mSendHistogramUpdates{ true };
+  bool mCompressHistogramUpdates{ true };
+  unsigned int mUpdatesBetweenFullObjects{ 100 };
+  std::unordered_map<std::string, unsigned int> mUpdatesSinceFullObject; // by title
+
   volatile bool mBufferOverloaded{ false };
   clock_t mLastBufferOverloadTime{ 0 };
 
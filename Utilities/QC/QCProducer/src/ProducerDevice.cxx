@@ -19,6 +19,7 @@
 #include <FairMQLogger.h>
 #include <TMessage.h>
 
+#include "QCCommon/HistogramUpdate.h"
 #include "QCProducer/ProducerDevice.h"
 
 using namespace std;
@@ -43,10 +44,24 @@ void ProducerDevice::Run()
 {
   while (CheckCurrentState(RUNNING)) {
     TObject* newDataObject = mProducer->produceData();
-    auto* message = new TMessage(kMESS_OBJECT);
-    message->WriteObject(newDataObject);
-
-    unique_ptr<FairMQMessage> request(NewMessage(message->Buffer(), message->BufferSize(), deleteTMessage, message));
+    unique_ptr<FairMQMessage> request;
+
+    auto updates = mUpdatesSinceFullObject.find(newDataObject->GetTitle());
+    if (mSendHistogramUpdates && canBeUpdated(newDataObject) && updates != mUpdatesSinceFullObject.end() &&
+        updates->second < mUpdatesBetweenFullObjects) {
+      // The merger has a histogram with this title already, only the filled bins are sent
+      updates->second++;
+      auto* update =
+        new vector<char>(encodeHistogramUpdate(newDataObject, HistogramUpdateMode::Add, mCompressHistogramUpdates));
+      request =
+        unique_ptr<FairMQMessage>(NewMessage(update->data(), update->size(), deleteHistogramUpdateBuffer, update));
+    } else {
+      auto* message = new TMessage(kMESS_OBJECT);
+      message->WriteObject(newDataObject);
+      request =
+        unique_ptr<FairMQMessage>(NewMessage(message->Buffer(), message->BufferSize(), deleteTMessage, message));
+      mUpdatesSinceFullObject[newDataObject->GetTitle()] = 0;
+    }
 
     if (outputLimitReached()) {
       waitForLimitUnlock();
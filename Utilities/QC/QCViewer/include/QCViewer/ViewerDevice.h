@@ -38,9 +38,12 @@ class ViewerDevice : public FairMQDevice
 
  private:
   std::unordered_map<std::string, std::shared_ptr<TCanvas>> objectsToDraw;
+  // The last object received with each title, kept to apply the histogram updates
+  std::unordered_map<std::string, std::unique_ptr<TObject>> mReceivedObjects;
   std::string mDrawingOptions;
 
   std::unique_ptr<FairMQMessage> receiveMessageFromMerger();
+  /// @return the received object, owned by the device, or nullptr
   TObject* receiveDataObjectFromMerger();
   void updateCanvas(TObject* receivedObject);
 
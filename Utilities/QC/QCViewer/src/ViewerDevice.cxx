@@ -15,6 +15,7 @@
 #include <FairMQLogger.h>
 #include <TSystem.h>
 
+#include "QCCommon/HistogramUpdate.h"
 #include "QCCommon/TMessageWrapper.h"
 #include "QCViewer/ViewerDevice.h"
 
@@ -41,8 +42,6 @@ void ViewerDevice::Run()
       // updateCanvas(receivedObject); // Visualization is disabled because there was no support of X11 protocol on the
       // previous testing environment
     }
-
-    delete receivedObject;
   }
 }
 
@@ -70,11 +69,31 @@ TObject* ViewerDevice::receiveDataObjectFromMerger()
   TObject* receivedObject;
   unique_ptr<FairMQMessage> request(NewMessage());
 
-  if (fChannels.at("data-in").at(0).ReceiveAsync(request) >= 0) {
+  if (fChannels.at("data-in").at(0).ReceiveAsync(request) < 0) {
+    return nullptr;
+  }
+
+  if (isHistogramUpdate(request->GetData(), request->GetSize())) {
+    // The changed bins of a histogram received before, updated in place
+    try {
+      HistogramUpdate update = decodeHistogramUpdate(static_cast<char*>(request->GetData()), request->GetSize());
+      auto receivedHistogram = mReceivedObjects.find(update.title);
+      if (receivedHistogram == mReceivedObjects.end() ||
+          !applyHistogramUpdate(receivedHistogram->second.get(), update)) {
+        LOG(ERROR) << "Update of " << update.title << " does not match any received histogram, dropped.";
+        return nullptr;
+      }
+      receivedObject = receivedHistogram->second.get();
+    } catch (const runtime_error& error) {
+      LOG(ERROR) << "Invalid histogram update received: " << error.what();
+      return nullptr;
+    }
+  } else {
     TMessageWrapper tm(request->GetData(), request->GetSize());
     receivedObject = static_cast<TObject*>(tm.ReadObject(tm.GetClass()));
-  } else {
-    receivedObject = nullptr;
+    if (receivedObject != nullptr) {
+      mReceivedObjects[receivedObject->GetTitle()].reset(receivedObject);
+    }
   }
 
   return receivedObject;
@@ -1145,6 +1145,16 @@ o2_define_bucket(
     ${MS_GSL_INCLUDE_DIR}
 )
 
+o2_define_bucket(
+    NAME
+    tof_simulation_test_bucket
+
+    DEPENDENCIES
+    $<IF:$<BOOL:${benchmark_FOUND}>,benchmark::benchmark,$<0:"">>
+    tof_simulation_bucket
+    TOFSimulation
+)
+
 o2_define_bucket(
     NAME
     fit_base_bucket
@@ -1683,7 +1693,9 @@ o2_define_bucket(
     Boost::unit_test_framework
     $<IF:$<BOOL:${benchmark_FOUND}>,benchmark::benchmark,$<0:"">>
     mid_clustering_bucket
+    mid_testingSimTools_bucket
     MIDClustering
+    MIDTestingSimTools
 
     INCLUDE_DIRECTORIES
     ${CMAKE_SOURCE_DIR}/Detectors/MUON/MID/Clustering/src